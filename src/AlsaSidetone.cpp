@@ -0,0 +1,269 @@
+#include "AlsaSidetone.h"
+#include "core/Trace.h"
+#include <QDebug>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+
+#ifdef HAVE_ALSA
+#include <alsa/asoundlib.h>
+#endif
+
+namespace {
+constexpr double TWO_PI = 6.283185307179586;
+constexpr int WAIT_TIMEOUT_MS = 100;
+
+qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+AlsaSidetone::AlsaSidetone(QObject *parent)
+    : QThread(parent)
+    , m_pcm(nullptr)
+    , m_mmap(false)
+    , m_channels(1)
+    , m_sampleRate(48000)
+    , m_periodFrames(64)
+    , m_bufferFrames(128)
+    , m_running(false)
+    , m_active(false)
+    , m_edgeNs(0)
+    , m_frequency(600)
+    , m_volume(0.5f)
+    , m_xruns(0)
+    , m_phase(0.0)
+    , m_envelope(0.0f)
+    , m_wasActive(false)
+{
+}
+
+AlsaSidetone::~AlsaSidetone()
+{
+    close();
+}
+
+bool AlsaSidetone::isAvailable()
+{
+#ifdef HAVE_ALSA
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AlsaSidetone::open(const AlsaSidetoneConfig& config, const RealtimeConfig& realtime, QString *error)
+{
+    close();
+#ifdef HAVE_ALSA
+    QByteArray device = config.pipewire ? QByteArray("pipewire") : config.device.toLocal8Bit();
+    if (config.pipewire) {
+        // The PipeWire ALSA plugin takes its quantum from the environment
+        QByteArray quantum = QByteArray::number(config.periodFrames) + "/" + QByteArray::number(config.sampleRate);
+        qputenv("PIPEWIRE_LATENCY", quantum);
+    }
+
+    snd_pcm_t *pcm = nullptr;
+    int err = snd_pcm_open(&pcm, device.constData(), SND_PCM_STREAM_PLAYBACK, 0);
+    auto fail = [&](const char *step) {
+        if (error) *error = QString("%1: %2").arg(step, snd_strerror(err));
+        if (pcm) snd_pcm_close(pcm);
+        return false;
+    };
+    if (err < 0) return fail("snd_pcm_open");
+
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_hw_params_alloca(&hw);
+    if ((err = snd_pcm_hw_params_any(pcm, hw)) < 0) return fail("hw_params_any");
+
+    // mmap lets the period be rendered in place; plugins without it get writei
+    m_mmap = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!m_mmap && (err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+        return fail("set_access");
+    }
+    if ((err = snd_pcm_hw_params_set_format(pcm, hw, SND_PCM_FORMAT_S16)) < 0) return fail("set_format");
+
+    unsigned int channels = 1;
+    if ((err = snd_pcm_hw_params_set_channels_near(pcm, hw, &channels)) < 0) return fail("set_channels");
+    unsigned int rate = unsigned(config.sampleRate);
+    if ((err = snd_pcm_hw_params_set_rate_near(pcm, hw, &rate, nullptr)) < 0) return fail("set_rate");
+    snd_pcm_uframes_t period = snd_pcm_uframes_t(config.periodFrames);
+    if ((err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr)) < 0) return fail("set_period_size");
+    snd_pcm_uframes_t buffer = period * snd_pcm_uframes_t(qMax(2, config.periods));
+    if ((err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &buffer)) < 0) return fail("set_buffer_size");
+    if ((err = snd_pcm_hw_params(pcm, hw)) < 0) return fail("hw_params");
+    snd_pcm_hw_params_get_period_size(hw, &period, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hw, &buffer);
+
+    snd_pcm_sw_params_t *sw;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(pcm, sw);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw, period);
+    snd_pcm_sw_params_set_avail_min(pcm, sw, period);
+    if ((err = snd_pcm_sw_params(pcm, sw)) < 0) return fail("sw_params");
+    if ((err = snd_pcm_prepare(pcm)) < 0) return fail("prepare");
+
+    m_pcm = pcm;
+    m_channels = int(channels);
+    m_sampleRate = int(rate);
+    m_periodFrames = int(period);
+    m_bufferFrames = int(buffer);
+    m_buffer.assign(size_t(m_periodFrames) * m_channels, 0);
+    m_description = QString("%1, %2 Hz, %3 x %4 frames, %5")
+                        .arg(QString::fromLocal8Bit(device))
+                        .arg(m_sampleRate)
+                        .arg(m_bufferFrames / m_periodFrames)
+                        .arg(m_periodFrames)
+                        .arg(m_mmap ? "mmap" : "rw");
+
+    m_realtimeConfig = realtime;
+    m_latency.reset();
+    m_xruns = 0;
+    m_phase = 0.0;
+    m_envelope = 0.0f;
+    m_wasActive = false;
+    m_running = true;
+    start();
+    return true;
+#else
+    Q_UNUSED(config);
+    Q_UNUSED(realtime);
+    if (error) *error = "built without ALSA support";
+    return false;
+#endif
+}
+
+void AlsaSidetone::close()
+{
+    if (isRunning()) {
+        m_running = false;
+        wait();
+    }
+#ifdef HAVE_ALSA
+    if (m_pcm) {
+        snd_pcm_t *pcm = static_cast<snd_pcm_t *>(m_pcm);
+        snd_pcm_drop(pcm);
+        snd_pcm_close(pcm);
+        m_pcm = nullptr;
+    }
+#endif
+}
+
+void AlsaSidetone::setActive(bool active, qint64 timestampNs)
+{
+    if (active) {
+        m_edgeNs.store(timestampNs, std::memory_order_relaxed);
+    }
+    m_active.store(active, std::memory_order_release);
+}
+
+qint64 AlsaSidetone::bufferLatencyUs() const
+{
+    return qint64(m_bufferFrames) * 1000000 / m_sampleRate;
+}
+
+RealtimeStatus AlsaSidetone::realtimeStatus() const
+{
+    QMutexLocker lock(&m_statusMutex);
+    return m_realtimeStatus;
+}
+
+void AlsaSidetone::noteToneStart(qint64 queuedFrames)
+{
+    // Time the edge took to reach this thread plus the audio still queued
+    // ahead of the first sample of the tone
+    qint64 edgeNs = m_edgeNs.load(std::memory_order_relaxed);
+    qint64 latencyNs = monotonicNs() - edgeNs + queuedFrames * 1000000000LL / m_sampleRate;
+    m_latency.record(latencyNs);
+}
+
+void AlsaSidetone::render(qint16 *out, int frames, int stride, bool active)
+{
+    const double step = TWO_PI * m_frequency.load(std::memory_order_relaxed) / m_sampleRate;
+    const float amplitude = 32767.0f * m_volume.load(std::memory_order_relaxed);
+    const float ramp = 1000.0f / (RAMP_MS * m_sampleRate);
+    const float target = active ? 1.0f : 0.0f;
+
+    for (int i = 0; i < frames; ++i) {
+        if (m_envelope < target) {
+            m_envelope = qMin(target, m_envelope + ramp);
+        } else if (m_envelope > target) {
+            m_envelope = qMax(target, m_envelope - ramp);
+        }
+        qint16 sample = 0;
+        if (m_envelope > 0.0f) {
+            sample = qint16(std::sin(m_phase) * amplitude * m_envelope);
+            m_phase += step;
+            if (m_phase >= TWO_PI) m_phase -= TWO_PI;
+        } else {
+            m_phase = 0.0; // Every tone starts at a zero crossing
+        }
+        for (int channel = 0; channel < m_channels; ++channel) {
+            out[i * stride + channel] = sample;
+        }
+    }
+}
+
+void AlsaSidetone::run()
+{
+    MORSE_TRACE_THREAD_NAME("sidetone");
+    RealtimeStatus status = RealtimeScheduler::applyToCurrentThread(m_realtimeConfig);
+    {
+        QMutexLocker lock(&m_statusMutex);
+        m_realtimeStatus = status;
+    }
+#ifdef HAVE_ALSA
+    snd_pcm_t *pcm = static_cast<snd_pcm_t *>(m_pcm);
+
+    while (m_running) {
+        int err = snd_pcm_wait(pcm, WAIT_TIMEOUT_MS);
+        snd_pcm_sframes_t avail = err < 0 ? err : snd_pcm_avail_update(pcm);
+        if (avail < 0) {
+            if (avail == -EPIPE) ++m_xruns;
+            if (snd_pcm_recover(pcm, int(avail), 1) < 0) {
+                qWarning() << "Sidetone device failed:" << snd_strerror(int(avail));
+                break;
+            }
+            continue;
+        }
+
+        while (avail >= m_periodFrames && m_running) {
+            bool active = m_active.load(std::memory_order_acquire);
+            if (active && !m_wasActive) {
+                snd_pcm_sframes_t delay = 0;
+                if (snd_pcm_delay(pcm, &delay) < 0) delay = m_bufferFrames - avail;
+                noteToneStart(delay);
+            }
+            m_wasActive = active;
+
+            snd_pcm_sframes_t written;
+            if (m_mmap) {
+                const snd_pcm_channel_area_t *areas;
+                snd_pcm_uframes_t offset;
+                snd_pcm_uframes_t frames = snd_pcm_uframes_t(m_periodFrames);
+                if ((err = snd_pcm_mmap_begin(pcm, &areas, &offset, &frames)) < 0) {
+                    written = err;
+                } else {
+                    const int stride = int(areas[0].step / 16);
+                    qint16 *out = reinterpret_cast<qint16 *>(static_cast<char *>(areas[0].addr)
+                                                             + areas[0].first / 8) + offset * stride;
+                    render(out, int(frames), stride, active);
+                    written = snd_pcm_mmap_commit(pcm, offset, frames);
+                }
+            } else {
+                render(m_buffer.data(), m_periodFrames, m_channels, active);
+                written = snd_pcm_writei(pcm, m_buffer.data(), snd_pcm_uframes_t(m_periodFrames));
+            }
+
+            if (written < 0) {
+                if (written == -EPIPE) ++m_xruns;
+                snd_pcm_recover(pcm, int(written), 1);
+                break;
+            }
+            avail -= written;
+        }
+    }
+#endif
+}
@@ -0,0 +1,85 @@
+#ifndef ALSASIDETONE_H
+#define ALSASIDETONE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <vector>
+#include "RealtimeScheduler.h"
+
+struct AlsaSidetoneConfig {
+    QString device = "default";
+    int sampleRate = 48000;
+    int periodFrames = 64;
+    int periods = 2;
+    // Open PipeWire's ALSA device with a quantum of one period
+    bool pipewire = false;
+};
+
+// Sidetone written straight to an ALSA PCM by a real-time thread. The ring
+// holds only a few small periods (mmap access where the device allows it),
+// so a key edge is audible within a few milliseconds instead of behind Qt
+// Multimedia's buffering. The delay from key edge to sound is measured on
+// every tone start.
+class AlsaSidetone : public QThread {
+    Q_OBJECT
+public:
+    explicit AlsaSidetone(QObject *parent = nullptr);
+    ~AlsaSidetone();
+
+    static bool isAvailable(); // Built with ALSA support
+
+    // Opens the device in the calling thread and starts the audio thread
+    bool open(const AlsaSidetoneConfig& config, const RealtimeConfig& realtime, QString *error = nullptr);
+    void close();
+
+    // Safe from any thread; timestampNs is the key edge (CLOCK_MONOTONIC)
+    void setActive(bool active, qint64 timestampNs);
+    void setFrequency(int frequency) { m_frequency = frequency; }
+    void setVolume(float volume) { m_volume = volume; }
+
+    // Valid after a successful open()
+    QString description() const { return m_description; }
+    qint64 bufferLatencyUs() const;
+    const LatencyStats& latency() const { return m_latency; }
+    RealtimeStatus realtimeStatus() const;
+    quint64 xruns() const { return m_xruns.load(std::memory_order_relaxed); }
+
+protected:
+    void run() override;
+
+private:
+    void render(qint16 *out, int frames, int stride, bool active);
+    void noteToneStart(qint64 queuedFrames);
+
+    static constexpr int RAMP_MS = 2; // Click-free keying
+
+    void *m_pcm; // snd_pcm_t, kept opaque so users do not need the ALSA headers
+    bool m_mmap;
+    int m_channels;
+    int m_sampleRate;
+    int m_periodFrames;
+    int m_bufferFrames;
+    QString m_description;
+    std::vector<qint16> m_buffer; // Period buffer for read/write access
+
+    RealtimeConfig m_realtimeConfig;
+    RealtimeStatus m_realtimeStatus;
+    mutable QMutex m_statusMutex;
+
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_active;
+    std::atomic<qint64> m_edgeNs;
+    std::atomic<int> m_frequency;
+    std::atomic<float> m_volume;
+    std::atomic<quint64> m_xruns;
+    LatencyStats m_latency;
+
+    // Audio thread only
+    double m_phase;
+    float m_envelope;
+    bool m_wasActive;
+};
+
+#endif // ALSASIDETONE_H
@@ -0,0 +1,310 @@
+#include "AudioInput.h"
+#include "core/Trace.h"
+#include <QAudioSource>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+constexpr int PREFERRED_SAMPLE_RATE = 48000;
+constexpr qint64 SOURCE_BUFFER_US = 10000;  // Small device buffer, low latency
+constexpr qint64 READ_BUFFER_US = 100000;
+constexpr int SPECTRUM_POLL_MS = 100;       // Checks for shutdown while idle
+
+// The audio clock and the monotonic clock drift apart; the anchor follows
+// the earliest arrival and is moved forward when it falls this far behind
+constexpr qint64 ANCHOR_SLACK_NS = 10000000;
+
+qint64 monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void wake(int fd) {
+    if (fd < 0) return;
+    uint64_t one = 1;
+    ssize_t written = ::write(fd, &one, sizeof(one));
+    Q_UNUSED(written);
+}
+}
+
+AudioCapture::AudioCapture(AudioInput *input)
+    : QObject(nullptr)
+    , m_input(input)
+    , m_source(nullptr)
+    , m_io(nullptr)
+{
+}
+
+bool AudioCapture::start(const QAudioDevice& device, const QAudioFormat& format) {
+    MORSE_TRACE_THREAD_NAME("audio capture");
+    m_format = format;
+    m_readBuffer.resize(format.bytesForDuration(READ_BUFFER_US));
+    m_samples.assign(size_t(format.framesForDuration(READ_BUFFER_US)), 0.0f);
+
+    m_source = new QAudioSource(device, format, this);
+    m_source->setBufferSize(format.bytesForDuration(SOURCE_BUFFER_US));
+    m_io = m_source->start();
+    if (!m_io) {
+        stop();
+        return false;
+    }
+    connect(m_io, &QIODevice::readyRead, this, &AudioCapture::onReadyRead);
+    return true;
+}
+
+void AudioCapture::stop() {
+    if (m_source) {
+        m_source->stop();
+        delete m_source;
+        m_source = nullptr;
+    }
+    m_io = nullptr;
+}
+
+void AudioCapture::onReadyRead() {
+    if (!m_io) return;
+    MORSE_TRACE_SCOPE("AudioCapture::onReadyRead");
+
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int channels = m_format.channelCount();
+    const int bytesPerSample = m_format.bytesPerSample();
+    for (;;) {
+        qint64 available = m_source->bytesAvailable();
+        qint64 bytes = std::min<qint64>(available - available % bytesPerFrame, m_readBuffer.size());
+        if (bytes <= 0) break;
+        bytes = m_io->read(m_readBuffer.data(), bytes);
+        if (bytes <= 0) break;
+        qint64 captureNs = monotonicNs();
+
+        // First channel only
+        int frames = int(bytes / bytesPerFrame);
+        const char *data = m_readBuffer.constData();
+        for (int i = 0; i < frames; ++i) {
+            const char *sample = data + i * channels * bytesPerSample;
+            m_samples[size_t(i)] = m_format.normalizedSampleValue(sample);
+        }
+        m_input->processCaptured(m_samples.data(), size_t(frames), captureNs);
+    }
+}
+
+AudioInput::AudioInput(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+    , m_capture(new AudioCapture(this))
+    , m_detector(PREFERRED_SAMPLE_RATE)
+    , m_toneHz(700.0f)
+    , m_toneChanged(false)
+    , m_anchorNs(0)
+    , m_edgeEventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_edgeNotifier(nullptr)
+    , m_sampleEventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_spectrumRunning(false)
+    , m_spectrumEnabled(false)
+    , m_droppedRows(0)
+{
+    m_capture->moveToThread(&m_captureThread);
+    m_detectedEdges.reserve(EDGE_RING_CAPACITY);
+
+    if (m_edgeEventFd >= 0) {
+        m_edgeNotifier = new QSocketNotifier(m_edgeEventFd, QSocketNotifier::Read, this);
+        connect(m_edgeNotifier, &QSocketNotifier::activated, this, &AudioInput::drainKeyEdges);
+    } else {
+        qWarning() << "eventfd failed, audio key edges are picked up by polling:" << strerror(errno);
+        QTimer *poll = new QTimer(this);
+        connect(poll, &QTimer::timeout, this, &AudioInput::drainKeyEdges);
+        poll->start(1);
+    }
+}
+
+AudioInput::~AudioInput() {
+    stop();
+    delete m_capture;
+    if (m_edgeEventFd >= 0) ::close(m_edgeEventFd);
+    if (m_sampleEventFd >= 0) ::close(m_sampleEventFd);
+}
+
+QAudioFormat AudioInput::chooseFormat(const QAudioDevice& device) {
+    QAudioFormat format;
+    format.setSampleRate(PREFERRED_SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Float);
+    if (!device.isFormatSupported(format)) {
+        format.setSampleFormat(QAudioFormat::Int16);
+    }
+    if (!device.isFormatSupported(format)) {
+        format = device.preferredFormat();
+    }
+    return format;
+}
+
+bool AudioInput::start(const QAudioDevice& device) {
+    stop();
+    if (device.isNull()) {
+        emit errorOccurred("No audio input device found");
+        return false;
+    }
+    QAudioFormat format = chooseFormat(device);
+    if (!format.isValid() || format.sampleFormat() == QAudioFormat::Unknown) {
+        emit errorOccurred("Unsupported audio input format");
+        return false;
+    }
+
+    // Everything the capture and spectrum threads touch is sized here
+    m_detector = morse::ToneDetector(format.sampleRate(), toneFrequency());
+    m_toneChanged.store(false);
+    m_anchorNs = 0;
+    m_analyzer = morse::SpectrumAnalyzer(format.sampleRate());
+    m_analyzer.setCallback(&AudioInput::onSpectrumRow, this);
+    SampleBlock block;
+    while (m_sampleRing.pop(block)) {}
+    SpectrumRow row;
+    while (m_rowRing.pop(row)) {}
+
+    m_spectrumRunning.store(true);
+    m_spectrumThread = std::thread(&AudioInput::spectrumLoop, this);
+    m_captureThread.start(QThread::TimeCriticalPriority);
+
+    bool ok = false;
+    QMetaObject::invokeMethod(m_capture, [this, &ok, device, format]() {
+        ok = m_capture->start(device, format);
+    }, Qt::BlockingQueuedConnection);
+
+    if (!ok) {
+        stop();
+        emit errorOccurred(QString("Cannot open audio input %1").arg(device.description()));
+        return false;
+    }
+    m_running = true;
+    m_description = QString("%1, %2 Hz").arg(device.description()).arg(format.sampleRate());
+    return true;
+}
+
+void AudioInput::stop() {
+    if (m_captureThread.isRunning()) {
+        QMetaObject::invokeMethod(m_capture, [this]() { m_capture->stop(); }, Qt::BlockingQueuedConnection);
+        m_captureThread.quit();
+        m_captureThread.wait();
+    }
+    if (m_spectrumThread.joinable()) {
+        m_spectrumRunning.store(false);
+        wake(m_sampleEventFd);
+        m_spectrumThread.join();
+    }
+    drainKeyEdges();
+    m_running = false;
+}
+
+void AudioInput::setToneFrequency(float frequencyHz) {
+    m_toneHz.store(frequencyHz, std::memory_order_relaxed);
+    m_toneChanged.store(true, std::memory_order_release);
+}
+
+void AudioInput::setSpectrumEnabled(bool enabled) {
+    m_spectrumEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool AudioInput::popSpectrumRow(SpectrumRow& row) {
+    return m_rowRing.pop(row);
+}
+
+void AudioInput::processCaptured(const float *samples, size_t count, qint64 captureNs) {
+    // Capture thread: decoding comes first, the waterfall gets a copy after
+    if (m_toneChanged.exchange(false, std::memory_order_acquire)) {
+        m_detector.setFrequency(m_toneHz.load(std::memory_order_relaxed));
+    }
+    m_detectedEdges.clear();
+    m_detector.process(samples, count, m_detectedEdges);
+
+    // The last sample of the buffer was captured at about captureNs
+    qint64 anchorNs = captureNs - m_detector.positionUs() * 1000;
+    if (m_anchorNs == 0 || anchorNs < m_anchorNs || anchorNs - m_anchorNs > ANCHOR_SLACK_NS) {
+        m_anchorNs = anchorNs;
+    }
+
+    bool pushed = false;
+    for (const morse::KeyEdge& edge : m_detectedEdges) {
+        qint64 timestampNs = m_anchorNs + edge.timeUs * 1000;
+        MORSE_TRACE_FLOW_BEGIN("key edge", timestampNs);
+        if (!m_edgeRing.push(CapturedEdge{timestampNs, edge.down})) {
+            MORSE_TRACE_INSTANT("audio edge ring full");
+            break;
+        }
+        pushed = true;
+    }
+    if (pushed) wake(m_edgeEventFd);
+
+    if (m_spectrumEnabled.load(std::memory_order_relaxed)) {
+        pushSamples(samples, count);
+    }
+}
+
+void AudioInput::pushSamples(const float *samples, size_t count) {
+    SampleBlock block;
+    while (count > 0) {
+        block.count = int(std::min<size_t>(count, SAMPLE_BLOCK));
+        std::memcpy(block.samples, samples, size_t(block.count) * sizeof(float));
+        // A full ring means the spectrum thread is behind; its rows are lost
+        if (!m_sampleRing.push(block)) break;
+        samples += block.count;
+        count -= size_t(block.count);
+    }
+    wake(m_sampleEventFd);
+}
+
+void AudioInput::drainKeyEdges() {
+    if (m_edgeEventFd >= 0) {
+        uint64_t count;
+        ssize_t got = ::read(m_edgeEventFd, &count, sizeof(count));
+        Q_UNUSED(got);
+    }
+
+    CapturedEdge edge;
+    while (m_edgeRing.pop(edge)) {
+        MORSE_TRACE_FLOW_END("key edge", edge.timestampNs);
+        MORSE_TRACE_COUNTER("audio edge delivery us", (monotonicNs() - edge.timestampNs) / 1000);
+        emit keyEdge(edge.down, edge.timestampNs);
+    }
+}
+
+void AudioInput::spectrumLoop() {
+    // Batch scheduling: the FFT never competes with capture or the GUI
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+    MORSE_TRACE_THREAD_NAME("spectrum");
+
+    SampleBlock block;
+    while (m_spectrumRunning.load(std::memory_order_acquire)) {
+        pollfd waiter{m_sampleEventFd, POLLIN, 0};
+        if (m_sampleEventFd >= 0) {
+            ::poll(&waiter, 1, SPECTRUM_POLL_MS);
+            uint64_t count;
+            ssize_t got = ::read(m_sampleEventFd, &count, sizeof(count));
+            Q_UNUSED(got);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        while (m_sampleRing.pop(block)) {
+            MORSE_TRACE_SCOPE("AudioInput::spectrum");
+            m_analyzer.process(block.samples, size_t(block.count));
+        }
+    }
+}
+
+void AudioInput::onSpectrumRow(const float *levelsDb, int bins, void *context) {
+    AudioInput *self = static_cast<AudioInput *>(context);
+    SpectrumRow row;
+    std::memcpy(row.levels, levelsDb, size_t(bins) * sizeof(float));
+    if (!self->m_rowRing.push(row)) {
+        self->m_droppedRows.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef AUDIOINPUT_H
+#define AUDIOINPUT_H
+
+#include <QObject>
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QThread>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "core/SpscRing.h"
+#include "core/SpectrumAnalyzer.h"
+#include "core/ToneDetector.h"
+
+class AudioInput;
+class QAudioSource;
+class QIODevice;
+class QSocketNotifier;
+
+// Lives on the capture thread and owns the QAudioSource there
+class AudioCapture : public QObject {
+    Q_OBJECT
+
+public:
+    explicit AudioCapture(AudioInput *input);
+
+    bool start(const QAudioDevice& device, const QAudioFormat& format);
+    void stop();
+
+private slots:
+    void onReadyRead();
+
+private:
+    AudioInput *m_input;
+    QAudioSource *m_source;
+    QIODevice *m_io;
+    QAudioFormat m_format;
+    QByteArray m_readBuffer;
+    std::vector<float> m_samples;
+};
+
+// Decodes CW from a sound card. The capture thread runs the ToneDetector
+// and hands key edges to the main thread as soon as each buffer arrives;
+// a copy of the samples goes to a low-priority thread that computes the
+// spectrum rows for the waterfall. The capture thread never waits for the
+// spectrum or the GUI: when they fall behind, samples or rows are dropped.
+class AudioInput : public QObject {
+    Q_OBJECT
+
+public:
+    struct SpectrumRow {
+        float levels[morse::SPECTRUM_MAX_BINS]; // dB, full-scale sine = 0
+    };
+
+    explicit AudioInput(QObject *parent = nullptr);
+    ~AudioInput();
+
+    bool start(const QAudioDevice& device);
+    void stop();
+    bool isRunning() const { return m_running; }
+    QString description() const { return m_description; }
+
+    // Safe while running; the capture thread applies it at the next buffer
+    void setToneFrequency(float frequencyHz);
+    float toneFrequency() const { return m_toneHz.load(std::memory_order_relaxed); }
+
+    // Spectrum geometry for the current device, valid once started
+    int spectrumBins() const { return m_analyzer.bins(); }
+    float spectrumBinHz() const { return m_analyzer.binHz(); }
+
+    // The waterfall only costs CPU while someone is looking at it
+    void setSpectrumEnabled(bool enabled);
+    bool popSpectrumRow(SpectrumRow& row); // Main thread
+    quint64 droppedRows() const { return m_droppedRows.load(std::memory_order_relaxed); }
+
+signals:
+    void keyEdge(bool down, qint64 timestampNs);
+    void errorOccurred(const QString& message);
+
+private slots:
+    void drainKeyEdges();
+
+private:
+    friend class AudioCapture;
+
+    // Capture thread
+    void processCaptured(const float *samples, size_t count, qint64 captureNs);
+    void pushSamples(const float *samples, size_t count);
+
+    // Spectrum thread
+    void spectrumLoop();
+    static void onSpectrumRow(const float *levelsDb, int bins, void *context);
+
+    static QAudioFormat chooseFormat(const QAudioDevice& device);
+
+    bool m_running;
+    QString m_description;
+    QThread m_captureThread;
+    AudioCapture *m_capture;
+
+    // Capture thread state
+    morse::ToneDetector m_detector;
+    std::vector<morse::KeyEdge> m_detectedEdges;
+    std::atomic<float> m_toneHz;
+    std::atomic<bool> m_toneChanged;
+    qint64 m_anchorNs; // Monotonic time of the detector's first sample
+
+    struct CapturedEdge {
+        qint64 timestampNs;
+        bool down;
+    };
+    static constexpr size_t EDGE_RING_CAPACITY = 256;
+    morse::SpscRing<CapturedEdge, EDGE_RING_CAPACITY> m_edgeRing;
+    int m_edgeEventFd;
+    QSocketNotifier *m_edgeNotifier;
+
+    // Capture thread -> spectrum thread -> main thread
+    static constexpr int SAMPLE_BLOCK = 512;
+    struct SampleBlock {
+        float samples[SAMPLE_BLOCK];
+        int count;
+    };
+    morse::SpscRing<SampleBlock, 128> m_sampleRing;
+    morse::SpscRing<SpectrumRow, 32> m_rowRing;
+    morse::SpectrumAnalyzer m_analyzer;
+    std::thread m_spectrumThread;
+    int m_sampleEventFd;
+    std::atomic<bool> m_spectrumRunning;
+    std::atomic<bool> m_spectrumEnabled;
+    std::atomic<quint64> m_droppedRows;
+};
+
+#endif // AUDIOINPUT_H
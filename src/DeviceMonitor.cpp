@@ -0,0 +1,121 @@
+#include "DeviceMonitor.h"
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QDebug>
+#include <utility>
+
+#ifdef HAVE_LIBUDEV
+#include <libudev.h>
+#endif
+
+namespace {
+const QStringList SERIAL_NODE_FILTERS = {"ttyUSB*", "ttyACM*"};
+}
+
+DeviceMonitor::DeviceMonitor(QObject *parent)
+    : QObject(parent)
+    , m_udev(nullptr)
+    , m_udevMonitor(nullptr)
+    , m_notifier(nullptr)
+    , m_watcher(nullptr)
+{
+}
+
+DeviceMonitor::~DeviceMonitor() {
+    delete m_notifier;
+#ifdef HAVE_LIBUDEV
+    if (m_udevMonitor) udev_monitor_unref(static_cast<udev_monitor *>(m_udevMonitor));
+    if (m_udev) udev_unref(static_cast<udev *>(m_udev));
+#endif
+}
+
+bool DeviceMonitor::start() {
+    if (m_udevMonitor || m_watcher) return true;
+
+    if (startUdev()) return true;
+
+    startDirectoryWatch();
+    return m_watcher != nullptr;
+}
+
+bool DeviceMonitor::startUdev() {
+#ifdef HAVE_LIBUDEV
+    udev *context = udev_new();
+    if (!context) return false;
+
+    // The "udev" source delivers events after rules ran, so permissions
+    // and symlinks are already in place when we see the node
+    udev_monitor *monitor = udev_monitor_new_from_netlink(context, "udev");
+    if (!monitor) {
+        udev_unref(context);
+        return false;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype(monitor, "tty", nullptr);
+    if (udev_monitor_enable_receiving(monitor) < 0) {
+        udev_monitor_unref(monitor);
+        udev_unref(context);
+        return false;
+    }
+
+    m_udev = context;
+    m_udevMonitor = monitor;
+    m_notifier = new QSocketNotifier(udev_monitor_get_fd(monitor), QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DeviceMonitor::onUdevActivity);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void DeviceMonitor::onUdevActivity() {
+#ifdef HAVE_LIBUDEV
+    auto *monitor = static_cast<udev_monitor *>(m_udevMonitor);
+    while (udev_device *device = udev_monitor_receive_device(monitor)) {
+        const char *action = udev_device_get_action(device);
+        const char *node = udev_device_get_devnode(device);
+        if (action && node) {
+            QString devNode = QString::fromLocal8Bit(node);
+            if (qstrcmp(action, "add") == 0) {
+                emit deviceAdded(devNode);
+            } else if (qstrcmp(action, "remove") == 0) {
+                emit deviceRemoved(devNode);
+            }
+        }
+        udev_device_unref(device);
+    }
+#endif
+}
+
+void DeviceMonitor::startDirectoryWatch() {
+    m_watcher = new QFileSystemWatcher(this);
+    if (!m_watcher->addPath("/dev")) {
+        qWarning() << "Cannot watch /dev; serial hotplug detection disabled";
+        delete m_watcher;
+        m_watcher = nullptr;
+        return;
+    }
+    m_knownNodes = scanSerialNodes();
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &DeviceMonitor::onDevDirectoryChanged);
+}
+
+void DeviceMonitor::onDevDirectoryChanged() {
+    QSet<QString> nodes = scanSerialNodes();
+    for (const QString& node : nodes) {
+        if (!m_knownNodes.contains(node)) emit deviceAdded(node);
+    }
+    for (const QString& node : std::as_const(m_knownNodes)) {
+        if (!nodes.contains(node)) emit deviceRemoved(node);
+    }
+    m_knownNodes = nodes;
+}
+
+QSet<QString> DeviceMonitor::scanSerialNodes() {
+    QSet<QString> nodes;
+    const QStringList entries = QDir("/dev").entryList(SERIAL_NODE_FILTERS, QDir::System);
+    for (const QString& entry : entries) {
+        nodes.insert("/dev/" + entry);
+    }
+    return nodes;
+}
@@ -0,0 +1,45 @@
+#ifndef DEVICEMONITOR_H
+#define DEVICEMONITOR_H
+
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+class QSocketNotifier;
+class QFileSystemWatcher;
+
+// Reports serial device hotplug. Uses a udev netlink monitor when built
+// with libudev and falls back to watching /dev for tty nodes otherwise.
+class DeviceMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DeviceMonitor(QObject *parent = nullptr);
+    ~DeviceMonitor();
+
+    bool start();
+    bool usingUdev() const { return m_udevMonitor != nullptr; }
+
+signals:
+    // devNode is the full device path, e.g. /dev/ttyUSB0
+    void deviceAdded(const QString& devNode);
+    void deviceRemoved(const QString& devNode);
+
+private slots:
+    void onUdevActivity();
+    void onDevDirectoryChanged();
+
+private:
+    bool startUdev();
+    void startDirectoryWatch();
+    static QSet<QString> scanSerialNodes();
+
+    void *m_udev;          // struct udev *
+    void *m_udevMonitor;   // struct udev_monitor *
+    QSocketNotifier *m_notifier;
+
+    QFileSystemWatcher *m_watcher;
+    QSet<QString> m_knownNodes;
+};
+
+#endif // DEVICEMONITOR_H
@@ -0,0 +1,360 @@
+#include "EventPublisher.h"
+#include "core/MorseCode.h"
+#include "core/Trace.h"
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStandardPaths>
+#include <QDebug>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace EventStream;
+
+namespace {
+uint8_t confidenceFlags(float confidence) {
+    return static_cast<uint8_t>(qBound(0, qRound(confidence * 255.0f), 255));
+}
+}
+
+EventPublisher::EventPublisher(QObject *parent)
+    : QObject(parent)
+    , m_lockFd(-1)
+    , m_listenFd(-1)
+    , m_listenNotifier(nullptr)
+    , m_droppedTotal(0)
+    , m_ring(nullptr)
+    , m_ringSlots(nullptr)
+    , m_ringBytes(0)
+{
+}
+
+EventPublisher::~EventPublisher() {
+    stop();
+}
+
+qint64 EventPublisher::monotonicNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool EventPublisher::start() {
+    if (isRunning()) return true;
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation) + "/morse-decoder";
+    QDir().mkpath(dir);
+    m_socketPath = dir + "/events.sock";
+
+    QByteArray path = QFile::encodeName(m_socketPath);
+    sockaddr_un address{};
+    if (static_cast<size_t>(path.size()) >= sizeof(address.sun_path)) {
+        qWarning() << "Event socket path too long:" << m_socketPath;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.constData(), path.size());
+
+    // One publisher per user: a second instance must not unlink the
+    // first one's socket
+    QByteArray lockPath = QFile::encodeName(dir + "/events.lock");
+    m_lockFd = ::open(lockPath.constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (m_lockFd < 0 || flock(m_lockFd, LOCK_EX | LOCK_NB) != 0) {
+        qWarning() << "Cannot publish events, another instance holds" << lockPath << strerror(errno);
+        if (m_lockFd >= 0) ::close(m_lockFd);
+        m_lockFd = -1;
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        releaseLock();
+        return false;
+    }
+
+    ::unlink(path.constData()); // Stale socket from a previous run
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0
+        || listen(fd, 16) != 0) {
+        qWarning() << "Cannot listen on" << m_socketPath << strerror(errno);
+        ::close(fd);
+        releaseLock();
+        return false;
+    }
+
+    m_listenFd = fd;
+    m_listenNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_listenNotifier, &QSocketNotifier::activated, this, &EventPublisher::onNewConnection);
+
+    if (!openSharedRing()) {
+        qWarning() << "Shared memory event ring unavailable; socket only";
+    }
+    return true;
+}
+
+void EventPublisher::stop() {
+    for (Subscriber *subscriber : m_subscribers) {
+        subscriber->dead = true;
+    }
+    removeDeadSubscribers();
+
+    if (m_listenFd >= 0) {
+        delete m_listenNotifier;
+        m_listenNotifier = nullptr;
+        ::close(m_listenFd);
+        m_listenFd = -1;
+        ::unlink(QFile::encodeName(m_socketPath).constData());
+    }
+    closeSharedRing();
+    releaseLock();
+}
+
+void EventPublisher::releaseLock() {
+    if (m_lockFd < 0) return;
+    ::close(m_lockFd); // Drops the flock
+    m_lockFd = -1;
+}
+
+bool EventPublisher::openSharedRing() {
+    m_shmName = QString("/morse-decoder-events-%1-%2").arg(getuid()).arg(getpid());
+    QByteArray name = m_shmName.toLatin1();
+
+    // Exclusive, so a reader never sees two writers; an existing segment
+    // with this pid in its name was left by a process that died
+    int fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        shm_unlink(name.constData());
+        fd = shm_open(name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        qWarning() << "Cannot create shared memory" << m_shmName << strerror(errno);
+        return false;
+    }
+
+    m_ringBytes = sizeof(EventRingHeader) + RING_CAPACITY * sizeof(EventRingSlot);
+    if (ftruncate(fd, static_cast<off_t>(m_ringBytes)) != 0) {
+        ::close(fd);
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    void *memory = mmap(nullptr, m_ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.constData());
+        return false;
+    }
+
+    m_ring = new (memory) EventRingHeader();
+    m_ring->magic = MAGIC;
+    m_ring->version = VERSION;
+    m_ring->recordSize = sizeof(EventRingSlot);
+    m_ring->capacity = RING_CAPACITY;
+    m_ringSlots = reinterpret_cast<EventRingSlot *>(static_cast<char *>(memory) + sizeof(EventRingHeader));
+    for (uint32_t i = 0; i < RING_CAPACITY; ++i) {
+        new (&m_ringSlots[i]) EventRingSlot();
+        m_ringSlots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+    m_ring->writeIndex.store(0, std::memory_order_release);
+    return true;
+}
+
+void EventPublisher::closeSharedRing() {
+    if (!m_ring) return;
+
+    munmap(m_ring, m_ringBytes);
+    shm_unlink(m_shmName.toLatin1().constData());
+    m_ring = nullptr;
+    m_ringSlots = nullptr;
+}
+
+void EventPublisher::onNewConnection() {
+    for (;;) {
+        int fd = accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) break;
+
+        Subscriber *subscriber = new Subscriber();
+        subscriber->fd = fd;
+        subscriber->backlog.reserve(MAX_BACKLOG_BYTES);
+
+        subscriber->readNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(subscriber->readNotifier, &QSocketNotifier::activated, this, [this, subscriber]() {
+            onSubscriberReadable(subscriber);
+        });
+        subscriber->writeNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+        subscriber->writeNotifier->setEnabled(false);
+        connect(subscriber->writeNotifier, &QSocketNotifier::activated, this, [this, subscriber]() {
+            flushBacklog(subscriber);
+            removeDeadSubscribers();
+        });
+        m_subscribers.push_back(subscriber);
+
+        EventStreamHello hello{};
+        hello.magic = MAGIC;
+        hello.version = VERSION;
+        hello.recordSize = sizeof(EventRecord);
+        if (m_ring) {
+            QByteArray name = m_shmName.toLatin1();
+            std::strncpy(hello.shmName, name.constData(), sizeof(hello.shmName) - 1);
+        }
+        sendTo(subscriber, reinterpret_cast<const char *>(&hello), sizeof(hello));
+    }
+    removeDeadSubscribers();
+}
+
+void EventPublisher::onSubscriberReadable(Subscriber *subscriber) {
+    // Subscribers never send anything; readable means EOF or error
+    char scratch[64];
+    ssize_t n = recv(subscriber->fd, scratch, sizeof(scratch), MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        subscriber->dead = true;
+        removeDeadSubscribers();
+    }
+}
+
+void EventPublisher::removeDeadSubscribers() {
+    for (auto it = m_subscribers.begin(); it != m_subscribers.end();) {
+        Subscriber *subscriber = *it;
+        if (!subscriber->dead) {
+            ++it;
+            continue;
+        }
+        // The notifiers may be the ones currently emitting
+        subscriber->readNotifier->setEnabled(false);
+        subscriber->writeNotifier->setEnabled(false);
+        subscriber->readNotifier->deleteLater();
+        subscriber->writeNotifier->deleteLater();
+        ::close(subscriber->fd);
+        delete subscriber;
+        it = m_subscribers.erase(it);
+    }
+}
+
+void EventPublisher::sendTo(Subscriber *subscriber, const char *data, size_t size) {
+    if (subscriber->dead) return;
+
+    size_t pending = subscriber->backlog.size() - subscriber->backlogStart;
+    if (pending == 0) {
+        ssize_t sent = send(subscriber->fd, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                subscriber->dead = true;
+                return;
+            }
+            sent = 0;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+        if (size == 0) return;
+    }
+
+    // Whole records only: drop what does not fit and report it later
+    if (pending + size > MAX_BACKLOG_BYTES) {
+        ++subscriber->dropped;
+        ++m_droppedTotal;
+        return;
+    }
+    if (subscriber->backlogStart > 0 && subscriber->backlog.size() + size > MAX_BACKLOG_BYTES) {
+        subscriber->backlog.erase(subscriber->backlog.begin(),
+                                  subscriber->backlog.begin() + subscriber->backlogStart);
+        subscriber->backlogStart = 0;
+    }
+    subscriber->backlog.insert(subscriber->backlog.end(), data, data + size);
+    subscriber->writeNotifier->setEnabled(true);
+}
+
+void EventPublisher::flushBacklog(Subscriber *subscriber) {
+    size_t pending = subscriber->backlog.size() - subscriber->backlogStart;
+    if (pending > 0) {
+        ssize_t sent = send(subscriber->fd, subscriber->backlog.data() + subscriber->backlogStart,
+                            pending, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                subscriber->dead = true;
+            }
+            return;
+        }
+        subscriber->backlogStart += static_cast<size_t>(sent);
+    }
+
+    if (subscriber->backlogStart == subscriber->backlog.size()) {
+        subscriber->backlog.clear();
+        subscriber->backlogStart = 0;
+        subscriber->writeNotifier->setEnabled(false);
+
+        if (subscriber->dropped > 0) {
+            EventRecord notice{};
+            notice.timestampNs = static_cast<uint64_t>(monotonicNs());
+            notice.type = Dropped;
+            notice.value = static_cast<uint32_t>(qMin<quint64>(subscriber->dropped, UINT32_MAX));
+            subscriber->dropped = 0;
+            sendTo(subscriber, reinterpret_cast<const char *>(&notice), sizeof(notice));
+        }
+    }
+}
+
+void EventPublisher::publish(uint8_t type, uint32_t value, uint16_t length, qint64 timestampNs, uint8_t flags) {
+    if (!isRunning()) return;
+    MORSE_TRACE_SCOPE("EventPublisher::publish");
+
+    EventRecord record{};
+    record.timestampNs = static_cast<uint64_t>(timestampNs ? timestampNs : monotonicNs());
+    record.type = type;
+    record.flags = flags;
+    record.length = length;
+    record.value = value;
+
+    if (m_ring) {
+        // Seqlock: odd while the record is being stored, see EventStream.h
+        uint64_t index = m_ring->writeIndex.load(std::memory_order_relaxed);
+        EventRingSlot& slot = m_ringSlots[index & (RING_CAPACITY - 1)];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.record = record;
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        m_ring->writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    if (m_subscribers.empty()) return;
+    for (Subscriber *subscriber : m_subscribers) {
+        sendTo(subscriber, reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+    removeDeadSubscribers();
+}
+
+void EventPublisher::publishKeyEdge(bool down, qint64 timestampNs) {
+    publish(KeyEdge, down ? 1 : 0, 0, timestampNs);
+}
+
+void EventPublisher::publishElement(const QString& element, float confidence) {
+    if (element.isEmpty()) return;
+    publish(Element, element.at(0).unicode(), 0, 0, confidenceFlags(confidence));
+}
+
+void EventPublisher::publishCharacter(QChar character, float confidence) {
+    publish(Character, character.unicode(), 0, 0, confidenceFlags(confidence));
+}
+
+void EventPublisher::publishWordSpace() {
+    publish(WordSpace, 0);
+}
+
+void EventPublisher::publishError(const QString& pattern, float confidence) {
+    uint32_t bits = 0;
+    int length = 0;
+    for (; length < qMin(pattern.size(), 32); ++length) {
+        QChar element = pattern.at(length);
+        if (element == morse::Pattern::OVERFLOW_MARK) {
+            ++length; // One past the elements kept
+            break;
+        }
+        if (element == '-') bits |= (1u << length);
+    }
+    publish(DecodingError, bits, static_cast<uint16_t>(length), 0, confidenceFlags(confidence));
+}
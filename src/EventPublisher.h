@@ -0,0 +1,78 @@
+#ifndef EVENTPUBLISHER_H
+#define EVENTPUBLISHER_H
+
+#include <QObject>
+#include <QString>
+#include <vector>
+#include "EventStream.h"
+
+class QSocketNotifier;
+
+// Publishes key edges and decoder output to local subscribers over a Unix
+// domain socket (see EventStream.h for the framing) and into a shared
+// memory ring. Sockets are non-blocking with a bounded per-subscriber
+// backlog; a subscriber that cannot keep up loses records and is told how
+// many, so it never stalls capture or decoding.
+class EventPublisher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit EventPublisher(QObject *parent = nullptr);
+    ~EventPublisher();
+
+    bool start();
+    void stop();
+    bool isRunning() const { return m_listenFd >= 0; }
+
+    QString socketPath() const { return m_socketPath; }
+    int subscriberCount() const { return static_cast<int>(m_subscribers.size()); }
+    quint64 droppedRecords() const { return m_droppedTotal; }
+
+    static qint64 monotonicNs();
+
+public slots:
+    void publishKeyEdge(bool down, qint64 timestampNs);
+    void publishElement(const QString& element, float confidence);
+    void publishCharacter(QChar character, float confidence);
+    void publishWordSpace();
+    void publishError(const QString& pattern, float confidence);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Subscriber {
+        int fd = -1;
+        QSocketNotifier *readNotifier = nullptr;
+        QSocketNotifier *writeNotifier = nullptr;
+        std::vector<char> backlog;
+        size_t backlogStart = 0;
+        quint64 dropped = 0;    // Not yet reported to the subscriber
+        bool dead = false;
+    };
+
+    static constexpr size_t MAX_BACKLOG_BYTES = 64 * 1024;
+
+    void publish(uint8_t type, uint32_t value, uint16_t length = 0, qint64 timestampNs = 0, uint8_t flags = 0);
+    bool openSharedRing();
+    void releaseLock();
+    void closeSharedRing();
+    void sendTo(Subscriber *subscriber, const char *data, size_t size);
+    void flushBacklog(Subscriber *subscriber);
+    void onSubscriberReadable(Subscriber *subscriber);
+    void removeDeadSubscribers();
+
+    QString m_socketPath;
+    int m_lockFd;  // flock held while this instance owns the socket
+    int m_listenFd;
+    QSocketNotifier *m_listenNotifier;
+    std::vector<Subscriber *> m_subscribers;
+    quint64 m_droppedTotal;
+
+    QString m_shmName;
+    EventStream::EventRingHeader *m_ring;
+    EventStream::EventRingSlot *m_ringSlots;
+    size_t m_ringBytes;
+};
+
+#endif // EVENTPUBLISHER_H
@@ -0,0 +1,89 @@
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+// Wire format of the local decoded-event stream. Plain C++ so subscribers
+// can include it without Qt.
+//
+// Socket: $XDG_RUNTIME_DIR/morse-decoder/events.sock (SOCK_STREAM). The
+// server sends one EventStreamHello, then a sequence of EventRecords.
+//
+// Shared memory: shm_open(hello.shmName) maps an EventRingHeader followed
+// by `capacity` EventRingSlots; the name is unique to the publishing
+// process. Record i goes to slot i % capacity under a per-slot seqlock:
+// the writer sets the slot's sequence to 2i + 1, stores the record and
+// then sets it to 2i + 2 (release), and finally publishes writeIndex =
+// i + 1. Readers keep their own index, start from writeIndex and copy
+// record i with readRingSlot(), which fails while the slot holds an older
+// record or is being written, and reports a lapped reader when it holds a
+// newer one.
+
+#include <atomic>
+#include <cstdint>
+
+namespace EventStream {
+
+constexpr uint32_t MAGIC = 0x56454B4D; // "MKEV"
+constexpr uint16_t VERSION = 3; // 2: confidence in EventRecord::flags, 3: ring slot sequences
+constexpr uint32_t RING_CAPACITY = 4096; // Power of two
+
+enum EventType : uint8_t {
+    KeyEdge = 1,       // value: 1 down, 0 up; timestamp from the capture thread
+    Element = 2,       // value: '.' or '-'
+    Character = 3,     // value: Unicode code point
+    WordSpace = 4,
+    DecodingError = 5, // length: element count, value: bit i set = dah at i;
+                       // length 9 means longer, with only the first 8 kept
+    Dropped = 6,       // value: records dropped for this subscriber
+};
+
+struct EventRecord {
+    uint64_t timestampNs; // CLOCK_MONOTONIC
+    uint8_t type;
+    uint8_t flags;        // Element, Character, DecodingError: confidence 0-255, else 0
+    uint16_t length;
+    uint32_t value;
+};
+static_assert(sizeof(EventRecord) == 16, "EventRecord is part of the wire format");
+
+struct EventStreamHello {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    char shmName[56];     // NUL-terminated, empty if shared memory is off
+};
+static_assert(sizeof(EventStreamHello) == 64, "EventStreamHello is part of the wire format");
+
+struct EventRingHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;  // sizeof(EventRingSlot)
+    uint32_t capacity;
+    uint32_t reserved;
+    std::atomic<uint64_t> writeIndex;
+    uint8_t padding[40];  // Records start on their own cache line
+};
+static_assert(sizeof(EventRingHeader) == 64, "EventRingHeader is part of the wire format");
+
+struct EventRingSlot {
+    std::atomic<uint64_t> sequence; // 2i + 2 once record i is complete, odd while written
+    EventRecord record;
+};
+static_assert(sizeof(EventRingSlot) == 24, "EventRingSlot is part of the wire format");
+
+enum class SlotRead { Ok, NotYet, Lapped };
+
+// Copies record `index` out of its slot; Lapped means the writer has
+// already reused the slot and the reader must skip ahead
+inline SlotRead readRingSlot(const EventRingSlot& slot, uint64_t index, EventRecord *record) {
+    const uint64_t complete = 2 * index + 2;
+    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before != complete) return before < complete ? SlotRead::NotYet : SlotRead::Lapped;
+    *record = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+    return after == complete ? SlotRead::Ok : SlotRead::Lapped;
+}
+
+} // namespace EventStream
+
+#endif // EVENTSTREAM_H
@@ -0,0 +1,123 @@
+#include "ExchangePanel.h"
+#include <QFile>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QTime>
+#include <QVBoxLayout>
+#include <QDebug>
+
+namespace {
+// Older exchanges scroll off the bottom
+constexpr int MAX_ROWS = 500;
+
+enum Column { TimeColumn, CallsignColumn, RstColumn, NumberColumn, DelimiterColumn, ColumnCount };
+}
+
+ExchangePanel::ExchangePanel(QWidget *parent)
+    : QWidget(parent)
+    , m_exchangeCount(0)
+{
+    m_recognizer.setCallback(&ExchangePanel::onRecognizerEvent, this);
+    m_recognizer.addDefaultPatterns();
+    m_recognizer.compile();
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *topLayout = new QHBoxLayout();
+    m_formatCombo = new QComboBox(this);
+    m_formatCombo->addItem("Serial number", static_cast<int>(morse::ExchangeNumber::Serial));
+    m_formatCombo->addItem("CQ zone", static_cast<int>(morse::ExchangeNumber::CqZone));
+    m_formatCombo->addItem("ITU zone", static_cast<int>(morse::ExchangeNumber::ItuZone));
+    m_formatCombo->setToolTip("How numbers after the RST are read");
+    topLayout->addWidget(new QLabel("Exchange:", this));
+    topLayout->addWidget(m_formatCombo);
+    topLayout->addStretch();
+    m_countLabel = new QLabel(this);
+    topLayout->addWidget(m_countLabel);
+    layout->addLayout(topLayout);
+
+    m_table = new QTableWidget(0, ColumnCount, this);
+    m_table->setHorizontalHeaderLabels({"Time", "Callsign", "RST", "Nr", "Closed by"});
+    m_table->verticalHeader()->hide();
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    layout->addWidget(m_table, 1);
+
+    connect(m_formatCombo, &QComboBox::currentIndexChanged, this, [this]() {
+        m_recognizer.setNumberFormat(static_cast<morse::ExchangeNumber>(m_formatCombo->currentData().toInt()));
+        m_table->horizontalHeaderItem(NumberColumn)->setText(
+            m_recognizer.numberFormat() == morse::ExchangeNumber::Serial ? "Nr" : "Zone");
+    });
+    updateCount();
+}
+
+bool ExchangePanel::loadPatterns(const QString& path) {
+    std::string error;
+    if (!m_recognizer.loadPatterns(QFile::encodeName(path).constData(), morse::PatternKind::Keyword, &error)) {
+        qWarning() << "Cannot load exchange patterns from" << path << ":" << QString::fromStdString(error);
+        return false;
+    }
+    m_recognizer.compile();
+    updateCount();
+    return true;
+}
+
+void ExchangePanel::setNumberFormat(morse::ExchangeNumber format) {
+    m_formatCombo->setCurrentIndex(m_formatCombo->findData(static_cast<int>(format)));
+}
+
+void ExchangePanel::addCharacter(QChar character) {
+    m_recognizer.addCharacter(character.toLatin1());
+}
+
+void ExchangePanel::addWordSpace() {
+    m_recognizer.addWordSpace();
+}
+
+void ExchangePanel::addError() {
+    m_recognizer.addCharacter('*'); // Keeps the word from matching anything
+}
+
+void ExchangePanel::reset() {
+    m_recognizer.reset();
+    m_table->setRowCount(0);
+    m_exchangeCount = 0;
+    updateCount();
+}
+
+void ExchangePanel::onRecognizerEvent(const morse::ExchangeEvent& event, void *context) {
+    if (event.kind != morse::ExchangeEvent::Kind::Exchange) return;
+    static_cast<ExchangePanel *>(context)->addExchange(event.exchange);
+}
+
+void ExchangePanel::addExchange(const morse::ExchangeRecord& exchange) {
+    QString number;
+    if (exchange.zone >= 0) number = QString::number(exchange.zone);
+    else if (exchange.serial >= 0) number = QString::number(exchange.serial);
+
+    m_table->insertRow(0);
+    m_table->setItem(0, TimeColumn, new QTableWidgetItem(QTime::currentTime().toString("HH:mm:ss")));
+    QTableWidgetItem *callsign = new QTableWidgetItem(QString::fromLatin1(exchange.callsign));
+    if (exchange.known) {
+        QFont font = callsign->font();
+        font.setBold(true);
+        callsign->setFont(font);
+        callsign->setToolTip("In the pattern list");
+    }
+    m_table->setItem(0, CallsignColumn, callsign);
+    m_table->setItem(0, RstColumn, new QTableWidgetItem(exchange.rst >= 0 ? QString::number(exchange.rst) : QString()));
+    m_table->setItem(0, NumberColumn, new QTableWidgetItem(number));
+    m_table->setItem(0, DelimiterColumn, new QTableWidgetItem(
+        exchange.delimiter >= 0 ? QString::fromStdString(m_recognizer.patternText(exchange.delimiter)) : QString()));
+    if (m_table->rowCount() > MAX_ROWS) m_table->setRowCount(MAX_ROWS);
+
+    ++m_exchangeCount;
+    updateCount();
+}
+
+void ExchangePanel::updateCount() {
+    m_countLabel->setText(QString("%1 exchanges, %2 patterns")
+                              .arg(m_exchangeCount)
+                              .arg(m_recognizer.patternCount()));
+}
@@ -0,0 +1,42 @@
+#ifndef EXCHANGEPANEL_H
+#define EXCHANGEPANEL_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLabel>
+#include <QTableWidget>
+#include "core/ExchangeRecognizer.h"
+
+// Lists the contest exchanges recognized in the decoded stream, newest first
+class ExchangePanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ExchangePanel(QWidget *parent = nullptr);
+
+    // Adds keywords (e.g. a callsign list) to the default patterns
+    bool loadPatterns(const QString& path);
+
+    morse::ExchangeNumber numberFormat() const { return m_recognizer.numberFormat(); }
+    void setNumberFormat(morse::ExchangeNumber format);
+
+public slots:
+    void addCharacter(QChar character);
+    void addWordSpace();
+    void addError();
+    void reset();
+
+private:
+    static void onRecognizerEvent(const morse::ExchangeEvent& event, void *context);
+    void addExchange(const morse::ExchangeRecord& exchange);
+    void updateCount();
+
+    morse::ExchangeRecognizer m_recognizer;
+    int m_exchangeCount;
+
+    QComboBox *m_formatCombo;
+    QLabel *m_countLabel;
+    QTableWidget *m_table;
+};
+
+#endif // EXCHANGEPANEL_H
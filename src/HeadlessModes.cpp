@@ -0,0 +1,385 @@
+#include "HeadlessModes.h"
+#include "MorseDecoder.h"
+#include "SessionLogger.h"
+#include "core/AllocationCounter.h"
+#include "core/BatchDecoder.h"
+#include "core/HotPathReplay.h"
+#include "core/SpscRing.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+// Headless: morse-decoder --batch <dir> [--output <dir>] [--threads N] [--split-silence <ms>]
+int runBatch(int argc, char *argv[]) {
+    morse::BatchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::fprintf(stderr, "%s needs a value\n", arg);
+            return 2;
+        }
+        if (std::strcmp(arg, "--batch") == 0) {
+            options.inputDirectory = value;
+        } else if (std::strcmp(arg, "--output") == 0) {
+            options.outputDirectory = value;
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.threads = std::atoi(value);
+        } else if (std::strcmp(arg, "--split-silence") == 0) {
+            options.splitSilenceMs = std::atoll(value);
+        } else {
+            std::fprintf(stderr, "Unknown batch option %s\n", arg);
+            return 2;
+        }
+        ++i;
+    }
+
+    morse::BatchReport report = morse::BatchDecoder::run(options);
+    if (report.files.empty()) {
+        std::fprintf(stderr, "No recordings (.wav, .keys, .log) in %s\n", options.inputDirectory.c_str());
+        return 1;
+    }
+
+    std::string text = report.format();
+    std::fputs(text.c_str(), stdout);
+    std::string reportPath = (options.outputDirectory.empty() ? options.inputDirectory + "/transcripts"
+                                                              : options.outputDirectory) + "/report.txt";
+    if (std::FILE *file = std::fopen(reportPath.c_str(), "w")) {
+        std::fputs(text.c_str(), file);
+        std::fclose(file);
+    }
+
+    for (const morse::BatchFileResult& file : report.files) {
+        if (!file.error.empty()) return 1;
+    }
+    return 0;
+}
+
+int64_t benchNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Headless: morse-decoder --check-allocations [recording.keys|session.log]
+// Replays the recording, or an hour of generated traffic, through the live
+// path: a capture thread hands edges over an SpscRing to MorseDecoder on
+// the main thread, whose signals feed a SessionLogger wired as in
+// MainWindow. Fails if either thread allocates after the warm-up. Edges
+// are paced at 1000x real time so the log writer keeps up as it would live;
+// boundaries are resolved at the next edge, as in --bench.
+int runAllocationCheck(int argc, char *argv[]) {
+    constexpr int64_t REPLAY_SPEED = 1000;
+    std::vector<morse::KeyEdge> edges;
+    const char *path = argc > 2 ? argv[2] : nullptr;
+    if (path) {
+        std::string error;
+        size_t length = std::strlen(path);
+        bool isLog = length > 4 && std::strcmp(path + length - 4, ".log") == 0;
+        bool loaded = isLog ? morse::BatchDecoder::loadSessionLog(path, edges, &error)
+                            : morse::BatchDecoder::loadKeyTimings(path, edges, &error);
+        if (!loaded) {
+            std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+            return 2;
+        }
+    } else {
+        edges = morse::HotPathReplay::generate(1.0, 1);
+    }
+    QCoreApplication app(argc, argv);
+
+    morse::HotPathReport report;
+    report.edges = edges.size();
+    report.warmupEdges = std::min(edges.size(), morse::HotPathReplay::WARMUP_EDGES);
+    report.counted = morse::AllocationCounter::isEnabled();
+    if (edges.size() >= 2) {
+        report.seconds = (edges.back().timeUs - edges.front().timeUs) / 1e6;
+    }
+
+    QString logPath = QDir::temp().filePath("morse-decoder-allocation-check.log");
+    QFile::remove(logPath);
+    SessionLogger logger;
+    if (!logger.open(logPath)) {
+        std::fprintf(stderr, "Cannot open %s\n", qPrintable(logPath));
+        return 2;
+    }
+    MorseDecoder decoder;
+    decoder.setWpm(20);
+    size_t characters = 0;
+    QObject::connect(&decoder, &MorseDecoder::characterDecoded, [&characters]() { ++characters; });
+    QObject::connect(&decoder, &MorseDecoder::characterDecoded, &logger, &SessionLogger::logCharacter);
+    QObject::connect(&decoder, &MorseDecoder::wordSpaceDetected, &logger, &SessionLogger::logWordSpace);
+    QObject::connect(&decoder, &MorseDecoder::decodingError, &logger, &SessionLogger::logError);
+    QObject::connect(&decoder, &MorseDecoder::markMeasured, &logger, &SessionLogger::logMark);
+    QObject::connect(&decoder, &MorseDecoder::spaceMeasured, &logger, &SessionLogger::logSpace);
+    QObject::connect(&decoder, &MorseDecoder::speedChanged, &logger, &SessionLogger::logSpeedChange);
+
+    morse::SpscRing<morse::KeyEdge, 256> ring;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> captureAllocations{0};
+    std::thread capture([&]() {
+        morse::AllocationScope scope;
+        uint64_t warm = 0;
+        const int64_t startNs = benchNowNs();
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (i == report.warmupEdges) warm = scope.count();
+            int64_t dueNs = startNs + (edges[i].timeUs - edges.front().timeUs) * 1000 / REPLAY_SPEED;
+            int64_t aheadNs = dueNs - benchNowNs();
+            if (aheadNs > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(aheadNs));
+            while (!ring.push(edges[i])) {
+                std::this_thread::yield();
+            }
+        }
+        captureAllocations = edges.size() > report.warmupEdges ? scope.count() - warm : 0;
+        done = true;
+    });
+
+    morse::AllocationScope scope;
+    uint64_t warm = 0;
+    size_t received = 0;
+    morse::KeyEdge edge;
+    while (true) {
+        if (!ring.pop(edge)) {
+            if (done && ring.isEmpty()) break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (received++ == report.warmupEdges) warm = scope.count();
+        decoder.keyEdge(edge.down, edge.timeUs * 1000);
+    }
+    report.decodeAllocations = received > report.warmupEdges ? scope.count() - warm : 0;
+    capture.join();
+    report.captureAllocations = captureAllocations;
+    report.characters = characters;
+
+    logger.close();
+    QFile::remove(logPath);
+    std::fputs(report.format().c_str(), stdout);
+    if (logger.recordsDropped() > 0) {
+        std::fprintf(stderr, "The session log dropped %llu records\n",
+                     static_cast<unsigned long long>(logger.recordsDropped()));
+        return 1;
+    }
+    return report.passed() ? 0 : 1;
+}
+
+struct BenchCounts {
+    uint64_t events = 0;
+    uint64_t characters = 0;
+};
+
+void countEngineEvent(const morse::Event& event, void *context) {
+    BenchCounts *counts = static_cast<BenchCounts *>(context);
+    ++counts->events;
+    if (event.type == morse::EventType::Character) ++counts->characters;
+}
+
+// Headless: morse-decoder --bench [hours]
+// Decodes the same generated traffic through DecoderEngine's callback and
+// through the MorseDecoder adapter's signals, best of a few runs each, so
+// the per-edge cost of the Qt dispatch can be compared with the core
+int runBench(int argc, char *argv[]) {
+    constexpr int RUNS = 5;
+    double hours = argc > 2 ? std::atof(argv[2]) : 1.0;
+    if (hours <= 0.0) {
+        std::fprintf(stderr, "--bench needs a positive number of hours\n");
+        return 2;
+    }
+    QCoreApplication app(argc, argv); // MorseDecoder's boundary notifier needs one
+    std::vector<morse::KeyEdge> edges = morse::HotPathReplay::generate(hours, 1);
+
+    // Boundaries are polled at each key edge in both runs, so both see the
+    // same events; the character still open at the end is left undecoded
+    BenchCounts core;
+    int64_t coreBestNs = INT64_MAX;
+    for (int run = 0; run < RUNS; ++run) {
+        BenchCounts counts;
+        morse::DecoderEngine engine(20);
+        engine.setCallback(&countEngineEvent, &counts);
+        int64_t start = benchNowNs();
+        for (const morse::KeyEdge& edge : edges) {
+            if (edge.down) {
+                engine.keyDown(edge.timeUs);
+            } else {
+                engine.keyUp(edge.timeUs);
+            }
+        }
+        coreBestNs = std::min(coreBestNs, benchNowNs() - start);
+        core = counts;
+    }
+
+    BenchCounts adapter;
+    int64_t adapterBestNs = INT64_MAX;
+    for (int run = 0; run < RUNS; ++run) {
+        BenchCounts counts;
+        MorseDecoder decoder;
+        decoder.setWpm(20);
+        auto count = [&counts]() { ++counts.events; };
+        QObject::connect(&decoder, &MorseDecoder::elementDecoded, count);
+        QObject::connect(&decoder, &MorseDecoder::characterDecoded, [&counts]() {
+            ++counts.events;
+            ++counts.characters;
+        });
+        QObject::connect(&decoder, &MorseDecoder::wordSpaceDetected, count);
+        QObject::connect(&decoder, &MorseDecoder::decodingError, count);
+        QObject::connect(&decoder, &MorseDecoder::timingChanged, count);
+        QObject::connect(&decoder, &MorseDecoder::markMeasured, count);
+        QObject::connect(&decoder, &MorseDecoder::spaceMeasured, count);
+        QObject::connect(&decoder, &MorseDecoder::speedChanged, count);
+        int64_t start = benchNowNs();
+        for (const morse::KeyEdge& edge : edges) {
+            decoder.keyEdge(edge.down, edge.timeUs * 1000);
+        }
+        adapterBestNs = std::min(adapterBestNs, benchNowNs() - start);
+        adapter = counts;
+    }
+
+    double edgeCount = double(std::max<size_t>(edges.size(), 1));
+    double coreNs = coreBestNs / edgeCount;
+    double adapterNs = adapterBestNs / edgeCount;
+    std::printf("Replayed %zu key edges (%.1f h of keying), best of %d runs\n", edges.size(), hours, RUNS);
+    std::printf("  DecoderEngine callback: %8.1f ns/edge, %llu events, %llu characters\n", coreNs,
+                static_cast<unsigned long long>(core.events), static_cast<unsigned long long>(core.characters));
+    std::printf("  MorseDecoder signals:   %8.1f ns/edge, %llu signals, %llu characters\n", adapterNs,
+                static_cast<unsigned long long>(adapter.events), static_cast<unsigned long long>(adapter.characters));
+    std::printf("  Per event:              %8.1f ns core, %.1f ns adapter\n",
+                coreBestNs / double(std::max<uint64_t>(core.events, 1)),
+                adapterBestNs / double(std::max<uint64_t>(adapter.events, 1)));
+    std::printf("  Adapter overhead:       %8.1f ns/edge (%.1fx)\n", adapterNs - coreNs,
+                coreNs > 0.0 ? adapterNs / coreNs : 0.0);
+
+    if (core.characters != adapter.characters) {
+        std::fprintf(stderr, "Character counts differ\n");
+        return 1;
+    }
+    return 0;
+}
+
+void collectEvent(const morse::Event& event, void *context) {
+    static_cast<std::vector<morse::Event> *>(context)->push_back(event);
+}
+
+// Headless: morse-decoder --bench-log [hours]
+// Decodes generated traffic, then feeds its events to a SessionLogger at
+// 1000x real time, plain and gzip, and reports what reached the disk. The
+// slowest logging call shows whether the producer ever waited on the writer.
+int runLogBench(int argc, char *argv[]) {
+    constexpr int64_t REPLAY_SPEED = 1000;
+    double hours = argc > 2 ? std::atof(argv[2]) : 1.0;
+    if (hours <= 0.0) {
+        std::fprintf(stderr, "--bench-log needs a positive number of hours\n");
+        return 2;
+    }
+    QCoreApplication app(argc, argv);
+
+    std::vector<morse::KeyEdge> edges = morse::HotPathReplay::generate(hours, 1);
+    std::vector<morse::Event> events;
+    morse::DecoderEngine engine(20);
+    engine.setCallback(&collectEvent, &events);
+    for (const morse::KeyEdge& edge : edges) {
+        if (edge.down) {
+            engine.keyDown(edge.timeUs);
+        } else {
+            engine.keyUp(edge.timeUs);
+        }
+    }
+    if (!edges.empty()) engine.flush(edges.back().timeUs);
+    if (events.empty()) return 1;
+
+    std::printf("Session log replay: %.1f h of keying at %lldx real time\n", hours,
+                static_cast<long long>(REPLAY_SPEED));
+    bool ok = true;
+    for (bool compress : {false, true}) {
+        if (compress && !SessionLogger::compressionAvailable()) {
+            std::printf("  gzip:  not built with zlib\n");
+            continue;
+        }
+        QString path = QDir::temp().filePath(compress ? "morse-decoder-log-bench.log.gz"
+                                                      : "morse-decoder-log-bench.log");
+        QFile::remove(path);
+        SessionLogger logger;
+        if (!logger.open(path, compress)) {
+            std::fprintf(stderr, "Cannot open %s\n", qPrintable(path));
+            return 2;
+        }
+
+        const int64_t firstUs = events.front().timestampUs;
+        const int64_t startNs = benchNowNs();
+        int64_t slowestCallNs = 0;
+        for (const morse::Event& event : events) {
+            int64_t dueNs = startNs + (event.timestampUs - firstUs) * 1000 / REPLAY_SPEED;
+            int64_t aheadNs = dueNs - benchNowNs();
+            if (aheadNs > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(aheadNs));
+
+            int64_t callNs = benchNowNs();
+            switch (event.type) {
+            case morse::EventType::Character:
+                logger.logCharacter(QChar(event.character), event.confidence);
+                break;
+            case morse::EventType::WordSpace:
+                logger.logWordSpace();
+                break;
+            case morse::EventType::DecodingError: {
+                char pattern[morse::Pattern::MAX_STRING];
+                int length = event.pattern.toString(pattern, sizeof(pattern));
+                logger.logError(QString::fromLatin1(pattern, length), event.confidence);
+                break;
+            }
+            case morse::EventType::Mark:
+                logger.logMark(event.durationUs / 1000, event.isDit);
+                break;
+            case morse::EventType::Space:
+                logger.logSpace(event.durationUs / 1000);
+                break;
+            case morse::EventType::SpeedChange:
+                logger.logSpeedChange(static_cast<int>(1200000 / event.unitUs), event.durationUs / 1000);
+                break;
+            default:
+                continue;
+            }
+            slowestCallNs = std::max(slowestCallNs, benchNowNs() - callNs);
+        }
+        const int64_t fedNs = benchNowNs();
+        logger.close();
+        const int64_t endNs = benchNowNs();
+
+        double seconds = std::max<int64_t>(endNs - startNs, 1) / 1e9;
+        std::printf("  %s %9.0f records/s, %9.0f bytes/s, %llu records, %llu bytes, %llu dropped, "
+                    "slowest call %.1f us, final flush %.1f ms\n",
+                    compress ? "gzip: " : "plain:",
+                    logger.recordsWritten() / seconds, logger.bytesWritten() / seconds,
+                    static_cast<unsigned long long>(logger.recordsWritten()),
+                    static_cast<unsigned long long>(logger.bytesWritten()),
+                    static_cast<unsigned long long>(logger.recordsDropped()),
+                    slowestCallNs / 1e3, (endNs - fedNs) / 1e6);
+        if (logger.recordsDropped() > 0) ok = false;
+        QFile::remove(path);
+    }
+    return ok ? 0 : 1;
+}
+}
+
+bool HeadlessModes::run(int argc, char *argv[], int *exitCode) {
+    if (argc < 2) return false;
+    const char *mode = argv[1];
+    if (std::strcmp(mode, "--batch") == 0) {
+        *exitCode = runBatch(argc, argv);
+    } else if (std::strcmp(mode, "--check-allocations") == 0) {
+        *exitCode = runAllocationCheck(argc, argv);
+    } else if (std::strcmp(mode, "--bench") == 0) {
+        *exitCode = runBench(argc, argv);
+    } else if (std::strcmp(mode, "--bench-log") == 0) {
+        *exitCode = runLogBench(argc, argv);
+    } else {
+        return false;
+    }
+    return true;
+}
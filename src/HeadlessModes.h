@@ -0,0 +1,13 @@
+#ifndef HEADLESSMODES_H
+#define HEADLESSMODES_H
+
+// Command-line modes that run without a window: --batch, --check-allocations,
+// --bench and --bench-log. Each is selected by the first argument and
+// returns before any QApplication exists.
+class HeadlessModes {
+public:
+    // False when argv[1] names no headless mode and the GUI should start
+    static bool run(int argc, char *argv[], int *exitCode);
+};
+
+#endif // HEADLESSMODES_H
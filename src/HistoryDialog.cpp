@@ -0,0 +1,71 @@
+#include "HistoryDialog.h"
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+HistoryDialog::HistoryDialog(const morse::HistoryStore *store, QWidget *parent)
+    : QDialog(parent)
+    , m_store(store)
+{
+    setWindowTitle("Search History");
+    resize(760, 480);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    m_queryEdit = new QLineEdit(this);
+    m_queryEdit->setPlaceholderText("Callsign or text");
+    m_queryEdit->setClearButtonEnabled(true);
+    layout->addWidget(m_queryEdit);
+
+    m_resultsTable = new QTableWidget(0, 2, this);
+    m_resultsTable->setHorizontalHeaderLabels({"Heard", "Text"});
+    m_resultsTable->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    m_resultsTable->horizontalHeader()->setStretchLastSection(true);
+    m_resultsTable->verticalHeader()->hide();
+    m_resultsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_resultsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_resultsTable->setFont(QFont("Monospace", 10));
+    layout->addWidget(m_resultsTable, 1);
+
+    m_statusLabel = new QLabel(this);
+    layout->addWidget(m_statusLabel);
+
+    // Short queries fall back to a scan, so only search those on Enter
+    connect(m_queryEdit, &QLineEdit::returnPressed, this, &HistoryDialog::search);
+    connect(m_queryEdit, &QLineEdit::textChanged, this, [this](const QString& text) {
+        if (text.trimmed().size() >= 3) search();
+    });
+}
+
+void HistoryDialog::search() {
+    QString query = m_queryEdit->text().trimmed();
+    m_resultsTable->setRowCount(0);
+    if (query.isEmpty()) {
+        m_statusLabel->clear();
+        return;
+    }
+    if (!m_store->isOpen()) {
+        m_statusLabel->setText("History is not being recorded (Tools → Keep Searchable History)");
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<morse::HistoryMatch> matches = m_store->search(query.toStdString(), MAX_RESULTS);
+    double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    m_resultsTable->setRowCount(static_cast<int>(matches.size()));
+    for (int row = 0; row < static_cast<int>(matches.size()); ++row) {
+        const morse::HistoryMatch& match = matches[row];
+        QString heard = QDateTime::fromMSecsSinceEpoch(match.epochMs).toString("yyyy-MM-dd HH:mm:ss");
+        m_resultsTable->setItem(row, 0, new QTableWidgetItem(heard));
+        m_resultsTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(match.context)));
+    }
+
+    m_statusLabel->setText(QString("%1%2 matches in %3 ms, %4 KiB in %5 segment(s)")
+                               .arg(matches.size())
+                               .arg(matches.size() >= MAX_RESULTS ? "+" : "")
+                               .arg(elapsedMs, 0, 'f', 2)
+                               .arg(m_store->totalBytes() / 1024)
+                               .arg(m_store->segmentCount()));
+}
@@ -0,0 +1,29 @@
+#ifndef HISTORYDIALOG_H
+#define HISTORYDIALOG_H
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QTableWidget>
+#include <QLabel>
+#include "core/HistoryStore.h"
+
+// Searches the decoded-traffic history for a callsign or phrase
+class HistoryDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit HistoryDialog(const morse::HistoryStore *store, QWidget *parent = nullptr);
+
+private slots:
+    void search();
+
+private:
+    static constexpr size_t MAX_RESULTS = 500;
+
+    const morse::HistoryStore *m_store;
+    QLineEdit *m_queryEdit;
+    QTableWidget *m_resultsTable;
+    QLabel *m_statusLabel;
+};
+
+#endif // HISTORYDIALOG_H
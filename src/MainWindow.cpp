@@ -1,4 +1,6 @@
 #include "MainWindow.h"
+#include "StartupProfiler.h"
+#include "core/Trace.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
@@ -7,22 +9,70 @@
 #include <QApplication>
 #include <QMessageBox>
 #include <QStatusBar>
+#include <QDockWidget>
+#include <QMenuBar>
+#include <QFileDialog>
+#include <QDir>
+#include <QFile>
+#include <QDateTime>
+#include <QStandardPaths>
+
+namespace {
+const QString SPACE_TEXT = QStringLiteral(" ");
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_serialHandler(new SerialHandler(this))
     , m_morseDecoder(new MorseDecoder(this))
+    , m_sessionLogger(new SessionLogger(this))
+    , m_deviceMonitor(new DeviceMonitor(this))
+    , m_eventPublisher(new EventPublisher(this))
+    , m_audioInput(new AudioInput(this))
+    , m_practiceDialog(nullptr)
+    , m_historyDialog(nullptr)
+    , m_historyFailing(false)
+    , m_statusTimer(new QTimer(this))
     , m_settings(new QSettings("MorseDecoder", "MorseKeyDecoder", this))
 {
+    m_insertText.reserve(16); // Reused for every decoded character
+    m_currentLength = 0;
+    m_currentBits = 0;
+    for (int length = 0; length <= morse::Pattern::MAX_ELEMENTS; ++length) {
+        for (unsigned bits = 0; bits < (1u << length); ++bits) {
+            QString& text = m_patternTexts[(1u << length) | bits];
+            for (int i = 0; i < length; ++i) {
+                text += QLatin1Char((bits >> i) & 1 ? '-' : '.');
+            }
+        }
+    }
+    // Doubtful characters shade from orange towards red as confidence drops
+    for (int percent = 0; percent < CONFIDENCE_FORMATS; ++percent) {
+        float confidence = percent / 100.0f;
+        m_confidenceFormats[percent].setForeground(
+            QColor::fromHsvF(40.0f / 360.0f * confidence / LOW_CONFIDENCE, 1.0f, 0.85f));
+        m_confidenceFormats[percent].setToolTip(QString("Confidence %1%").arg(percent));
+    }
     setupUi();
     setupConnections();
+    StartupProfiler::mark("window setup");
     loadSettings();
+    StartupProfiler::mark("settings");
+
+    // Port enumeration runs on a worker thread and audio opens after the
+    // window is up, so neither delays the first paint
     refreshPorts();
+    m_deviceMonitor->start();
+    QTimer::singleShot(0, m_serialHandler, &SerialHandler::prepareAudio);
+
+    m_statusTimer->start(1000);
 }
 
 MainWindow::~MainWindow() {
     saveSettings();
+    m_sessionLogger->close();
 }
+
 void MainWindow::setupUi() {
     setWindowTitle("Morse Key Decoder");
     setMinimumSize(600, 500);
@@ -51,6 +101,17 @@ void MainWindow::setupUi() {
     serialLayout->addRow("Port:", portLayout);
     serialLayout->addRow("Baud:", m_baudCombo);
 
+    m_realtimeCheck = new QCheckBox("Real-time capture", this);
+    m_realtimeCheck->setToolTip("Run the key capture thread with SCHED_FIFO priority and locked memory "
+                                "(applied on the next connect)");
+    serialLayout->addRow(m_realtimeCheck);
+
+    m_autoReconnectCheck = new QCheckBox("Auto-reconnect", this);
+    m_autoReconnectCheck->setChecked(true);
+    m_autoReconnectCheck->setToolTip("Reopen the same adapter when it reappears after a dropout, "
+                                     "keeping the decoder's timing");
+    serialLayout->addRow(m_autoReconnectCheck);
+
     m_connectBtn = new QPushButton("Connect", this);
     serialLayout->addRow(m_connectBtn);
 
@@ -81,6 +142,37 @@ void MainWindow::setupUi() {
     m_volumeSlider->setValue(50);
     morseLayout->addRow("Volume:", m_volumeSlider);
 
+    m_sidetoneBackendCombo = new QComboBox(this);
+    m_sidetoneBackendCombo->addItem("Qt Multimedia", "qt");
+    if (AlsaSidetone::isAvailable()) {
+        m_sidetoneBackendCombo->addItem("ALSA (direct)", "alsa");
+        m_sidetoneBackendCombo->addItem("PipeWire (low quantum)", "pipewire");
+    }
+    m_sidetoneBackendCombo->setToolTip("Direct outputs play from a real-time thread with a few small periods "
+                                       "and fall back to Qt Multimedia if the device cannot be opened");
+    morseLayout->addRow("Output:", m_sidetoneBackendCombo);
+
+    m_minMarkSpin = new QSpinBox(this);
+    m_minMarkSpin->setRange(0, 50);
+    m_minMarkSpin->setValue(4);
+    m_minMarkSpin->setSuffix(" ms");
+    m_minMarkSpin->setToolTip("Key-down pulses shorter than this are rejected as glitches");
+    m_minSpaceSpin = new QSpinBox(this);
+    m_minSpaceSpin->setRange(0, 50);
+    m_minSpaceSpin->setValue(4);
+    m_minSpaceSpin->setSuffix(" ms");
+    m_minSpaceSpin->setToolTip("Key-up gaps shorter than this are rejected as contact bounce");
+
+    QHBoxLayout *debounceLayout = new QHBoxLayout();
+    debounceLayout->addWidget(new QLabel("Mark", this));
+    debounceLayout->addWidget(m_minMarkSpin);
+    debounceLayout->addWidget(new QLabel("Space", this));
+    debounceLayout->addWidget(m_minSpaceSpin);
+    morseLayout->addRow("Debounce:", debounceLayout);
+
+    m_adaptiveDebounceCheck = new QCheckBox("Scale debounce with speed", this);
+    morseLayout->addRow(m_adaptiveDebounceCheck);
+
     topLayout->addWidget(morseGroup);
 
     mainLayout->addLayout(topLayout);
@@ -107,6 +199,9 @@ void MainWindow::setupUi() {
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     m_clearBtn = new QPushButton("Clear", this);
     m_copyBtn = new QPushButton("Copy", this);
+    m_sessionLogCheck = new QCheckBox("Log session", this);
+    m_sessionLogCheck->setToolTip("Write timestamped characters, errors and element timings to disk");
+    buttonLayout->addWidget(m_sessionLogCheck);
     buttonLayout->addStretch();
     buttonLayout->addWidget(m_clearBtn);
     buttonLayout->addWidget(m_copyBtn);
@@ -114,9 +209,65 @@ void MainWindow::setupUi() {
 
     mainLayout->addWidget(decodedGroup, 1);
 
+    // Operator statistics, hidden until opened from the View menu
+    QDockWidget *statsDock = new QDockWidget("Statistics", this);
+    statsDock->setObjectName("statsDock");
+    m_statsPanel = new StatsPanel(statsDock);
+    statsDock->setWidget(m_statsPanel);
+    addDockWidget(Qt::RightDockWidgetArea, statsDock);
+    statsDock->hide();
+
+    QDockWidget *exchangesDock = new QDockWidget("Exchanges", this);
+    exchangesDock->setObjectName("exchangesDock");
+    m_exchangePanel = new ExchangePanel(exchangesDock);
+    exchangesDock->setWidget(m_exchangePanel);
+    addDockWidget(Qt::RightDockWidgetArea, exchangesDock);
+    exchangesDock->hide();
+
+    // Audio input decoding with its waterfall
+    QDockWidget *waterfallDock = new QDockWidget("Waterfall", this);
+    waterfallDock->setObjectName("waterfallDock");
+    m_waterfallPanel = new WaterfallPanel(m_audioInput, waterfallDock);
+    waterfallDock->setWidget(m_waterfallPanel);
+    addDockWidget(Qt::BottomDockWidgetArea, waterfallDock);
+    waterfallDock->hide();
+
+    QMenu *viewMenu = menuBar()->addMenu("&View");
+    viewMenu->addAction(statsDock->toggleViewAction());
+    viewMenu->addAction(exchangesDock->toggleViewAction());
+    viewMenu->addAction(waterfallDock->toggleViewAction());
+    QAction *searchHistoryAction = viewMenu->addAction("Search History...");
+    searchHistoryAction->setShortcut(QKeySequence::Find);
+    connect(searchHistoryAction, &QAction::triggered, this, &MainWindow::onSearchHistoryTriggered);
+
+    QMenu *toolsMenu = menuBar()->addMenu("&Tools");
+    m_publishEventsAction = toolsMenu->addAction("Publish Events to Local Subscribers");
+    m_publishEventsAction->setCheckable(true);
+    m_historyAction = toolsMenu->addAction("Keep Searchable History");
+    m_historyAction->setCheckable(true);
+    toolsMenu->addSeparator();
+    QAction *practiceAction = toolsMenu->addAction("Code Practice...");
+    connect(practiceAction, &QAction::triggered, this, &MainWindow::onPracticeTriggered);
+#ifdef MORSE_TRACING
+    toolsMenu->addSeparator();
+    QAction *recordTraceAction = toolsMenu->addAction("Record Trace");
+    recordTraceAction->setCheckable(true);
+    connect(recordTraceAction, &QAction::toggled, this, &MainWindow::onRecordTraceToggled);
+    QAction *saveTraceAction = toolsMenu->addAction("Save Trace...");
+    connect(saveTraceAction, &QAction::triggered, this, &MainWindow::onSaveTraceTriggered);
+#endif
+
     // Status bar
     m_statusLabel = new QLabel("Disconnected", this);
     statusBar()->addWidget(m_statusLabel);
+    m_glitchLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_glitchLabel);
+    m_latencyLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_latencyLabel);
+    m_outageLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_outageLabel);
+    m_sidetoneLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_sidetoneLabel);
 }
 
 void MainWindow::setupConnections() {
@@ -130,21 +281,70 @@ void MainWindow::setupConnections() {
     connect(m_sidetoneCheck, &QCheckBox::toggled, this, &MainWindow::onSidetoneToggled);
     connect(m_sidetoneFreqSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::onSidetoneFreqChanged);
     connect(m_volumeSlider, &QSlider::valueChanged, this, &MainWindow::onSidetoneVolumeChanged);
+    connect(m_sidetoneBackendCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &MainWindow::onSidetoneBackendChanged);
+    connect(m_minMarkSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::onDebounceChanged);
+    connect(m_minSpaceSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::onDebounceChanged);
+    connect(m_adaptiveDebounceCheck, &QCheckBox::toggled, this, &MainWindow::onAdaptiveDebounceToggled);
+    connect(m_realtimeCheck, &QCheckBox::toggled, this, &MainWindow::onRealtimeToggled);
+    connect(m_autoReconnectCheck, &QCheckBox::toggled, this, &MainWindow::onAutoReconnectToggled);
+    connect(m_sessionLogCheck, &QCheckBox::toggled, this, &MainWindow::onSessionLogToggled);
+    connect(m_publishEventsAction, &QAction::toggled, this, &MainWindow::onPublishEventsToggled);
+    connect(m_historyAction, &QAction::toggled, this, &MainWindow::onHistoryToggled);
+    connect(m_statusTimer, &QTimer::timeout, this, &MainWindow::updateStatusMetrics);
 
     // Serial handler connections
     connect(m_serialHandler, &SerialHandler::connected, this, &MainWindow::onSerialConnected);
     connect(m_serialHandler, &SerialHandler::disconnected, this, &MainWindow::onSerialDisconnected);
     connect(m_serialHandler, &SerialHandler::errorOccurred, this, &MainWindow::onSerialError);
-
-    connect(m_serialHandler, &SerialHandler::keyDown, m_morseDecoder, &MorseDecoder::keyDown);
-    connect(m_serialHandler, &SerialHandler::keyUp, m_morseDecoder, &MorseDecoder::keyUp);
+    connect(m_serialHandler, &SerialHandler::portsEnumerated, this, &MainWindow::onPortsEnumerated);
+    connect(m_serialHandler, &SerialHandler::connectionLost, this, &MainWindow::onConnectionLost);
+    connect(m_serialHandler, &SerialHandler::reconnected, this, &MainWindow::onReconnected);
+    connect(m_serialHandler, &SerialHandler::reconnectAttemptFailed, this, &MainWindow::onReconnectAttemptFailed);
+
+    // Hotplug
+    connect(m_deviceMonitor, &DeviceMonitor::deviceAdded, m_serialHandler, &SerialHandler::onDeviceAppeared);
+    connect(m_deviceMonitor, &DeviceMonitor::deviceAdded, this, &MainWindow::refreshPorts);
+    connect(m_deviceMonitor, &DeviceMonitor::deviceRemoved, this, &MainWindow::refreshPorts);
+
+    connect(m_serialHandler, &SerialHandler::keyEdge, m_morseDecoder, &MorseDecoder::keyEdge);
+    connect(m_audioInput, &AudioInput::keyEdge, m_morseDecoder, &MorseDecoder::keyEdge);
     connect(m_serialHandler, &SerialHandler::elementReceived, m_morseDecoder, &MorseDecoder::processElement);
+    connect(m_serialHandler, &SerialHandler::keyInterrupted, m_morseDecoder, &MorseDecoder::abortElement);
 
     // Decoder connections
     connect(m_morseDecoder, &MorseDecoder::elementDecoded, this, &MainWindow::onElementDecoded);
     connect(m_morseDecoder, &MorseDecoder::characterDecoded, this, &MainWindow::onCharacterDecoded);
     connect(m_morseDecoder, &MorseDecoder::wordSpaceDetected, this, &MainWindow::onWordSpaceDetected);
     connect(m_morseDecoder, &MorseDecoder::decodingError, this, &MainWindow::onDecodingError);
+    connect(m_morseDecoder, &MorseDecoder::speedChanged, this, &MainWindow::onSpeedChanged);
+    connect(m_morseDecoder, &MorseDecoder::timingChanged, m_serialHandler, &SerialHandler::setDebounceUnitTime);
+
+    // Session log
+    connect(m_morseDecoder, &MorseDecoder::characterDecoded, m_sessionLogger, &SessionLogger::logCharacter);
+    connect(m_morseDecoder, &MorseDecoder::wordSpaceDetected, m_sessionLogger, &SessionLogger::logWordSpace);
+    connect(m_morseDecoder, &MorseDecoder::decodingError, m_sessionLogger, &SessionLogger::logError);
+    connect(m_morseDecoder, &MorseDecoder::markMeasured, m_sessionLogger, &SessionLogger::logMark);
+    connect(m_morseDecoder, &MorseDecoder::spaceMeasured, m_sessionLogger, &SessionLogger::logSpace);
+    connect(m_morseDecoder, &MorseDecoder::speedChanged, m_sessionLogger, &SessionLogger::logSpeedChange);
+
+    // Local event stream
+    connect(m_serialHandler, &SerialHandler::keyEdge, m_eventPublisher, &EventPublisher::publishKeyEdge);
+    connect(m_audioInput, &AudioInput::keyEdge, m_eventPublisher, &EventPublisher::publishKeyEdge);
+    connect(m_morseDecoder, &MorseDecoder::elementDecoded, m_eventPublisher, &EventPublisher::publishElement);
+    connect(m_morseDecoder, &MorseDecoder::characterDecoded, m_eventPublisher, &EventPublisher::publishCharacter);
+    connect(m_morseDecoder, &MorseDecoder::wordSpaceDetected, m_eventPublisher, &EventPublisher::publishWordSpace);
+    connect(m_morseDecoder, &MorseDecoder::decodingError, m_eventPublisher, &EventPublisher::publishError);
+
+    // Operator statistics
+    connect(m_morseDecoder, &MorseDecoder::markMeasured, m_statsPanel, &StatsPanel::addMark);
+    connect(m_morseDecoder, &MorseDecoder::spaceMeasured, m_statsPanel, &StatsPanel::addSpace);
+    connect(m_morseDecoder, &MorseDecoder::characterDecoded, m_statsPanel, &StatsPanel::addCharacter);
+    connect(m_morseDecoder, &MorseDecoder::timingChanged, m_statsPanel, &StatsPanel::setUnitTime);
+
+    connect(m_morseDecoder, &MorseDecoder::characterDecoded, m_exchangePanel, &ExchangePanel::addCharacter);
+    connect(m_morseDecoder, &MorseDecoder::wordSpaceDetected, m_exchangePanel, &ExchangePanel::addWordSpace);
+    connect(m_morseDecoder, &MorseDecoder::decodingError, m_exchangePanel, &ExchangePanel::addError);
 }
 
 void MainWindow::loadSettings() {
@@ -152,15 +352,27 @@ void MainWindow::loadSettings() {
     m_sidetoneCheck->setChecked(m_settings->value("sidetone_enabled", true).toBool());
     m_sidetoneFreqSpin->setValue(m_settings->value("sidetone_freq", 600).toInt());
     m_volumeSlider->setValue(m_settings->value("sidetone_volume", 50).toInt());
+    int backendIndex = m_sidetoneBackendCombo->findData(m_settings->value("sidetone_backend", "qt").toString());
+    m_sidetoneBackendCombo->setCurrentIndex(qMax(0, backendIndex));
     m_baudCombo->setCurrentText(m_settings->value("baud_rate", "9600").toString());
-
-    QString lastPort = m_settings->value("last_port").toString();
-    if (!lastPort.isEmpty()) {
-        int idx = m_portCombo->findText(lastPort);
-        if (idx >= 0) {
-            m_portCombo->setCurrentIndex(idx);
-        }
-    }
+    m_minMarkSpin->setValue(m_settings->value("debounce_mark_ms", 4).toInt());
+    m_minSpaceSpin->setValue(m_settings->value("debounce_space_ms", 4).toInt());
+    m_adaptiveDebounceCheck->setChecked(m_settings->value("debounce_adaptive", false).toBool());
+    m_realtimeCheck->setChecked(m_settings->value("realtime_enabled", false).toBool());
+    m_autoReconnectCheck->setChecked(m_settings->value("auto_reconnect", true).toBool());
+    m_sessionLogCheck->setChecked(m_settings->value("session_log_enabled", false).toBool());
+    m_publishEventsAction->setChecked(m_settings->value("publish_events", false).toBool());
+    m_historyAction->setChecked(m_settings->value("history_enabled", true).toBool());
+    QString exchangeFormat = m_settings->value("exchange_format", "serial").toString();
+    m_exchangePanel->setNumberFormat(exchangeFormat == "cq_zone" ? morse::ExchangeNumber::CqZone
+                                     : exchangeFormat == "itu_zone" ? morse::ExchangeNumber::ItuZone
+                                     : morse::ExchangeNumber::Serial);
+    QString exchangePatterns = m_settings->value("exchange_patterns_file").toString();
+    if (!exchangePatterns.isEmpty()) m_exchangePanel->loadPatterns(exchangePatterns);
+    m_waterfallPanel->setDeviceId(m_settings->value("audio_input_device").toByteArray());
+    m_waterfallPanel->setToneFrequency(m_settings->value("audio_tone_freq", 700).toInt());
+    applyRealtimeConfig();
+    onSidetoneBackendChanged();
 }
 
 void MainWindow::saveSettings() {
@@ -168,19 +380,53 @@ void MainWindow::saveSettings() {
     m_settings->setValue("sidetone_enabled", m_sidetoneCheck->isChecked());
     m_settings->setValue("sidetone_freq", m_sidetoneFreqSpin->value());
     m_settings->setValue("sidetone_volume", m_volumeSlider->value());
+    m_settings->setValue("sidetone_backend", m_sidetoneBackendCombo->currentData().toString());
     m_settings->setValue("baud_rate", m_baudCombo->currentText());
-    m_settings->setValue("last_port", m_portCombo->currentText());
+    m_settings->setValue("debounce_mark_ms", m_minMarkSpin->value());
+    m_settings->setValue("debounce_space_ms", m_minSpaceSpin->value());
+    m_settings->setValue("debounce_adaptive", m_adaptiveDebounceCheck->isChecked());
+    m_settings->setValue("realtime_enabled", m_realtimeCheck->isChecked());
+    m_settings->setValue("auto_reconnect", m_autoReconnectCheck->isChecked());
+    m_settings->setValue("session_log_enabled", m_sessionLogCheck->isChecked());
+    m_settings->setValue("publish_events", m_publishEventsAction->isChecked());
+    m_settings->setValue("history_enabled", m_historyAction->isChecked());
+    switch (m_exchangePanel->numberFormat()) {
+    case morse::ExchangeNumber::Serial: m_settings->setValue("exchange_format", "serial"); break;
+    case morse::ExchangeNumber::CqZone: m_settings->setValue("exchange_format", "cq_zone"); break;
+    case morse::ExchangeNumber::ItuZone: m_settings->setValue("exchange_format", "itu_zone"); break;
+    }
+    if (!m_waterfallPanel->deviceId().isEmpty()) {
+        m_settings->setValue("audio_input_device", m_waterfallPanel->deviceId());
+    }
+    m_settings->setValue("audio_tone_freq", qRound(m_audioInput->toneFrequency()));
+    QString port = m_portCombo->currentText();
+    if (!port.isEmpty() && port != "No ports found") {
+        m_settings->setValue("last_port", port);
+    }
 }
 
 void MainWindow::refreshPorts() {
+    m_serialHandler->enumeratePortsAsync();
+}
+
+void MainWindow::onPortsEnumerated(const QStringList& ports) {
+    // Keep the current choice across rescans; fall back to the saved port
+    QString selected = m_portCombo->currentText();
+    if (selected.isEmpty() || selected == "No ports found") {
+        selected = m_settings->value("last_port").toString();
+    }
+
     m_portCombo->clear();
-    QStringList ports = m_serialHandler->availablePorts();
     m_portCombo->addItems(ports);
 
     if (ports.isEmpty()) {
         m_portCombo->addItem("No ports found");
-        m_connectBtn->setEnabled(false);
+        m_connectBtn->setEnabled(m_serialHandler->isConnected());
     } else {
+        int idx = m_portCombo->findText(selected);
+        if (idx >= 0) {
+            m_portCombo->setCurrentIndex(idx);
+        }
         m_connectBtn->setEnabled(true);
     }
 }
@@ -190,10 +436,11 @@ void MainWindow::updateConnectionState(bool connected) {
     m_portCombo->setEnabled(!connected);
     m_baudCombo->setEnabled(!connected);
     m_refreshBtn->setEnabled(!connected);
+    m_realtimeCheck->setEnabled(!connected);
 }
 
 void MainWindow::onConnectClicked() {
-    if (m_serialHandler->isConnected()) {
+    if (m_serialHandler->isConnected() || m_serialHandler->isReconnecting()) {
         m_serialHandler->disconnect();
     } else {
         QString port = m_portCombo->currentText();
@@ -211,8 +458,10 @@ void MainWindow::onRefreshPortsClicked() {
 
 void MainWindow::onClearClicked() {
     m_decodedText->clear();
-    m_currentMorse->clear();
+    clearCurrentMorse();
     m_morseDecoder->reset();
+    m_statsPanel->reset();
+    m_exchangePanel->reset();
 }
 
 void MainWindow::onCopyClicked() {
@@ -232,33 +481,95 @@ void MainWindow::onSerialDisconnected() {
     m_statusLabel->setText("Disconnected");
 }
 
+void MainWindow::onConnectionLost() {
+    // Not modal: the device usually comes back within a second
+    m_statusLabel->setText("Device lost, waiting to reconnect...");
+}
+
+void MainWindow::onReconnectAttemptFailed(const QString& error) {
+    m_statusLabel->setText("Device lost, waiting to reconnect (" + error + ")...");
+}
+
+void MainWindow::onReconnected(qint64 outageMs) {
+    m_statusLabel->setText(QString("Reconnected to %1 after %2 ms")
+                               .arg(m_serialHandler->portName())
+                               .arg(outageMs));
+}
+
+void MainWindow::onAutoReconnectToggled(bool enabled) {
+    m_serialHandler->setAutoReconnect(enabled);
+}
+
 void MainWindow::onSerialError(const QString& error) {
     m_statusLabel->setText("Error: " + error);
     QMessageBox::warning(this, "Serial Error", error);
 }
 
 void MainWindow::onElementDecoded(const QString& element) {
-    m_currentMorse->setText(m_currentMorse->text() + element);
+    MORSE_TRACE_SCOPE("MainWindow::onElementDecoded");
+    if (m_currentLength < morse::Pattern::MAX_ELEMENTS) {
+        if (element == QLatin1String("-")) m_currentBits |= 1u << m_currentLength;
+        ++m_currentLength;
+        m_currentMorse->setText(m_patternTexts[(1u << m_currentLength) | m_currentBits]);
+    } else {
+        // Longer than any character; rare enough to build the string
+        m_currentMorse->setText(m_currentMorse->text() + element);
+    }
 }
 
-void MainWindow::onCharacterDecoded(QChar character) {
-    m_decodedText->insertPlainText(QString(character));
-    trimDecodedText();
+void MainWindow::clearCurrentMorse() {
+    m_currentLength = 0;
+    m_currentBits = 0;
     m_currentMorse->clear();
 }
 
+void MainWindow::onCharacterDecoded(QChar character, float confidence) {
+    MORSE_TRACE_SCOPE("MainWindow::onCharacterDecoded");
+    appendHistory(character.toLatin1());
+    m_insertText.resize(0);
+    m_insertText.append(character);
+    insertDecoded(m_insertText, confidence);
+    trimDecodedText();
+    clearCurrentMorse();
+}
+
+void MainWindow::appendHistory(char character) {
+    bool stored = m_history.append(character, QDateTime::currentMSecsSinceEpoch());
+    if (!stored && !m_historyFailing) {
+        statusBar()->showMessage("History not saved: " + QString::fromStdString(m_history.lastError()), 8000);
+    }
+    m_historyFailing = !stored;
+}
+
 void MainWindow::onWordSpaceDetected() {
-    m_decodedText->insertPlainText(" ");
+    appendHistory(' ');
+    insertDecoded(SPACE_TEXT, 1.0f);
     trimDecodedText();
 }
 
-void MainWindow::onDecodingError(const QString& pattern) {
-    m_decodedText->insertPlainText("[" + pattern + "?]");
+void MainWindow::onDecodingError(const QString& pattern, float confidence) {
+    m_insertText.resize(0);
+    m_insertText.append('[').append(pattern).append(QLatin1String("?]"));
+    insertDecoded(m_insertText, confidence);
     trimDecodedText();
-    m_currentMorse->clear();
+    clearCurrentMorse();
+}
+
+void MainWindow::onSpeedChanged(int wpm) {
+    statusBar()->showMessage(QString("Speed change: %1 WPM").arg(wpm), 3000);
+}
+
+void MainWindow::insertDecoded(const QString& text, float confidence) {
+    if (confidence < LOW_CONFIDENCE) {
+        int percent = qBound(0, qRound(confidence * 100), CONFIDENCE_FORMATS - 1);
+        m_decodedText->textCursor().insertText(text, m_confidenceFormats[percent]);
+    } else {
+        m_decodedText->textCursor().insertText(text, m_plainFormat);
+    }
 }
 
 void MainWindow::trimDecodedText() {
+    MORSE_TRACE_SCOPE("MainWindow::trimDecodedText");
     // Trim text if it exceeds maximum line count to prevent memory issues
     QTextDocument *doc = m_decodedText->document();
     int lineCount = doc->lineCount();
@@ -294,3 +605,170 @@ void MainWindow::onSidetoneFreqChanged(int value) {
 void MainWindow::onSidetoneVolumeChanged(int value) {
     m_serialHandler->setSidetoneVolume(value / 100.0f);
 }
+
+void MainWindow::onSidetoneBackendChanged() {
+    // Device and period size are advanced settings without UI
+    AlsaSidetoneConfig config;
+    config.device = m_settings->value("sidetone_alsa_device", config.device).toString();
+    config.periodFrames = m_settings->value("sidetone_period_frames", config.periodFrames).toInt();
+    config.periods = m_settings->value("sidetone_periods", config.periods).toInt();
+
+    QString backend = m_sidetoneBackendCombo->currentData().toString();
+    SerialHandler::SidetoneBackend selected = SerialHandler::SidetoneBackend::QtMultimedia;
+    if (backend == "alsa") {
+        selected = SerialHandler::SidetoneBackend::Alsa;
+    } else if (backend == "pipewire") {
+        selected = SerialHandler::SidetoneBackend::PipeWire;
+    }
+    m_serialHandler->setSidetoneBackend(selected, config);
+}
+
+void MainWindow::onDebounceChanged() {
+    m_serialHandler->setDebounce(m_minMarkSpin->value(), m_minSpaceSpin->value());
+}
+
+void MainWindow::onAdaptiveDebounceToggled(bool enabled) {
+    m_serialHandler->setAdaptiveDebounce(enabled);
+}
+
+void MainWindow::onRealtimeToggled(bool enabled) {
+    Q_UNUSED(enabled);
+    applyRealtimeConfig();
+}
+
+void MainWindow::onSessionLogToggled(bool enabled) {
+    if (!enabled) {
+        m_sessionLogger->close();
+        return;
+    }
+
+    bool compress = m_settings->value("session_log_compress", false).toBool();
+    QString path = SessionLogger::defaultLogPath(compress && SessionLogger::compressionAvailable());
+    if (m_sessionLogger->open(path, compress)) {
+        statusBar()->showMessage("Logging to " + path, 5000);
+    } else {
+        statusBar()->showMessage("Cannot open session log " + path, 5000);
+        m_sessionLogCheck->setChecked(false);
+    }
+}
+
+void MainWindow::onPublishEventsToggled(bool enabled) {
+    if (!enabled) {
+        m_eventPublisher->stop();
+        return;
+    }
+
+    if (m_eventPublisher->start()) {
+        statusBar()->showMessage("Publishing events on " + m_eventPublisher->socketPath(), 5000);
+    } else {
+        statusBar()->showMessage("Cannot start the event publisher", 5000);
+        m_publishEventsAction->setChecked(false);
+    }
+}
+
+void MainWindow::onRecordTraceToggled(bool enabled) {
+    morse::Tracer::setEnabled(enabled);
+    statusBar()->showMessage(enabled ? "Recording trace" : "Trace recording stopped", 3000);
+}
+
+void MainWindow::onSaveTraceTriggered() {
+    QString defaultPath = QDir::homePath() + "/morse-trace.json";
+    QString path = QFileDialog::getSaveFileName(this, "Save Trace", defaultPath, "Chrome trace (*.json)");
+    if (path.isEmpty()) return;
+
+    morse::TraceDumpStats stats;
+    if (!morse::Tracer::writeChromeJson(QFile::encodeName(path).constData(), TRACE_WINDOW_NS, &stats)) {
+        statusBar()->showMessage("Cannot write " + path, 5000);
+        return;
+    }
+    statusBar()->showMessage(QString("Saved %1 events from %2 threads (tracing cost %3 ns/event, %4% of one core)")
+                                 .arg(stats.events)
+                                 .arg(stats.threads)
+                                 .arg(stats.eventCostNs, 0, 'f', 0)
+                                 .arg(stats.overheadPercent, 0, 'f', 3), 8000);
+}
+
+void MainWindow::onHistoryToggled(bool enabled) {
+    if (!enabled) {
+        m_history.close();
+        return;
+    }
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/history";
+    QDir().mkpath(dir);
+    m_historyFailing = false;
+    if (!m_history.open(QFile::encodeName(dir).toStdString())) {
+        statusBar()->showMessage("Cannot open history: " + QString::fromStdString(m_history.lastError()), 5000);
+        m_historyAction->setChecked(false);
+    } else if (!m_history.lastError().empty()) {
+        statusBar()->showMessage(QString::fromStdString(m_history.lastError()), 8000);
+    }
+}
+
+void MainWindow::onSearchHistoryTriggered() {
+    if (!m_historyDialog) {
+        m_historyDialog = new HistoryDialog(&m_history, this);
+    }
+    m_historyDialog->show();
+    m_historyDialog->raise();
+    m_historyDialog->activateWindow();
+}
+
+void MainWindow::onPracticeTriggered() {
+    if (!m_practiceDialog) {
+        m_practiceDialog = new PracticeDialog(this);
+    }
+    m_practiceDialog->show();
+    m_practiceDialog->raise();
+    m_practiceDialog->activateWindow();
+}
+
+void MainWindow::applyRealtimeConfig() {
+    // Priority, cores and memory locking are advanced settings without UI
+    RealtimeConfig config;
+    config.enabled = m_realtimeCheck->isChecked();
+    config.priority = m_settings->value("realtime_priority", 80).toInt();
+    config.cpus = RealtimeScheduler::parseCpuList(m_settings->value("realtime_cpus").toString());
+    config.lockMemory = m_settings->value("realtime_lock_memory", true).toBool();
+    m_serialHandler->setRealtimeConfig(config);
+}
+
+void MainWindow::updateStatusMetrics() {
+    m_glitchLabel->setText(QString("Glitches: %1").arg(m_serialHandler->rejectedGlitches()));
+
+    const LatencyStats *latency = m_serialHandler->captureLatency();
+    if (latency && latency->samples() > 0) {
+        m_latencyLabel->setText(QString("Capture: %1 | avg %2 µs, max %3 µs, >1 ms: %4, allocations: %5")
+                                    .arg(m_serialHandler->realtimeStatus().summary())
+                                    .arg(latency->meanNs() / 1000)
+                                    .arg(latency->maxNs() / 1000)
+                                    .arg(latency->overruns())
+                                    .arg(m_serialHandler->captureAllocations()));
+    } else {
+        m_latencyLabel->clear();
+    }
+
+    SerialHandler::OutageStats outages = m_serialHandler->outageStats();
+    if (outages.count > 0) {
+        m_outageLabel->setText(QString("Outages: %1 (last %2 ms, max %3 ms)")
+                                   .arg(outages.count)
+                                   .arg(outages.lastMs)
+                                   .arg(outages.maxMs));
+    }
+
+    QString sidetone = m_serialHandler->sidetoneDescription();
+    const LatencyStats *toneLatency = m_serialHandler->sidetoneLatency();
+    if (sidetone.isEmpty()) {
+        m_sidetoneLabel->clear();
+    } else if (toneLatency && toneLatency->samples() > 0) {
+        m_sidetoneLabel->setText(QString("Sidetone: %1 | buffer %2 ms, key to tone avg %3 ms, max %4 ms")
+                                     .arg(sidetone)
+                                     .arg(m_serialHandler->sidetoneBufferUs() / 1000.0, 0, 'f', 1)
+                                     .arg(toneLatency->meanNs() / 1e6, 0, 'f', 1)
+                                     .arg(toneLatency->maxNs() / 1e6, 0, 'f', 1));
+    } else {
+        m_sidetoneLabel->setText(QString("Sidetone: %1 | buffer %2 ms")
+                                     .arg(sidetone)
+                                     .arg(m_serialHandler->sidetoneBufferUs() / 1000.0, 0, 'f', 1));
+    }
+}
@@ -10,9 +10,22 @@
 #include <QCheckBox>
 #include <QSlider>
 #include <QSettings>
+#include <QAction>
+#include <QTimer>
+#include <QTextCharFormat>
 
 #include "SerialHandler.h"
 #include "MorseDecoder.h"
+#include "SessionLogger.h"
+#include "StatsPanel.h"
+#include "ExchangePanel.h"
+#include "AudioInput.h"
+#include "WaterfallPanel.h"
+#include "DeviceMonitor.h"
+#include "EventPublisher.h"
+#include "PracticeDialog.h"
+#include "HistoryDialog.h"
+#include "core/HistoryStore.h"
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -30,16 +43,34 @@ private slots:
     void onSerialConnected();
     void onSerialDisconnected();
     void onSerialError(const QString& error);
+    void onPortsEnumerated(const QStringList& ports);
+    void onConnectionLost();
+    void onReconnectAttemptFailed(const QString& error);
+    void onReconnected(qint64 outageMs);
+    void onAutoReconnectToggled(bool enabled);
+    void onPublishEventsToggled(bool enabled);
+    void onPracticeTriggered();
+    void onHistoryToggled(bool enabled);
+    void onSearchHistoryTriggered();
+    void onRecordTraceToggled(bool enabled);
+    void onSaveTraceTriggered();
 
     void onElementDecoded(const QString& element);
-    void onCharacterDecoded(QChar character);
+    void onCharacterDecoded(QChar character, float confidence);
     void onWordSpaceDetected();
-    void onDecodingError(const QString& pattern);
+    void onDecodingError(const QString& pattern, float confidence);
+    void onSpeedChanged(int wpm);
 
     void onWpmChanged(int value);
     void onSidetoneToggled(bool enabled);
     void onSidetoneFreqChanged(int value);
     void onSidetoneVolumeChanged(int value);
+    void onSidetoneBackendChanged();
+    void onDebounceChanged();
+    void onAdaptiveDebounceToggled(bool enabled);
+    void onRealtimeToggled(bool enabled);
+    void onSessionLogToggled(bool enabled);
+    void updateStatusMetrics();
 
 private:
     void setupUi();
@@ -48,33 +79,75 @@ private:
     void saveSettings();
     void refreshPorts();
     void updateConnectionState(bool connected);
+    void clearCurrentMorse();
+    void insertDecoded(const QString& text, float confidence);
     void trimDecodedText();
+    void appendHistory(char character);
+    void applyRealtimeConfig();
 
     // Serial and decoder
     SerialHandler *m_serialHandler;
     MorseDecoder *m_morseDecoder;
+    SessionLogger *m_sessionLogger;
+    DeviceMonitor *m_deviceMonitor;
+    EventPublisher *m_eventPublisher;
+    AudioInput *m_audioInput;
 
     // Constants for performance limits
     static constexpr int MAX_DISPLAY_LINES = 1000;
     static constexpr int TRIM_TO_LINES = 800;
+    static constexpr float LOW_CONFIDENCE = 0.5f; // Decoded text below this is highlighted
+    static constexpr qint64 TRACE_WINDOW_NS = 30000000000LL; // Last 30 s
 
     // UI Components
     QComboBox *m_portCombo;
     QComboBox *m_baudCombo;
     QPushButton *m_connectBtn;
     QPushButton *m_refreshBtn;
+    QCheckBox *m_realtimeCheck;
+    QCheckBox *m_autoReconnectCheck;
 
     QTextEdit *m_decodedText;
+    QString m_insertText;
     QLabel *m_currentMorse;
+    // Every element sequence up to MAX_ELEMENTS long, indexed by
+    // (1 << length) | bits, so showing the one in progress builds no string
+    QString m_patternTexts[2 << morse::Pattern::MAX_ELEMENTS];
+    int m_currentLength;
+    unsigned m_currentBits;
+    // Built once: one format per percent of confidence below LOW_CONFIDENCE
+    static constexpr int CONFIDENCE_FORMATS = 50;
+    QTextCharFormat m_plainFormat;
+    QTextCharFormat m_confidenceFormats[CONFIDENCE_FORMATS];
     QLabel *m_statusLabel;
 
     QSpinBox *m_wpmSpin;
     QCheckBox *m_sidetoneCheck;
     QSpinBox *m_sidetoneFreqSpin;
     QSlider *m_volumeSlider;
+    QComboBox *m_sidetoneBackendCombo;
+    QSpinBox *m_minMarkSpin;
+    QSpinBox *m_minSpaceSpin;
+    QCheckBox *m_adaptiveDebounceCheck;
 
     QPushButton *m_clearBtn;
     QPushButton *m_copyBtn;
+    QCheckBox *m_sessionLogCheck;
+    StatsPanel *m_statsPanel;
+    ExchangePanel *m_exchangePanel;
+    WaterfallPanel *m_waterfallPanel;
+    QAction *m_publishEventsAction;
+    PracticeDialog *m_practiceDialog;
+    QAction *m_historyAction;
+    HistoryDialog *m_historyDialog;
+    morse::HistoryStore m_history;
+    bool m_historyFailing; // Reported once until an append succeeds again
+
+    QLabel *m_glitchLabel;
+    QLabel *m_latencyLabel;
+    QLabel *m_outageLabel;
+    QLabel *m_sidetoneLabel;
+    QTimer *m_statusTimer;
 
     QSettings *m_settings;
 };
@@ -1,139 +1,172 @@
 #include "MorseDecoder.h"
+#include "core/Trace.h"
+#include <QSocketNotifier>
+#include <QDebug>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+// Shared, so emitting an element never allocates
+const QString DIT_STRING = QStringLiteral(".");
+const QString DAH_STRING = QStringLiteral("-");
+}
 
 MorseDecoder::MorseDecoder(QObject *parent)
     : QObject(parent)
-    , m_keyIsDown(false)
-    , m_wpm(20)
-    , m_ditAvg(60)  // Initial estimate at 20 WPM
-    , m_dahAvg(180)
-    , m_sampleCount(0)
+    , m_engine(20)
+    , m_boundaryFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC))
+    , m_boundaryNotifier(nullptr)
+    , m_lastReportedUnitMs(0)
 {
-    connect(&m_characterTimer, &QTimer::timeout, this, &MorseDecoder::onCharacterTimeout);
-    connect(&m_wordTimer, &QTimer::timeout, this, &MorseDecoder::onWordTimeout);
+    m_errorPattern.reserve(morse::Pattern::MAX_STRING);
+    m_engine.setCallback(&MorseDecoder::onEngineEvent, this);
+
+    if (m_boundaryFd >= 0) {
+        m_boundaryNotifier = new QSocketNotifier(m_boundaryFd, QSocketNotifier::Read, this);
+        connect(m_boundaryNotifier, &QSocketNotifier::activated, this, &MorseDecoder::onBoundaryTimeout);
+    } else {
+        qWarning() << "timerfd failed, character boundaries use a QTimer:" << strerror(errno);
+        connect(&m_boundaryTimer, &QTimer::timeout, this, &MorseDecoder::onBoundaryTimeout);
+        m_boundaryTimer.setSingleShot(true);
+        m_boundaryTimer.setTimerType(Qt::PreciseTimer);
+    }
 
-    m_characterTimer.setSingleShot(true);
-    m_wordTimer.setSingleShot(true);
+    m_lastReportedUnitMs = m_engine.unitUs() / 1000;
 }
 
-void MorseDecoder::setWpm(int wpm) {
-    m_wpm = qBound(5, wpm, 50);
-    qint64 unit = calculateUnitTime();
-    m_ditAvg = unit;
-    m_dahAvg = unit * 3;
+MorseDecoder::~MorseDecoder() {
+    delete m_boundaryNotifier;
+    if (m_boundaryFd >= 0) ::close(m_boundaryFd);
+}
+
+qint64 MorseDecoder::nowUs() {
+    // Same clock as the capture thread's edge timestamps
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-qint64 MorseDecoder::calculateUnitTime() const {
-    // PARIS standard: "PARIS" = 50 units
-    // At X WPM, we send X times "PARIS" per minute
-    // So unit time = 60000ms / (50 * WPM)
-    return 60000 / (50 * m_wpm);
+void MorseDecoder::setWpm(int wpm) {
+    m_engine.setWpm(wpm);
 }
 
 void MorseDecoder::reset() {
-    m_currentPattern.clear();
-    m_characterTimer.stop();
-    m_wordTimer.stop();
-    m_keyIsDown = false;
-    m_sampleCount = 0;
-
-    qint64 unit = calculateUnitTime();
-    m_ditAvg = unit;
-    m_dahAvg = unit * 3;
+    m_engine.reset();
+    scheduleBoundary();
 }
 
 void MorseDecoder::keyDown() {
-    if (m_keyIsDown) return;
-
-    m_keyIsDown = true;
-    m_keyTimer.start();
-    m_characterTimer.stop();
-    m_wordTimer.stop();
+    m_engine.keyDown(nowUs());
+    scheduleBoundary();
 }
 
 void MorseDecoder::keyUp() {
-    if (!m_keyIsDown) return;
-
-    m_keyIsDown = false;
-    qint64 duration = m_keyTimer.elapsed();
-    processKeyDuration(duration);
-
-    // Start timers for character and word boundaries
-    qint64 unit = (m_ditAvg + m_dahAvg / 3) / 2;
-    m_characterTimer.start(unit * 3);  // Character gap = 3 units
-    m_wordTimer.start(unit * 7);       // Word gap = 7 units
+    m_engine.keyUp(nowUs());
+    scheduleBoundary();
 }
 
-void MorseDecoder::processKeyDuration(qint64 duration) {
-    // Determine if dit or dah based on threshold
-    qint64 threshold = (m_ditAvg + m_dahAvg) / 2;
-    bool isDit = duration < threshold;
-
-    // Update adaptive timing
-    updateTimingAverages(duration, isDit);
-
-    // Add to pattern
-    if (isDit) {
-        m_currentPattern += ".";
-        emit elementDecoded(".");
+void MorseDecoder::keyEdge(bool down, qint64 timestampNs) {
+    MORSE_TRACE_SCOPE("MorseDecoder::keyEdge");
+    qint64 timeUs = timestampNs / 1000;
+    if (down) {
+        m_engine.keyDown(timeUs);
     } else {
-        m_currentPattern += "-";
-        emit elementDecoded("-");
+        m_engine.keyUp(timeUs);
     }
+    scheduleBoundary();
 }
 
 void MorseDecoder::processElement(bool isDit) {
-    // For character mode where device sends elements directly
-    if (isDit) {
-        m_currentPattern += ".";
-        emit elementDecoded(".");
-    } else {
-        m_currentPattern += "-";
-        emit elementDecoded("-");
-    }
-
-    // Reset character timeout
-    qint64 unit = calculateUnitTime();
-    m_characterTimer.start(unit * 3);
-    m_wordTimer.start(unit * 7);
+    m_engine.element(isDit, nowUs());
+    scheduleBoundary();
 }
 
-void MorseDecoder::updateTimingAverages(qint64 duration, bool isDit) {
-    // Exponential moving average for adaptive timing
-    const double alpha = (m_sampleCount < 10) ? 0.5 : 0.2;
-
-    if (isDit) {
-        m_ditAvg = static_cast<qint64>(alpha * duration + (1 - alpha) * m_ditAvg);
-    } else {
-        m_dahAvg = static_cast<qint64>(alpha * duration + (1 - alpha) * m_dahAvg);
-    }
-
-    m_sampleCount++;
+void MorseDecoder::abortElement() {
+    m_engine.abortElement();
+    scheduleBoundary();
 }
 
-void MorseDecoder::onCharacterTimeout() {
-    finalizeCharacter();
+void MorseDecoder::onBoundaryTimeout() {
+    MORSE_TRACE_SCOPE("MorseDecoder::onBoundaryTimeout");
+    if (m_boundaryFd >= 0) {
+        uint64_t expirations;
+        ssize_t got = ::read(m_boundaryFd, &expirations, sizeof(expirations));
+        Q_UNUSED(got);
+    }
+    qint64 now = nowUs();
+#ifdef MORSE_TRACING
+    if (m_engine.nextDeadlineUs() != morse::DecoderEngine::NO_DEADLINE) {
+        MORSE_TRACE_COUNTER("boundary timer late us", now - m_engine.nextDeadlineUs());
+    }
+#endif
+    m_engine.poll(now);
+    scheduleBoundary();
 }
 
-void MorseDecoder::onWordTimeout() {
-    m_characterTimer.stop();
-
-    if (!m_currentPattern.isEmpty()) {
-        finalizeCharacter();
+void MorseDecoder::scheduleBoundary() {
+    qint64 deadline = m_engine.nextDeadlineUs();
+    if (m_boundaryFd >= 0) {
+        // Zero disarms; deadlines already passed fire at once
+        itimerspec spec{};
+        if (deadline != morse::DecoderEngine::NO_DEADLINE) {
+            qint64 deadlineNs = qMax<qint64>(deadline * 1000, 1);
+            spec.it_value.tv_sec = deadlineNs / 1000000000;
+            spec.it_value.tv_nsec = deadlineNs % 1000000000;
+        }
+        timerfd_settime(m_boundaryFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+        return;
     }
-
-    emit wordSpaceDetected();
+    if (deadline == morse::DecoderEngine::NO_DEADLINE) {
+        m_boundaryTimer.stop();
+        return;
+    }
+    qint64 remainingUs = deadline - nowUs();
+    m_boundaryTimer.start(static_cast<int>(qMax<qint64>(0, (remainingUs + 999) / 1000)));
 }
 
-void MorseDecoder::finalizeCharacter() {
-    if (m_currentPattern.isEmpty()) return;
-
-    QChar decoded = m_morseTable.decode(m_currentPattern);
+void MorseDecoder::onEngineEvent(const morse::Event& event, void *context) {
+    static_cast<MorseDecoder *>(context)->handleEvent(event);
+}
 
-    if (!decoded.isNull()) {
-        emit characterDecoded(decoded);
-    } else {
-        emit decodingError(m_currentPattern);
+void MorseDecoder::handleEvent(const morse::Event& event) {
+    switch (event.type) {
+    case morse::EventType::Element:
+        emit elementDecoded(event.isDit ? DIT_STRING : DAH_STRING, event.confidence);
+        break;
+    case morse::EventType::Character:
+        MORSE_TRACE_INSTANT("character");
+        emit characterDecoded(QChar(event.character), event.confidence);
+        break;
+    case morse::EventType::WordSpace:
+        emit wordSpaceDetected();
+        break;
+    case morse::EventType::DecodingError: {
+        char pattern[morse::Pattern::MAX_STRING];
+        int length = event.pattern.toString(pattern, sizeof(pattern));
+        // Reused so reporting an error does not allocate
+        m_errorPattern.resize(0);
+        m_errorPattern.append(QLatin1String(pattern, length));
+        emit decodingError(m_errorPattern, event.confidence);
+        break;
+    }
+    case morse::EventType::Mark:
+        emit markMeasured(event.durationUs / 1000, event.isDit);
+        break;
+    case morse::EventType::Space:
+        emit spaceMeasured(event.durationUs / 1000);
+        break;
+    case morse::EventType::Timing: {
+        qint64 unitMs = event.unitUs / 1000;
+        if (unitMs != m_lastReportedUnitMs) {
+            m_lastReportedUnitMs = unitMs;
+            emit timingChanged(unitMs);
+        }
+        break;
+    }
+    case morse::EventType::SpeedChange:
+        emit speedChanged(static_cast<int>(1200000 / event.unitUs), event.durationUs / 1000);
+        break;
     }
-
-    m_currentPattern.clear();
 }
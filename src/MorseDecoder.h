@@ -2,56 +2,63 @@
 #define MORSEDECODER_H
 
 #include <QObject>
-#include <QElapsedTimer>
 #include <QTimer>
-#include "MorseTable.h"
+#include "core/DecoderEngine.h"
 
+class QSocketNotifier;
+
+// Qt adapter around morse::DecoderEngine: feeds it key edges, drives its
+// character/word boundaries from a single timer and re-emits its events
+// as signals for the GUI.
 class MorseDecoder : public QObject {
     Q_OBJECT
 
 public:
     explicit MorseDecoder(QObject *parent = nullptr);
+    ~MorseDecoder();
 
     void setWpm(int wpm);
-    int wpm() const { return m_wpm; }
+    int wpm() const { return m_engine.wpm(); }
 
     void reset();
 
 public slots:
     void keyDown();
     void keyUp();
+    void keyEdge(bool down, qint64 timestampNs); // Uses the capture timestamp
     void processElement(bool isDit); // For character mode
+    void abortElement(); // Key state lost mid-mark; keeps timing and pattern
 
 signals:
-    void elementDecoded(const QString& element); // "." or "-"
-    void characterDecoded(QChar character);
+    // confidence: 0 when a duration sat on a decision boundary, 1 when it
+    // was at its ideal length; a character carries its weakest element or gap
+    void elementDecoded(const QString& element, float confidence); // "." or "-"
+    void characterDecoded(QChar character, float confidence);
     void wordSpaceDetected();
-    void decodingError(const QString& pattern);
+    void decodingError(const QString& pattern, float confidence);
+    void timingChanged(qint64 unitMs); // Current estimate of one unit
+    void markMeasured(qint64 durationMs, bool isDit);
+    void spaceMeasured(qint64 durationMs); // Key-up time before a key-down
+    void speedChanged(int wpm, qint64 previousSegmentMs); // Abrupt change re-locked
 
 private slots:
-    void onCharacterTimeout();
-    void onWordTimeout();
+    void onBoundaryTimeout();
 
 private:
-    void processKeyDuration(qint64 duration);
-    void finalizeCharacter();
-    void updateTimingAverages(qint64 duration, bool isDit);
-    qint64 calculateUnitTime() const;
-
-    MorseTable m_morseTable;
-    QString m_currentPattern;
-
-    QElapsedTimer m_keyTimer;
-    QTimer m_characterTimer;
-    QTimer m_wordTimer;
-
-    bool m_keyIsDown;
-    int m_wpm;
+    static void onEngineEvent(const morse::Event& event, void *context);
+    void handleEvent(const morse::Event& event);
+    void scheduleBoundary();
+    static qint64 nowUs();
 
-    // Adaptive timing
-    qint64 m_ditAvg;
-    qint64 m_dahAvg;
-    int m_sampleCount;
+    morse::DecoderEngine m_engine;
+    // A timerfd armed at the absolute deadline: rearming it on every edge
+    // neither allocates nor rounds to milliseconds, unlike a QTimer, which
+    // is only the fallback
+    int m_boundaryFd;
+    QSocketNotifier *m_boundaryNotifier;
+    QTimer m_boundaryTimer;
+    qint64 m_lastReportedUnitMs;
+    QString m_errorPattern;
 };
 
 #endif // MORSEDECODER_H
@@ -2,8 +2,8 @@
 #define MORSETABLE_H
 
 #include <QString>
-#include <QMap>
 
+// QString front end for morse::MorseCode
 class MorseTable {
 public:
     MorseTable();
@@ -16,12 +16,6 @@ public:
 
     // Check if pattern exists
     bool isValidPattern(const QString& pattern) const;
-
-private:
-    void initializeTables();
-
-    QMap<QString, QChar> m_morseToChar;
-    QMap<QChar, QString> m_charToMorse;
 };
 
 #endif // MORSETABLE_H
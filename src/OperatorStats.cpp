@@ -0,0 +1,97 @@
+#include "OperatorStats.h"
+#include <cmath>
+
+void DurationHistogram::add(qint64 durationMs) {
+    int bin = static_cast<int>(qBound<qint64>(0, durationMs / BIN_MS, BIN_COUNT - 1));
+    ++m_bins[bin];
+
+    ++m_count;
+    double delta = durationMs - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (durationMs - m_mean);
+}
+
+void DurationHistogram::clear() {
+    m_bins.fill(0);
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+}
+
+double DurationHistogram::stddev() const {
+    return m_count > 1 ? std::sqrt(m_m2 / (m_count - 1)) : 0.0;
+}
+
+double DurationHistogram::quantile(double q) const {
+    if (m_count == 0) return 0.0;
+
+    double target = qBound(0.0, q, 1.0) * m_count;
+    double cumulative = 0.0;
+    for (int i = 0; i < BIN_COUNT; ++i) {
+        double next = cumulative + m_bins[i];
+        if (next >= target && m_bins[i] > 0) {
+            // Interpolate linearly within the bin
+            double fraction = (target - cumulative) / m_bins[i];
+            return (i + fraction) * BIN_MS;
+        }
+        cumulative = next;
+    }
+    return BIN_COUNT * BIN_MS;
+}
+
+void OperatorStats::addMark(qint64 durationMs, bool isDit) {
+    m_histograms[isDit ? Dit : Dah].add(durationMs);
+    m_activeMs += durationMs;
+}
+
+void OperatorStats::addSpace(qint64 durationMs) {
+    // Classify against the decoder's unit: 1 unit inside a character,
+    // 3 between characters, 7 between words. Twice a word gap or more is
+    // a pause (thinking, listening, changing over) and is not counted.
+    if (durationMs < 2 * m_unitMs) {
+        m_histograms[ElementGap].add(durationMs);
+    } else if (durationMs < 5 * m_unitMs) {
+        m_histograms[CharacterGap].add(durationMs);
+    } else if (durationMs < IDLE_UNITS * m_unitMs) {
+        m_histograms[WordGap].add(durationMs);
+    }
+
+    // Pauses longer than a word gap are idle time, not sending
+    m_activeMs += qMin(durationMs, 7 * m_unitMs);
+}
+
+void OperatorStats::reset() {
+    for (DurationHistogram& histogram : m_histograms) {
+        histogram.clear();
+    }
+    m_activeMs = 0;
+    m_characters = 0;
+}
+
+double OperatorStats::ditWpm() const {
+    const DurationHistogram& dits = m_histograms[Dit];
+    return dits.count() && dits.mean() > 0 ? 1200.0 / dits.mean() : 0.0;
+}
+
+double OperatorStats::effectiveWpm() const {
+    if (m_activeMs <= 0) return 0.0;
+    // A standard word is five characters
+    return (m_characters / 5.0) * 60000.0 / m_activeMs;
+}
+
+double OperatorStats::dahDitRatio() const {
+    const DurationHistogram& dits = m_histograms[Dit];
+    const DurationHistogram& dahs = m_histograms[Dah];
+    return dits.count() && dahs.count() && dits.mean() > 0 ? dahs.mean() / dits.mean() : 0.0;
+}
+
+double OperatorStats::weight() const {
+    const DurationHistogram& dits = m_histograms[Dit];
+    const DurationHistogram& gaps = m_histograms[ElementGap];
+    return dits.count() && gaps.count() && gaps.mean() > 0 ? dits.mean() / gaps.mean() : 0.0;
+}
+
+double OperatorStats::characterGapVariation() const {
+    const DurationHistogram& gaps = m_histograms[CharacterGap];
+    return gaps.count() > 1 && gaps.mean() > 0 ? gaps.stddev() / gaps.mean() : 0.0;
+}
@@ -0,0 +1,64 @@
+#ifndef OPERATORSTATS_H
+#define OPERATORSTATS_H
+
+#include <QtGlobal>
+#include <array>
+
+// Fixed-size duration histogram with running moments. Adding a sample is
+// O(1) and never allocates; quantiles are read from the cumulative counts.
+class DurationHistogram {
+public:
+    static constexpr int BIN_MS = 5;
+    static constexpr int BIN_COUNT = 400; // 0-2 s, last bin collects overflow
+
+    void add(qint64 durationMs);
+    void clear();
+
+    quint64 count() const { return m_count; }
+    double mean() const { return m_mean; }
+    double stddev() const;
+    double quantile(double q) const;
+    const std::array<quint32, BIN_COUNT>& bins() const { return m_bins; }
+
+private:
+    std::array<quint32, BIN_COUNT> m_bins{};
+    quint64 m_count = 0;
+    double m_mean = 0.0;
+    double m_m2 = 0.0; // Welford sum of squared deviations
+};
+
+class OperatorStats {
+public:
+    enum Category {
+        Dit,
+        Dah,
+        ElementGap,
+        CharacterGap,
+        WordGap,
+        CategoryCount
+    };
+
+    void addMark(qint64 durationMs, bool isDit);
+    void addSpace(qint64 durationMs);
+    void addCharacter() { ++m_characters; }
+    void setUnitTime(qint64 unitMs) { m_unitMs = qMax<qint64>(1, unitMs); }
+    void reset();
+
+    const DurationHistogram& histogram(Category category) const { return m_histograms[category]; }
+
+    double ditWpm() const;              // From the mean dit length
+    double effectiveWpm() const;        // Characters over active keying time
+    double dahDitRatio() const;         // 3.0 is textbook
+    double weight() const;              // Dit mark / element space, 1.0 is textbook
+    double characterGapVariation() const; // Coefficient of variation
+
+private:
+    static constexpr qint64 IDLE_UNITS = 14; // Spaces this long are pauses
+
+    std::array<DurationHistogram, CategoryCount> m_histograms;
+    qint64 m_unitMs = 60;
+    qint64 m_activeMs = 0;
+    quint64 m_characters = 0;
+};
+
+#endif // OPERATORSTATS_H
@@ -0,0 +1,366 @@
+#include "PracticeDialog.h"
+#include "core/PracticeText.h"
+#include "core/WavWriter.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QGroupBox>
+#include <QFileDialog>
+#include <QMediaDevices>
+#include <QAudioDevice>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QStandardPaths>
+#include <algorithm>
+#include <random>
+
+namespace {
+constexpr int SAMPLE_RATE = 44100;
+constexpr int CHUNK_FRAMES = 1024;
+// Background stations are spread across a typical CW filter passband
+constexpr float QRM_MIN_OFFSET_HZ = 60.0f;
+constexpr float QRM_MAX_OFFSET_HZ = 900.0f;
+// WAV export stops here even if the text is not finished
+constexpr int64_t MAX_EXPORT_SECONDS = 3600;
+
+enum Material { KochLesson, RandomGroups, Qso };
+}
+
+PracticeDialog::PracticeDialog(QWidget *parent)
+    : QDialog(parent)
+    , m_simulator(SAMPLE_RATE)
+    , m_audioSink(nullptr)
+    , m_audioIO(nullptr)
+    , m_audioTimer(new QTimer(this))
+    , m_seed(QRandomGenerator::global()->generate())
+{
+    setWindowTitle("Code Practice");
+    setupUi();
+    loadSettings();
+    generateText();
+
+    m_audioTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_audioTimer, &QTimer::timeout, this, &PracticeDialog::writeAudioData);
+}
+
+PracticeDialog::~PracticeDialog() {
+    stopPlayback();
+}
+
+void PracticeDialog::setupUi() {
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    QGroupBox *materialGroup = new QGroupBox("Material", this);
+    QFormLayout *materialLayout = new QFormLayout(materialGroup);
+    m_materialCombo = new QComboBox(this);
+    m_materialCombo->addItems({"Koch lesson", "Random groups", "QSO"});
+    materialLayout->addRow("Type:", m_materialCombo);
+    m_lessonSpin = new QSpinBox(this);
+    m_lessonSpin->setRange(1, morse::PracticeText::KOCH_LESSONS);
+    materialLayout->addRow("Koch lesson:", m_lessonSpin);
+    m_groupsSpin = new QSpinBox(this);
+    m_groupsSpin->setRange(5, 200);
+    materialLayout->addRow("Groups:", m_groupsSpin);
+    mainLayout->addWidget(materialGroup);
+
+    QGroupBox *speedGroup = new QGroupBox("Speed", this);
+    QFormLayout *speedLayout = new QFormLayout(speedGroup);
+    m_wpmSpin = new QSpinBox(this);
+    m_wpmSpin->setRange(5, 50);
+    m_wpmSpin->setSuffix(" WPM");
+    speedLayout->addRow("Character speed:", m_wpmSpin);
+    m_farnsworthSpin = new QSpinBox(this);
+    m_farnsworthSpin->setRange(0, 50);
+    m_farnsworthSpin->setSuffix(" WPM");
+    m_farnsworthSpin->setSpecialValueText("Off");
+    m_farnsworthSpin->setToolTip("Slower overall speed with characters sent at full speed");
+    speedLayout->addRow("Farnsworth:", m_farnsworthSpin);
+    m_toneSpin = new QSpinBox(this);
+    m_toneSpin->setRange(300, 1200);
+    m_toneSpin->setSingleStep(50);
+    m_toneSpin->setSuffix(" Hz");
+    speedLayout->addRow("Tone:", m_toneSpin);
+    mainLayout->addWidget(speedGroup);
+
+    QGroupBox *bandGroup = new QGroupBox("Band Conditions", this);
+    QFormLayout *bandLayout = new QFormLayout(bandGroup);
+    m_qrmSpin = new QSpinBox(this);
+    m_qrmSpin->setRange(0, 64);
+    m_qrmSpin->setToolTip("Other stations calling nearby");
+    bandLayout->addRow("QRM stations:", m_qrmSpin);
+    m_noiseSlider = new QSlider(Qt::Horizontal, this);
+    m_noiseSlider->setRange(0, 100);
+    bandLayout->addRow("Noise:", m_noiseSlider);
+    m_qrnSlider = new QSlider(Qt::Horizontal, this);
+    m_qrnSlider->setRange(0, 100);
+    m_qrnSlider->setToolTip("Static crashes");
+    bandLayout->addRow("QRN:", m_qrnSlider);
+    m_qsbSlider = new QSlider(Qt::Horizontal, this);
+    m_qsbSlider->setRange(0, 100);
+    m_qsbSlider->setToolTip("Fading depth");
+    bandLayout->addRow("QSB:", m_qsbSlider);
+    mainLayout->addWidget(bandGroup);
+
+    m_textEdit = new QTextEdit(this);
+    m_textEdit->setFont(QFont("Monospace", 11));
+    m_textEdit->setMinimumHeight(100);
+    mainLayout->addWidget(m_textEdit, 1);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    m_newTextBtn = new QPushButton("New Text", this);
+    m_playBtn = new QPushButton("Play", this);
+    m_exportBtn = new QPushButton("Export WAV...", this);
+    buttonLayout->addWidget(m_newTextBtn);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(m_playBtn);
+    buttonLayout->addWidget(m_exportBtn);
+    mainLayout->addLayout(buttonLayout);
+
+    m_statusLabel = new QLabel(this);
+    mainLayout->addWidget(m_statusLabel);
+
+    connect(m_materialCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &PracticeDialog::onMaterialChanged);
+    connect(m_lessonSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &PracticeDialog::generateText);
+    connect(m_groupsSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &PracticeDialog::generateText);
+    connect(m_newTextBtn, &QPushButton::clicked, this, [this]() {
+        m_seed = QRandomGenerator::global()->generate();
+        generateText();
+    });
+    connect(m_playBtn, &QPushButton::clicked, this, &PracticeDialog::onPlayClicked);
+    connect(m_exportBtn, &QPushButton::clicked, this, &PracticeDialog::onExportClicked);
+}
+
+void PracticeDialog::loadSettings() {
+    QSettings settings("MorseDecoder", "MorseKeyDecoder");
+    const QSignalBlocker blockMaterial(m_materialCombo);
+    const QSignalBlocker blockLesson(m_lessonSpin);
+    const QSignalBlocker blockGroups(m_groupsSpin);
+    m_materialCombo->setCurrentIndex(settings.value("practice_material", KochLesson).toInt());
+    m_lessonSpin->setValue(settings.value("practice_koch_lesson", 1).toInt());
+    m_groupsSpin->setValue(settings.value("practice_groups", 20).toInt());
+    m_wpmSpin->setValue(settings.value("practice_wpm", 20).toInt());
+    m_farnsworthSpin->setValue(settings.value("practice_farnsworth_wpm", 0).toInt());
+    m_toneSpin->setValue(settings.value("practice_tone_hz", 700).toInt());
+    m_qrmSpin->setValue(settings.value("practice_qrm_stations", 0).toInt());
+    m_noiseSlider->setValue(settings.value("practice_noise", 0).toInt());
+    m_qrnSlider->setValue(settings.value("practice_qrn", 0).toInt());
+    m_qsbSlider->setValue(settings.value("practice_qsb", 0).toInt());
+    m_lessonSpin->setEnabled(m_materialCombo->currentIndex() == KochLesson);
+    m_groupsSpin->setEnabled(m_materialCombo->currentIndex() != Qso);
+}
+
+void PracticeDialog::saveSettings() {
+    QSettings settings("MorseDecoder", "MorseKeyDecoder");
+    settings.setValue("practice_material", m_materialCombo->currentIndex());
+    settings.setValue("practice_koch_lesson", m_lessonSpin->value());
+    settings.setValue("practice_groups", m_groupsSpin->value());
+    settings.setValue("practice_wpm", m_wpmSpin->value());
+    settings.setValue("practice_farnsworth_wpm", m_farnsworthSpin->value());
+    settings.setValue("practice_tone_hz", m_toneSpin->value());
+    settings.setValue("practice_qrm_stations", m_qrmSpin->value());
+    settings.setValue("practice_noise", m_noiseSlider->value());
+    settings.setValue("practice_qrn", m_qrnSlider->value());
+    settings.setValue("practice_qsb", m_qsbSlider->value());
+}
+
+void PracticeDialog::hideEvent(QHideEvent *event) {
+    stopPlayback();
+    saveSettings();
+    QDialog::hideEvent(event);
+}
+
+void PracticeDialog::onMaterialChanged(int index) {
+    m_lessonSpin->setEnabled(index == KochLesson);
+    m_groupsSpin->setEnabled(index != Qso);
+    generateText();
+}
+
+void PracticeDialog::generateText() {
+    std::string text;
+    switch (m_materialCombo->currentIndex()) {
+    case KochLesson:
+        text = morse::PracticeText::kochGroups(m_lessonSpin->value(), m_groupsSpin->value(), 5, m_seed);
+        break;
+    case RandomGroups:
+        text = morse::PracticeText::randomGroups(m_groupsSpin->value(), 5, m_seed);
+        break;
+    default:
+        text = morse::PracticeText::qso(m_seed);
+        break;
+    }
+    m_textEdit->setPlainText(QString::fromStdString(text));
+}
+
+void PracticeDialog::buildSimulator(morse::BandSimulator& simulator) const {
+    simulator.clearSignals();
+    simulator.setSeed(m_seed);
+
+    morse::SimulatedSignal practice;
+    practice.text = m_textEdit->toPlainText().simplified().toUpper().toStdString();
+    practice.wpm = m_wpmSpin->value();
+    practice.farnsworthWpm = m_farnsworthSpin->value();
+    practice.frequencyHz = m_toneSpin->value();
+    practice.amplitude = 0.5f;
+    practice.qsbDepth = m_qsbSlider->value() / 100.0f;
+    practice.qsbRateHz = 0.08f;
+    practice.startDelayMs = 500;
+    simulator.addSignal(practice);
+
+    // Background stations: other QSOs at random offsets, speeds and fading
+    std::mt19937 rng(m_seed);
+    std::uniform_real_distribution<float> offset(QRM_MIN_OFFSET_HZ, QRM_MAX_OFFSET_HZ);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_int_distribution<int> wpm(12, 35);
+    std::uniform_int_distribution<int> delay(0, 4000);
+    for (int i = 0; i < m_qrmSpin->value(); ++i) {
+        morse::SimulatedSignal qrm;
+        qrm.text = morse::PracticeText::qso(m_seed + i + 1);
+        qrm.wpm = wpm(rng);
+        float hz = m_toneSpin->value() + (unit(rng) < 0.5f ? -offset(rng) : offset(rng));
+        qrm.frequencyHz = std::max(150.0f, hz);
+        qrm.amplitude = 0.05f + 0.3f * unit(rng);
+        qrm.qsbDepth = practice.qsbDepth * unit(rng);
+        qrm.qsbRateHz = 0.03f + 0.2f * unit(rng);
+        qrm.startDelayMs = delay(rng);
+        qrm.repeat = true;
+        simulator.addSignal(qrm);
+    }
+
+    simulator.setNoiseLevel(0.25f * m_noiseSlider->value() / 100.0f);
+    simulator.setQrn(2.0f, 1.5f * m_qrnSlider->value() / 100.0f);
+}
+
+void PracticeDialog::onPlayClicked() {
+    if (m_audioSink) {
+        stopPlayback();
+        return;
+    }
+
+    QAudioFormat format;
+    format.setSampleRate(SAMPLE_RATE);
+    format.setChannelCount(1);
+    format.setSampleFormat(QAudioFormat::Int16);
+
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    if (device.isNull()) {
+        m_statusLabel->setText("No audio output device found");
+        return;
+    }
+    if (!device.isFormatSupported(format)) {
+        format = device.preferredFormat();
+    }
+    if (format.sampleFormat() != QAudioFormat::Int16 && format.sampleFormat() != QAudioFormat::Float) {
+        m_statusLabel->setText("Unsupported audio output format");
+        return;
+    }
+    m_format = format;
+
+    m_simulator = morse::BandSimulator(format.sampleRate());
+    buildSimulator(m_simulator);
+
+    // Preallocate so the audio timer never allocates
+    m_mixBuffer.assign(CHUNK_FRAMES, 0.0f);
+    m_outputBuffer.resize(CHUNK_FRAMES * format.bytesPerFrame());
+
+    // Push mode, as for the sidetone, with a little more buffering
+    m_audioSink = new QAudioSink(device, format, this);
+    m_audioSink->setBufferSize(format.bytesForDuration(60000));
+    m_audioIO = m_audioSink->start();
+    if (!m_audioIO) {
+        m_statusLabel->setText("Failed to start audio");
+        stopPlayback();
+        return;
+    }
+    m_audioTimer->start(5);
+    m_playBtn->setText("Stop");
+    m_statusLabel->setText(QString("Playing %1 signal(s)").arg(m_simulator.signalCount()));
+}
+
+void PracticeDialog::writeAudioData() {
+    if (!m_audioIO) return;
+
+    if (m_simulator.finished()) {
+        // Let the device drain what it already has before closing
+        if (m_audioSink->bytesFree() >= m_audioSink->bufferSize()) {
+            stopPlayback();
+            m_statusLabel->setText("Finished");
+        }
+        return;
+    }
+
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const int channels = m_format.channelCount();
+    int frames = std::min<int>(m_audioSink->bytesFree() / bytesPerFrame, CHUNK_FRAMES);
+    if (frames <= 0) return;
+
+    m_simulator.render(m_mixBuffer.data(), frames);
+    if (m_format.sampleFormat() == QAudioFormat::Int16 && channels == 1) {
+        morse::BandSimulator::toInt16(m_mixBuffer.data(), reinterpret_cast<int16_t *>(m_outputBuffer.data()), frames);
+    } else if (m_format.sampleFormat() == QAudioFormat::Int16) {
+        int16_t *out = reinterpret_cast<int16_t *>(m_outputBuffer.data());
+        for (int i = 0; i < frames; ++i) {
+            int16_t sample;
+            morse::BandSimulator::toInt16(&m_mixBuffer[i], &sample, 1);
+            std::fill(out + i * channels, out + (i + 1) * channels, sample);
+        }
+    } else {
+        float *out = reinterpret_cast<float *>(m_outputBuffer.data());
+        for (int i = 0; i < frames; ++i) {
+            float sample = std::clamp(m_mixBuffer[i], -1.0f, 1.0f);
+            std::fill(out + i * channels, out + (i + 1) * channels, sample);
+        }
+    }
+    m_audioIO->write(m_outputBuffer.constData(), qint64(frames) * bytesPerFrame);
+}
+
+void PracticeDialog::stopPlayback() {
+    m_audioTimer->stop();
+    if (m_audioSink) {
+        m_audioSink->stop();
+        delete m_audioSink;
+        m_audioSink = nullptr;
+    }
+    m_audioIO = nullptr;
+    m_playBtn->setText("Play");
+}
+
+void PracticeDialog::onExportClicked() {
+    QString defaultPath = QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/practice.wav";
+    QString path = QFileDialog::getSaveFileName(this, "Export Practice Audio", defaultPath, "WAV audio (*.wav)");
+    if (path.isEmpty()) return;
+
+    morse::BandSimulator simulator(SAMPLE_RATE);
+    buildSimulator(simulator);
+
+    morse::WavWriter writer;
+    if (!writer.open(QFile::encodeName(path).constData(), SAMPLE_RATE)) {
+        m_statusLabel->setText("Cannot write " + path);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<float> mix(CHUNK_FRAMES);
+    std::vector<int16_t> pcm(CHUNK_FRAMES);
+    bool ok = true;
+    while (ok && !simulator.finished() && simulator.renderedFrames() < MAX_EXPORT_SECONDS * SAMPLE_RATE) {
+        simulator.render(mix.data(), CHUNK_FRAMES);
+        morse::BandSimulator::toInt16(mix.data(), pcm.data(), CHUNK_FRAMES);
+        ok = writer.write(pcm.data(), CHUNK_FRAMES);
+    }
+    ok = writer.close() && ok;
+
+    double audioSeconds = double(simulator.renderedFrames()) / SAMPLE_RATE;
+    double renderSeconds = std::max<qint64>(timer.elapsed(), 1) / 1000.0;
+    if (ok) {
+        m_statusLabel->setText(QString("Wrote %1 s of audio in %2 s (%3x real time)")
+                                   .arg(audioSeconds, 0, 'f', 1)
+                                   .arg(renderSeconds, 0, 'f', 2)
+                                   .arg(audioSeconds / renderSeconds, 0, 'f', 0));
+    } else {
+        m_statusLabel->setText("Error writing " + path);
+    }
+}
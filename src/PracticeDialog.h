@@ -0,0 +1,70 @@
+#ifndef PRACTICEDIALOG_H
+#define PRACTICEDIALOG_H
+
+#include <QDialog>
+#include <QAudioSink>
+#include <QAudioFormat>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QSlider>
+#include <QPushButton>
+#include <QTextEdit>
+#include <QLabel>
+#include <QTimer>
+#include <vector>
+#include "core/BandSimulator.h"
+
+// Generates practice text (Koch lessons, random groups, QSOs) and renders
+// it through the band simulator with QRM, QRN, QSB and noise, either to
+// the speakers or to a WAV file.
+class PracticeDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit PracticeDialog(QWidget *parent = nullptr);
+    ~PracticeDialog();
+
+protected:
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void generateText();
+    void onPlayClicked();
+    void onExportClicked();
+    void writeAudioData();
+    void onMaterialChanged(int index);
+
+private:
+    void setupUi();
+    void loadSettings();
+    void saveSettings();
+    void buildSimulator(morse::BandSimulator& simulator) const;
+    void stopPlayback();
+
+    morse::BandSimulator m_simulator;
+    QAudioSink *m_audioSink;
+    QIODevice *m_audioIO;
+    QAudioFormat m_format;
+    QTimer *m_audioTimer;
+    std::vector<float> m_mixBuffer;
+    QByteArray m_outputBuffer;
+    quint32 m_seed;
+
+    QComboBox *m_materialCombo;
+    QSpinBox *m_lessonSpin;
+    QSpinBox *m_groupsSpin;
+    QSpinBox *m_wpmSpin;
+    QSpinBox *m_farnsworthSpin;
+    QSpinBox *m_toneSpin;
+    QSpinBox *m_qrmSpin;
+    QSlider *m_noiseSlider;
+    QSlider *m_qrnSlider;
+    QSlider *m_qsbSlider;
+    QTextEdit *m_textEdit;
+    QPushButton *m_newTextBtn;
+    QPushButton *m_playBtn;
+    QPushButton *m_exportBtn;
+    QLabel *m_statusLabel;
+};
+
+#endif // PRACTICEDIALOG_H
@@ -0,0 +1,203 @@
+#include "RealtimeScheduler.h"
+#include <QDebug>
+#include <QStringList>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef HAVE_QTDBUS
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusReply>
+#endif
+
+namespace {
+// rtkit refuses threads from processes without an RLIMIT_RTTIME
+constexpr rlim_t RTKIT_RTTIME_US = 200000;
+constexpr size_t PREFAULT_STACK_BYTES = 64 * 1024;
+
+std::atomic<bool> g_memoryLocked{false};
+}
+
+QString RealtimeStatus::summary() const {
+    QStringList parts;
+    parts << (realtime ? method : QString("normal priority"));
+    if (pinned) parts << "pinned";
+    if (memoryLocked) parts << "mlocked";
+    if (!error.isEmpty()) parts << error;
+    return parts.join(", ");
+}
+
+void LatencyStats::record(qint64 latencyNs) {
+    if (latencyNs < 0) latencyNs = 0;
+    m_samples.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(latencyNs, std::memory_order_relaxed);
+    if (latencyNs > m_maxNs.load(std::memory_order_relaxed)) {
+        m_maxNs.store(latencyNs, std::memory_order_relaxed);
+    }
+    if (latencyNs >= OVERRUN_NS) {
+        m_overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LatencyStats::reset() {
+    m_samples = 0;
+    m_sumNs = 0;
+    m_maxNs = 0;
+    m_overruns = 0;
+}
+
+qint64 LatencyStats::meanNs() const {
+    quint64 n = samples();
+    return n ? m_sumNs.load(std::memory_order_relaxed) / static_cast<qint64>(n) : 0;
+}
+
+RealtimeStatus RealtimeScheduler::applyToCurrentThread(const RealtimeConfig& config) {
+    RealtimeStatus status;
+    if (!config.enabled) return status;
+
+    int priority = qBound(1, config.priority, sched_get_priority_max(SCHED_FIFO));
+
+    int err = 0;
+    if (setFifo(priority, &err)) {
+        status.realtime = true;
+        status.method = "SCHED_FIFO";
+    } else if (err == EPERM && raiseRtprioLimit(priority) && setFifo(priority, &err)) {
+        status.realtime = true;
+        status.method = "SCHED_FIFO (RLIMIT_RTPRIO)";
+    } else if (requestViaRtkit(priority, &status.error)) {
+        status.realtime = true;
+        status.method = "rtkit";
+    } else if (status.error.isEmpty()) {
+        status.error = QString("SCHED_FIFO: %1").arg(strerror(err));
+    }
+
+    if (!config.cpus.isEmpty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : config.cpus) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        }
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        status.pinned = (rc == 0);
+        if (rc != 0) {
+            qWarning() << "Failed to set CPU affinity:" << strerror(rc);
+        }
+    }
+
+    if (config.lockMemory) {
+        QString error;
+        status.memoryLocked = lockProcessMemory(&error);
+        if (!status.memoryLocked) {
+            qWarning() << "Memory locking failed:" << error;
+        }
+        prefaultStack();
+    }
+
+    if (!status.realtime) {
+        qWarning() << "Real-time scheduling unavailable:" << status.error;
+    }
+    return status;
+}
+
+bool RealtimeScheduler::setFifo(int priority, int *errnoOut) {
+    sched_param param{};
+    param.sched_priority = priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (errnoOut) *errnoOut = rc;
+    return rc == 0;
+}
+
+bool RealtimeScheduler::raiseRtprioLimit(int priority) {
+    // An unprivileged process may raise its soft limit up to the hard limit
+    // granted by limits.conf (e.g. the "audio" group)
+    rlimit limit{};
+    if (getrlimit(RLIMIT_RTPRIO, &limit) != 0) return false;
+    if (limit.rlim_cur >= static_cast<rlim_t>(priority)) return false;
+    if (limit.rlim_max < static_cast<rlim_t>(priority)) return false;
+
+    limit.rlim_cur = priority;
+    return setrlimit(RLIMIT_RTPRIO, &limit) == 0;
+}
+
+bool RealtimeScheduler::requestViaRtkit(int priority, QString *error) {
+#ifdef HAVE_QTDBUS
+    QDBusInterface rtkit("org.freedesktop.RealtimeKit1",
+                         "/org/freedesktop/RealtimeKit1",
+                         "org.freedesktop.RealtimeKit1",
+                         QDBusConnection::systemBus());
+    if (!rtkit.isValid()) {
+        if (error) *error = "rtkit not available";
+        return false;
+    }
+
+    rlimit rttime{};
+    if (getrlimit(RLIMIT_RTTIME, &rttime) == 0 && rttime.rlim_max > RTKIT_RTTIME_US) {
+        rttime.rlim_cur = RTKIT_RTTIME_US;
+        rttime.rlim_max = RTKIT_RTTIME_US;
+        setrlimit(RLIMIT_RTTIME, &rttime);
+    }
+
+    QVariant maxPriority = rtkit.property("MaxRealtimePriority");
+    if (maxPriority.isValid()) {
+        priority = qMin(priority, maxPriority.toInt());
+    }
+
+    quint64 tid = static_cast<quint64>(syscall(SYS_gettid));
+    QDBusReply<void> reply = rtkit.call("MakeThreadRealtime", tid, static_cast<quint32>(priority));
+    if (!reply.isValid()) {
+        if (error) *error = "rtkit: " + reply.error().message();
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(priority);
+    if (error) *error = "rtkit support not built";
+    return false;
+#endif
+}
+
+bool RealtimeScheduler::lockProcessMemory(QString *error) {
+    if (g_memoryLocked) return true;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        // RLIMIT_MEMLOCK too small for future mappings; keep what is resident now
+        if (mlockall(MCL_CURRENT) != 0) {
+            if (error) *error = strerror(errno);
+            return false;
+        }
+    }
+    g_memoryLocked = true;
+    return true;
+}
+
+void RealtimeScheduler::prefaultStack() {
+    // Touch the stack so the first deep call on the hot path does not fault
+    volatile unsigned char buffer[PREFAULT_STACK_BYTES];
+    for (size_t i = 0; i < sizeof(buffer); i += 4096) {
+        buffer[i] = 0;
+    }
+}
+
+QList<int> RealtimeScheduler::parseCpuList(const QString& text) {
+    QList<int> cpus;
+    const QStringList parts = text.split(',', Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        QStringList range = part.trimmed().split('-');
+        bool okFirst = false;
+        bool okLast = false;
+        int first = range.value(0).toInt(&okFirst);
+        int last = range.size() > 1 ? range.value(1).toInt(&okLast) : first;
+        if (range.size() == 1) okLast = okFirst;
+        if (!okFirst || !okLast) continue;
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (!cpus.contains(cpu)) cpus << cpu;
+        }
+    }
+    return cpus;
+}
@@ -0,0 +1,67 @@
+#ifndef REALTIMESCHEDULER_H
+#define REALTIMESCHEDULER_H
+
+#include <QList>
+#include <QString>
+#include <atomic>
+
+struct RealtimeConfig {
+    bool enabled = false;
+    int priority = 80;       // SCHED_FIFO priority (1-99)
+    QList<int> cpus;         // Cores to pin to; empty leaves affinity alone
+    bool lockMemory = true;  // mlockall() and pre-fault the thread stack
+};
+
+// What was actually achieved for a thread; privileges decide how much of
+// the requested configuration sticks.
+struct RealtimeStatus {
+    bool realtime = false;
+    bool pinned = false;
+    bool memoryLocked = false;
+    QString method;          // "SCHED_FIFO", "rtkit" or empty
+    QString error;
+
+    QString summary() const;
+};
+
+// Wake-up latency of a periodic thread, written by that thread only and
+// read by the GUI. Values are nanoseconds.
+class LatencyStats {
+public:
+    void record(qint64 latencyNs);
+    void reset();
+
+    quint64 samples() const { return m_samples.load(std::memory_order_relaxed); }
+    qint64 maxNs() const { return m_maxNs.load(std::memory_order_relaxed); }
+    qint64 meanNs() const;
+    quint64 overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+
+    static constexpr qint64 OVERRUN_NS = 1000000; // 1 ms
+
+private:
+    std::atomic<quint64> m_samples{0};
+    std::atomic<qint64> m_sumNs{0};
+    std::atomic<qint64> m_maxNs{0};
+    std::atomic<quint64> m_overruns{0};
+};
+
+class RealtimeScheduler {
+public:
+    // Raises the calling thread to SCHED_FIFO, falling back to
+    // RLIMIT_RTPRIO and then rtkit, and applies the CPU affinity.
+    static RealtimeStatus applyToCurrentThread(const RealtimeConfig& config);
+
+    // Process-wide; safe to call repeatedly, only the first call locks.
+    static bool lockProcessMemory(QString *error = nullptr);
+
+    // Parses "2,3" or "0-3" style core lists.
+    static QList<int> parseCpuList(const QString& text);
+
+private:
+    static bool setFifo(int priority, int *errnoOut);
+    static bool raiseRtprioLimit(int priority);
+    static bool requestViaRtkit(int priority, QString *error);
+    static void prefaultStack();
+};
+
+#endif // REALTIMESCHEDULER_H
@@ -1,16 +1,51 @@
 #include "SerialHandler.h"
 #include "ToneGenerator.h"
+#include "StartupProfiler.h"
+#include "core/AllocationCounter.h"
+#include "core/Trace.h"
 #include <QMediaDevices>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMetaMethod>
+#include <QSocketNotifier>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <time.h>
 #include <unistd.h>
 
 // KeyWatcher implementation - uses TIOCMIWAIT for interrupt-driven detection
-KeyWatcher::KeyWatcher(int fd, QObject *parent)
+namespace {
+// Fraction of the unit time used as the minimum mark/space in adaptive mode
+constexpr qint64 ADAPTIVE_DEBOUNCE_DIVISOR = 4;
+
+// Reopen attempts while a device is missing; hotplug events trigger an
+// immediate attempt, the timer covers missed events and udev permission races
+constexpr int RECONNECT_RETRY_MS = 250;
+// Failed reopens of a present device before giving up, about 10 s: udev
+// applies permissions well within that
+constexpr int MAX_RECONNECT_FAILURES = 40;
+
+qint64 monotonicNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+KeyWatcher::KeyWatcher(int fd, const RealtimeConfig& realtime, QObject *parent)
     : QThread(parent)
     , m_fd(fd)
     , m_running(true)
+    , m_realtimeConfig(realtime)
+    , m_minMarkNs(0)
+    , m_minSpaceNs(0)
+    , m_rejectedMarks(0)
+    , m_rejectedSpaces(0)
+    , m_allocations(0)
 {
 }
 
@@ -19,20 +54,109 @@ void KeyWatcher::stop()
     m_running = false;
 }
 
-void KeyWatcher::run()
+void KeyWatcher::setDebounce(qint64 minMarkUs, qint64 minSpaceUs)
+{
+    m_minMarkNs = qMax<qint64>(0, minMarkUs) * 1000;
+    m_minSpaceNs = qMax<qint64>(0, minSpaceUs) * 1000;
+}
+
+RealtimeStatus KeyWatcher::realtimeStatus() const
+{
+    QMutexLocker lock(&m_statusMutex);
+    return m_realtimeStatus;
+}
+
+bool KeyWatcher::readKeyDown(bool *ok)
 {
     int state = 0;
-    ioctl(m_fd, TIOCMGET, &state);
-    bool lastKeyDown = (state & TIOCM_CTS) || (state & TIOCM_DSR);
+    *ok = ioctl(m_fd, TIOCMGET, &state) == 0;
+    return (state & TIOCM_CTS) || (state & TIOCM_DSR);
+}
+
+void KeyWatcher::run()
+{
+    MORSE_TRACE_THREAD_NAME("key watcher");
+    RealtimeStatus status = RealtimeScheduler::applyToCurrentThread(m_realtimeConfig);
+    {
+        QMutexLocker lock(&m_statusMutex);
+        m_realtimeStatus = status;
+    }
+    const bool periodic = status.realtime;
+
+    bool ok = true;
+    bool stableKeyDown = readKeyDown(&ok);
+
+    // A raw change is held as pending until it has lasted long enough;
+    // if the line reverts first the pulse is counted as a glitch.
+    bool pending = false;
+    qint64 pendingSinceNs = 0;
+
+    qint64 lastPollNs = monotonicNs();
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    morse::AllocationScope allocations;
 
     while (m_running) {
-        // Tight polling loop - no sleep for maximum responsiveness
-        ioctl(m_fd, TIOCMGET, &state);
-        bool keyDown = (state & TIOCM_CTS) || (state & TIOCM_DSR);
+        if (periodic) {
+            deadline.tv_nsec += RT_POLL_PERIOD_NS;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_nsec -= 1000000000L;
+                ++deadline.tv_sec;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+        }
 
-        if (keyDown != lastKeyDown) {
-            lastKeyDown = keyDown;
-            emit keyStateChanged(keyDown);
+        // Without real-time priority this is a tight polling loop - no
+        // sleep for maximum responsiveness
+        bool keyDown = readKeyDown(&ok);
+        if (!ok) {
+            // The adapter is gone; report it rather than a phantom key-up
+            if (errno == EIO || errno == ENODEV || errno == ENXIO) {
+                emit lineLost();
+                break;
+            }
+            continue;
+        }
+        qint64 now = monotonicNs();
+
+        if (periodic) {
+            qint64 lateNs = now - (deadline.tv_sec * 1000000000LL + deadline.tv_nsec);
+            m_latency.record(lateNs);
+            if (lateNs >= LatencyStats::OVERRUN_NS) {
+                MORSE_TRACE_INSTANT("poll overrun");
+            }
+        } else {
+            m_latency.record(now - lastPollNs);
+            lastPollNs = now;
+        }
+
+        if (keyDown == stableKeyDown) {
+            if (pending) {
+                pending = false;
+                MORSE_TRACE_INSTANT("glitch rejected");
+                if (keyDown) {
+                    ++m_rejectedSpaces;
+                } else {
+                    ++m_rejectedMarks;
+                }
+            }
+            continue;
+        }
+
+        if (!pending) {
+            pending = true;
+            pendingSinceNs = now;
+        }
+
+        qint64 minNs = keyDown ? m_minMarkNs.load(std::memory_order_relaxed)
+                               : m_minSpaceNs.load(std::memory_order_relaxed);
+        if (now - pendingSinceNs >= minNs) {
+            pending = false;
+            stableKeyDown = keyDown;
+            MORSE_TRACE_SCOPE("KeyWatcher edge");
+            MORSE_TRACE_FLOW_BEGIN("key edge", pendingSinceNs);
+            emit keyStateChanged(keyDown, pendingSinceNs);
+            m_allocations.store(allocations.count(), std::memory_order_relaxed);
         }
     }
 }
@@ -41,37 +165,103 @@ SerialHandler::SerialHandler(QObject *parent)
     : QObject(parent)
     , m_serialPort(new QSerialPort(this))
     , m_keyWatcher(nullptr)
+    , m_edgeEventFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , m_edgeNotifier(nullptr)
+    , m_allocationsTotal(0)
+    , m_minMarkMs(4)
+    , m_minSpaceMs(4)
+    , m_adaptiveDebounce(false)
+    , m_unitTimeMs(60)
+    , m_rejectedTotal(0)
+    , m_enumerationThread(nullptr)
+    , m_enumerateAgain(false)
+    , m_enumeratedOnce(false)
+    , m_baudRate(9600)
+    , m_autoReconnect(true)
+    , m_reconnecting(false)
+    , m_reconnectFailures(0)
+    , m_keyIsDown(false)
+    , m_reconnectTimer(new QTimer(this))
     , m_audioSink(nullptr)
+    , m_audioPrepared(false)
     , m_toneGenerator(nullptr)
     , m_audioIO(nullptr)
     , m_audioTimer(new QTimer(this))
     , m_sidetoneEnabled(true)
     , m_sidetoneFreq(600)
     , m_sidetoneVolume(0.5f)
+    , m_sidetoneBackend(SidetoneBackend::QtMultimedia)
+    , m_alsaSidetone(nullptr)
+    , m_toneEdgeNs(0)
 {
     connect(m_serialPort, &QSerialPort::readyRead, this, &SerialHandler::onReadyRead);
     connect(m_serialPort, &QSerialPort::errorOccurred, this, &SerialHandler::onErrorOccurred);
     connect(m_audioTimer, &QTimer::timeout, this, &SerialHandler::writeAudioData);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &SerialHandler::tryReconnect);
+    m_reconnectTimer->setInterval(RECONNECT_RETRY_MS);
 
-    initializeAudio();
+    if (m_edgeEventFd >= 0) {
+        m_edgeNotifier = new QSocketNotifier(m_edgeEventFd, QSocketNotifier::Read, this);
+        connect(m_edgeNotifier, &QSocketNotifier::activated, this, &SerialHandler::drainKeyEdges);
+    } else {
+        qWarning() << "eventfd failed, key edges are picked up by polling:" << strerror(errno);
+        QTimer *poll = new QTimer(this);
+        connect(poll, &QTimer::timeout, this, &SerialHandler::drainKeyEdges);
+        poll->start(1);
+    }
 }
 
 SerialHandler::~SerialHandler() {
+    if (m_enumerationThread) {
+        m_enumerationThread->wait();
+        delete m_enumerationThread;
+    }
     if (m_keyWatcher) {
         m_keyWatcher->stop();
         m_keyWatcher->wait(100);
         delete m_keyWatcher;
     }
-    m_audioTimer->stop();
-    if (m_audioSink) {
-        m_audioSink->stop();
-    }
+    shutdownAudio();
     if (m_serialPort && m_serialPort->isOpen()) {
         m_serialPort->close();
     }
+    if (m_edgeEventFd >= 0) {
+        ::close(m_edgeEventFd);
+    }
+}
+
+void SerialHandler::prepareAudio() {
+    if (m_audioPrepared) return;
+    m_audioPrepared = true;
+
+    QElapsedTimer timer;
+    timer.start();
+    initializeAudio();
+    StartupProfiler::recordDeferred("audio output", timer.elapsed());
 }
 
 void SerialHandler::initializeAudio() {
+    if (m_sidetoneBackend != SidetoneBackend::QtMultimedia) {
+        AlsaSidetoneConfig config = m_alsaConfig;
+        config.pipewire = m_sidetoneBackend == SidetoneBackend::PipeWire;
+        // Always real-time; memory is only locked if capture asked for it
+        RealtimeConfig realtime = m_realtimeConfig;
+        realtime.lockMemory = m_realtimeConfig.enabled && m_realtimeConfig.lockMemory;
+        realtime.enabled = true;
+        realtime.priority = qMax(1, m_realtimeConfig.priority - SIDETONE_PRIORITY_OFFSET);
+
+        m_alsaSidetone = new AlsaSidetone(this);
+        m_alsaSidetone->setFrequency(m_sidetoneFreq);
+        m_alsaSidetone->setVolume(m_sidetoneVolume);
+        QString error;
+        if (m_alsaSidetone->open(config, realtime, &error)) {
+            return;
+        }
+        qWarning() << "Direct sidetone output unavailable, using Qt Multimedia:" << error;
+        delete m_alsaSidetone;
+        m_alsaSidetone = nullptr;
+    }
+
     QAudioFormat format;
     format.setSampleRate(44100);
     format.setChannelCount(1);
@@ -98,31 +288,77 @@ void SerialHandler::initializeAudio() {
     // Start in push mode - we write data via timer
     m_audioIO = m_audioSink->start();
     if (m_audioIO) {
+        m_audioBuffer.assign(size_t(qMax(m_audioSink->bufferSize(), 512)), 0);
         m_audioTimer->start(1);  // Write every 1ms for low latency
     } else {
         qWarning() << "Failed to start audio";
     }
 }
 
-void SerialHandler::startTone() {
-    if (!m_sidetoneEnabled || !m_toneGenerator) return;
+void SerialHandler::shutdownAudio() {
+    m_audioTimer->stop();
+    if (m_alsaSidetone) {
+        m_alsaSidetone->close();
+        delete m_alsaSidetone;
+        m_alsaSidetone = nullptr;
+    }
+    if (m_audioSink) {
+        m_audioSink->stop();
+        delete m_audioSink;
+        m_audioSink = nullptr;
+    }
+    m_audioIO = nullptr;
+    delete m_toneGenerator;
+    m_toneGenerator = nullptr;
+}
+
+void SerialHandler::startTone(qint64 timestampNs) {
+    if (!m_sidetoneEnabled) return;
+    if (m_alsaSidetone) {
+        MORSE_TRACE_INSTANT("tone on");
+        m_alsaSidetone->setActive(true, timestampNs);
+        return;
+    }
+    if (!m_toneGenerator) return;
+    MORSE_TRACE_INSTANT("tone on");
+    m_toneEdgeNs.store(timestampNs, std::memory_order_relaxed);
     m_toneGenerator->setActive(true);
 }
 
 void SerialHandler::stopTone() {
+    if (m_alsaSidetone) {
+        MORSE_TRACE_INSTANT("tone off");
+        m_alsaSidetone->setActive(false, 0);
+        return;
+    }
     if (!m_toneGenerator) return;
+    MORSE_TRACE_INSTANT("tone off");
     m_toneGenerator->setActive(false);
 }
 
 void SerialHandler::writeAudioData() {
     if (!m_audioIO || !m_toneGenerator) return;
+    MORSE_TRACE_SCOPE("SerialHandler::writeAudioData");
 
     int bytesFree = m_audioSink->bytesFree();
-    if (bytesFree > 0) {
-        QByteArray buffer(bytesFree, 0);
-        qint64 bytesRead = m_toneGenerator->read(buffer.data(), bytesFree);
+    MORSE_TRACE_COUNTER("audio bytes free", bytesFree);
+
+    // A tone started since the last write is heard after everything still
+    // queued in the sink; the sound server's own latency is not visible here
+    qint64 edgeNs = m_toneEdgeNs.exchange(0, std::memory_order_relaxed);
+    if (edgeNs != 0) {
+        qint64 queuedBytes = m_audioSink->bufferSize() - bytesFree;
+        qint64 bytesPerSecond = m_audioSink->format().bytesForDuration(1000000);
+        qint64 queuedNs = bytesPerSecond > 0 ? queuedBytes * 1000000000LL / bytesPerSecond : 0;
+        m_sinkLatency.record(monotonicNs() - edgeNs + queuedNs);
+    }
+
+    // Anything beyond the preallocated buffer goes out on the next tick
+    int bytes = qMin(bytesFree, int(m_audioBuffer.size()));
+    if (bytes > 0) {
+        qint64 bytesRead = m_toneGenerator->read(m_audioBuffer.data(), bytes);
         if (bytesRead > 0) {
-            m_audioIO->write(buffer.data(), bytesRead);
+            m_audioIO->write(m_audioBuffer.data(), bytesRead);
         }
     }
 }
@@ -136,7 +372,54 @@ QStringList SerialHandler::availablePorts() const {
     return ports;
 }
 
+void SerialHandler::enumeratePortsAsync() {
+    // Coalesce requests that arrive while a scan is running (hotplug bursts)
+    if (m_enumerationThread) {
+        m_enumerateAgain = true;
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    m_enumerationThread = QThread::create([this, timer]() {
+        QStringList ports = availablePorts();
+        QMetaObject::invokeMethod(this, [this, ports, timer]() {
+            if (!m_enumeratedOnce) {
+                m_enumeratedOnce = true;
+                StartupProfiler::recordDeferred("port enumeration", timer.elapsed());
+            }
+
+            m_enumerationThread->wait();
+            delete m_enumerationThread;
+            m_enumerationThread = nullptr;
+
+            emit portsEnumerated(ports);
+            if (m_enumerateAgain) {
+                m_enumerateAgain = false;
+                enumeratePortsAsync();
+            }
+        }, Qt::QueuedConnection);
+    });
+    m_enumerationThread->start();
+}
+
 bool SerialHandler::connectToPort(const QString& portName, qint32 baudRate) {
+    m_reconnectTimer->stop();
+    m_reconnecting = false;
+
+    if (openPort(portName, baudRate)) {
+        m_baudRate = baudRate;
+        rememberDevice(portName);
+        emit connected();
+        return true;
+    } else {
+        emit errorOccurred(m_serialPort->errorString());
+        return false;
+    }
+}
+
+bool SerialHandler::openPort(const QString& portName, qint32 baudRate) {
+    stopKeyWatcher();
     if (m_serialPort->isOpen()) {
         m_serialPort->close();
     }
@@ -148,30 +431,47 @@ bool SerialHandler::connectToPort(const QString& portName, qint32 baudRate) {
     m_serialPort->setStopBits(QSerialPort::OneStop);
     m_serialPort->setFlowControl(QSerialPort::NoFlowControl);
 
-    if (m_serialPort->open(QIODevice::ReadWrite)) {
-        m_serialPort->setDataTerminalReady(true);
-
-        // Start interrupt-driven key watcher
-        int fd = m_serialPort->handle();
-        m_keyWatcher = new KeyWatcher(fd, this);
-        connect(m_keyWatcher, &KeyWatcher::keyStateChanged,
-                this, &SerialHandler::onKeyStateChanged, Qt::DirectConnection);
-        m_keyWatcher->start();
-
-        emit connected();
-        return true;
-    } else {
-        emit errorOccurred(m_serialPort->errorString());
+    if (!m_serialPort->open(QIODevice::ReadWrite)) {
         return false;
     }
+
+    m_serialPort->setDataTerminalReady(true);
+    m_parseState = ParseState::WaitingForK;
+    prepareAudio();
+    startKeyWatcher();
+    return true;
+}
+
+void SerialHandler::startKeyWatcher() {
+    // Start interrupt-driven key watcher
+    int fd = m_serialPort->handle();
+    m_keyWatcher = new KeyWatcher(fd, m_realtimeConfig, this);
+    applyDebounce();
+    connect(m_keyWatcher, &KeyWatcher::keyStateChanged,
+            this, &SerialHandler::onKeyStateChanged, Qt::DirectConnection);
+    connect(m_keyWatcher, &KeyWatcher::lineLost,
+            this, &SerialHandler::onLineLost, Qt::QueuedConnection);
+    m_keyWatcher->start();
+}
+
+void SerialHandler::stopKeyWatcher() {
+    if (!m_keyWatcher) return;
+
+    m_keyWatcher->stop();
+    m_keyWatcher->wait(100);
+    m_rejectedTotal += m_keyWatcher->rejectedMarks() + m_keyWatcher->rejectedSpaces();
+    m_allocationsTotal += m_keyWatcher->allocations();
+    delete m_keyWatcher;
+    m_keyWatcher = nullptr;
+
+    // Deliver what the watcher captured before anything reports the stop
+    drainKeyEdges();
 }
 
 void SerialHandler::disconnect() {
-    if (m_keyWatcher) {
-        m_keyWatcher->stop();
-        m_keyWatcher->wait(100);
-        delete m_keyWatcher;
-        m_keyWatcher = nullptr;
+    stopKeyWatcher();
+    if (m_reconnecting) {
+        abandonReconnect();
     }
     if (m_serialPort->isOpen()) {
         m_serialPort->close();
@@ -179,13 +479,179 @@ void SerialHandler::disconnect() {
     }
 }
 
-void SerialHandler::onKeyStateChanged(bool down) {
+void SerialHandler::setAutoReconnect(bool enabled) {
+    m_autoReconnect = enabled;
+    if (!enabled && m_reconnecting) {
+        abandonReconnect();
+    }
+}
+
+void SerialHandler::abandonReconnect() {
+    // Deliberate: earlier failed attempts are not errors
+    m_reconnectTimer->stop();
+    m_reconnecting = false;
+    m_lastReconnectError.clear();
+    m_reconnectFailures = 0;
+    emit disconnected();
+}
+
+void SerialHandler::giveUpReconnect() {
+    // The only point where a failed reopen is reported as an error
+    QString error = m_lastReconnectError.isEmpty() ? m_serialPort->errorString() : m_lastReconnectError;
+    abandonReconnect();
+    emit errorOccurred(QString("Could not reopen %1: %2").arg(m_device.portName, error));
+}
+
+void SerialHandler::rememberDevice(const QString& portName) {
+    m_device = DeviceIdentity();
+    m_device.portName = portName;
+
+    const auto ports = QSerialPortInfo::availablePorts();
+    for (const QSerialPortInfo& info : ports) {
+        if (info.portName() == portName) {
+            m_device.serialNumber = info.serialNumber();
+            m_device.hasUsbIds = info.hasVendorIdentifier() && info.hasProductIdentifier();
+            m_device.vendorId = info.vendorIdentifier();
+            m_device.productId = info.productIdentifier();
+            break;
+        }
+    }
+}
+
+QString SerialHandler::findRememberedDevice() const {
+    // Prefer an exact serial number match, then the same VID:PID on the old
+    // port name, then any port with that VID:PID, then the old port name
+    QString sameIdsElsewhere;
+    bool oldNamePresent = false;
+
+    const auto ports = QSerialPortInfo::availablePorts();
+    for (const QSerialPortInfo& info : ports) {
+        bool sameIds = m_device.hasUsbIds
+                       && info.hasVendorIdentifier() && info.hasProductIdentifier()
+                       && info.vendorIdentifier() == m_device.vendorId
+                       && info.productIdentifier() == m_device.productId;
+
+        if (!m_device.serialNumber.isEmpty()) {
+            if (sameIds && info.serialNumber() == m_device.serialNumber) {
+                return info.portName();
+            }
+            continue;
+        }
+
+        if (info.portName() == m_device.portName) {
+            if (sameIds) return info.portName();
+            oldNamePresent = !m_device.hasUsbIds;
+        } else if (sameIds && sameIdsElsewhere.isEmpty()) {
+            sameIdsElsewhere = info.portName();
+        }
+    }
+
+    if (!sameIdsElsewhere.isEmpty()) return sameIdsElsewhere;
+    return oldNamePresent ? m_device.portName : QString();
+}
+
+void SerialHandler::onLineLost() {
+    handleDeviceLost();
+}
+
+void SerialHandler::handleDeviceLost() {
+    if (m_reconnecting || (!m_serialPort->isOpen() && !m_keyWatcher)) return;
+
+    if (!m_autoReconnect || m_device.portName.isEmpty()) {
+        disconnect();
+        emit errorOccurred("Device disconnected");
+        return;
+    }
+
+    stopKeyWatcher();
+    if (m_keyIsDown.exchange(false)) {
+        stopTone();
+        emit keyInterrupted();
+    }
+    if (m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+
+    m_reconnecting = true;
+    m_lastReconnectError.clear();
+    m_reconnectFailures = 0;
+    m_outageTimer.start();
+    m_reconnectTimer->start();
+    emit connectionLost();
+}
+
+void SerialHandler::onDeviceAppeared(const QString& devNode) {
+    Q_UNUSED(devNode);
+    if (m_reconnecting) {
+        tryReconnect();
+    }
+}
+
+void SerialHandler::tryReconnect() {
+    if (!m_reconnecting) return;
+
+    QString portName = findRememberedDevice();
+    if (portName.isEmpty()) {
+        return; // Retried by the timer or the next hotplug event
+    }
+    if (!openPort(portName, m_baudRate)) {
+        if (++m_reconnectFailures >= MAX_RECONNECT_FAILURES) giveUpReconnect();
+        return;
+    }
+
+    m_reconnectTimer->stop();
+    m_reconnecting = false;
+    m_lastReconnectError.clear();
+    m_reconnectFailures = 0;
+    m_device.portName = portName;
+
+    qint64 outageMs = m_outageTimer.elapsed();
+    ++m_outages.count;
+    m_outages.lastMs = outageMs;
+    m_outages.maxMs = qMax(m_outages.maxMs, outageMs);
+    m_outages.totalMs += outageMs;
+
+    emit reconnected(outageMs);
+}
+
+void SerialHandler::onKeyStateChanged(bool down, qint64 timestampNs) {
+    // Capture thread: the sidetone switches here, the decoder hears about
+    // the edge on the main thread
+    MORSE_TRACE_SCOPE("SerialHandler::onKeyStateChanged");
+    m_keyIsDown = down;
     if (down) {
-        startTone();
-        emit keyDown();
+        startTone(timestampNs);
     } else {
         stopTone();
-        emit keyUp();
+    }
+    if (!m_edgeRing.push(CapturedEdge{timestampNs, down})) {
+        MORSE_TRACE_INSTANT("edge ring full");
+        return;
+    }
+    if (m_edgeEventFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = ::write(m_edgeEventFd, &one, sizeof(one));
+        Q_UNUSED(written);
+    }
+}
+
+void SerialHandler::drainKeyEdges() {
+    if (m_edgeEventFd >= 0) {
+        uint64_t count;
+        ssize_t got = ::read(m_edgeEventFd, &count, sizeof(count));
+        Q_UNUSED(got);
+    }
+
+    CapturedEdge edge;
+    while (m_edgeRing.pop(edge)) {
+        MORSE_TRACE_FLOW_END("key edge", edge.timestampNs);
+        MORSE_TRACE_COUNTER("edge delivery us", (monotonicNs() - edge.timestampNs) / 1000);
+        if (edge.down) {
+            emit keyDown();
+        } else {
+            emit keyUp();
+        }
+        emit keyEdge(edge.down, edge.timestampNs);
     }
 }
 
@@ -205,6 +671,9 @@ void SerialHandler::setSidetoneFrequency(int frequency) {
     if (m_toneGenerator) {
         m_toneGenerator->setFrequency(m_sidetoneFreq);
     }
+    if (m_alsaSidetone) {
+        m_alsaSidetone->setFrequency(m_sidetoneFreq);
+    }
 }
 
 void SerialHandler::setSidetoneVolume(float volume) {
@@ -212,16 +681,125 @@ void SerialHandler::setSidetoneVolume(float volume) {
     if (m_toneGenerator) {
         m_toneGenerator->setVolume(m_sidetoneVolume);
     }
+    if (m_alsaSidetone) {
+        m_alsaSidetone->setVolume(m_sidetoneVolume);
+    }
+}
+
+void SerialHandler::setSidetoneBackend(SidetoneBackend backend, const AlsaSidetoneConfig& alsaConfig) {
+    m_sidetoneBackend = backend;
+    m_alsaConfig = alsaConfig;
+    if (!m_audioPrepared) return;
+
+    // The capture thread calls startTone() directly, so it is paused while
+    // the output is swapped; a mark in progress is cut short
+    bool watching = m_keyWatcher != nullptr;
+    if (watching) {
+        stopKeyWatcher();
+        if (m_keyIsDown.exchange(false)) {
+            stopTone();
+            emit keyInterrupted();
+        }
+    }
+    shutdownAudio();
+    m_sinkLatency.reset();
+    initializeAudio();
+    if (watching) startKeyWatcher();
+}
+
+QString SerialHandler::sidetoneDescription() const {
+    if (m_alsaSidetone) {
+        return QString("%1 (%2)").arg(m_alsaSidetone->description(),
+                                      m_alsaSidetone->realtimeStatus().summary());
+    }
+    if (m_audioSink) {
+        return QString("Qt Multimedia, %1 bytes").arg(m_audioSink->bufferSize());
+    }
+    return QString();
+}
+
+qint64 SerialHandler::sidetoneBufferUs() const {
+    if (m_alsaSidetone) return m_alsaSidetone->bufferLatencyUs();
+    if (m_audioSink) return m_audioSink->format().durationForBytes(m_audioSink->bufferSize());
+    return 0;
+}
+
+const LatencyStats *SerialHandler::sidetoneLatency() const {
+    if (m_alsaSidetone) return &m_alsaSidetone->latency();
+    return m_audioSink ? &m_sinkLatency : nullptr;
+}
+
+void SerialHandler::setDebounce(int minMarkMs, int minSpaceMs) {
+    m_minMarkMs = qBound(0, minMarkMs, 50);
+    m_minSpaceMs = qBound(0, minSpaceMs, 50);
+    applyDebounce();
+}
+
+void SerialHandler::setAdaptiveDebounce(bool enabled) {
+    m_adaptiveDebounce = enabled;
+    applyDebounce();
+}
+
+void SerialHandler::setDebounceUnitTime(qint64 unitMs) {
+    m_unitTimeMs = qMax<qint64>(1, unitMs);
+    if (m_adaptiveDebounce) {
+        applyDebounce();
+    }
+}
+
+void SerialHandler::applyDebounce() {
+    if (!m_keyWatcher) return;
+
+    qint64 markUs = m_minMarkMs * 1000;
+    qint64 spaceUs = m_minSpaceMs * 1000;
+    if (m_adaptiveDebounce) {
+        qint64 adaptiveUs = m_unitTimeMs * 1000 / ADAPTIVE_DEBOUNCE_DIVISOR;
+        markUs = qMax(markUs, adaptiveUs);
+        spaceUs = qMax(spaceUs, adaptiveUs);
+    }
+    m_keyWatcher->setDebounce(markUs, spaceUs);
+}
+
+quint64 SerialHandler::rejectedGlitches() const {
+    quint64 total = m_rejectedTotal;
+    if (m_keyWatcher) {
+        total += m_keyWatcher->rejectedMarks() + m_keyWatcher->rejectedSpaces();
+    }
+    return total;
+}
+
+void SerialHandler::setRealtimeConfig(const RealtimeConfig& config) {
+    m_realtimeConfig = config;
+}
+
+RealtimeStatus SerialHandler::realtimeStatus() const {
+    return m_keyWatcher ? m_keyWatcher->realtimeStatus() : RealtimeStatus();
+}
+
+const LatencyStats *SerialHandler::captureLatency() const {
+    return m_keyWatcher ? &m_keyWatcher->latency() : nullptr;
+}
+
+quint64 SerialHandler::captureAllocations() const {
+    return m_allocationsTotal + (m_keyWatcher ? m_keyWatcher->allocations() : 0);
 }
 
 void SerialHandler::onReadyRead() {
-    QByteArray data = m_serialPort->readAll();
-    m_buffer.append(data);
-    emit dataReceived(data);
-    parseData(data);
+    // Fixed chunks; the raw view shares the buffer instead of copying it.
+    // Receivers of dataReceived may queue or keep the bytes, so they get a
+    // copy, made only when something is connected.
+    static const QMetaMethod dataReceivedSignal = QMetaMethod::fromSignal(&SerialHandler::dataReceived);
+    const bool copyForReceivers = isSignalConnected(dataReceivedSignal);
+    qint64 length;
+    while ((length = m_serialPort->read(m_readBuffer, READ_CHUNK)) > 0) {
+        QByteArray data = QByteArray::fromRawData(m_readBuffer, int(length));
+        if (copyForReceivers) emit dataReceived(QByteArray(m_readBuffer, int(length)));
+        parseData(data);
+    }
 }
 
 void SerialHandler::parseData(const QByteArray& data) {
+    MORSE_TRACE_SCOPE("SerialHandler::parseData");
     for (char c : data) {
         if (m_parseState == ParseState::WaitingForK && (c == '\n' || c == '\r')) {
             continue;
@@ -240,12 +818,15 @@ void SerialHandler::parseData(const QByteArray& data) {
 
         case ParseState::WaitingForDigit:
             if (c == '1') {
-                startTone();
+                qint64 timestampNs = monotonicNs();
+                startTone(timestampNs);
                 emit keyDown();
+                emit keyEdge(true, timestampNs);
                 m_parseState = ParseState::WaitingForNewline;
             } else if (c == '0') {
                 stopTone();
                 emit keyUp();
+                emit keyEdge(false, monotonicNs());
                 m_parseState = ParseState::WaitingForNewline;
             } else {
                 m_parseState = ParseState::WaitingForK;
@@ -261,28 +842,39 @@ void SerialHandler::parseData(const QByteArray& data) {
     }
 }
 
-void SerialHandler::onErrorOccurred(QSerialPort::SerialPortError error) {
-    if (error == QSerialPort::NoError) return;
-
-    QString errorMessage;
+QString SerialHandler::errorText(QSerialPort::SerialPortError error) const {
     switch (error) {
     case QSerialPort::DeviceNotFoundError:
-        errorMessage = "Device not found";
-        break;
+        return "Device not found";
     case QSerialPort::PermissionError:
-        errorMessage = "Permission denied. Add user to 'dialout' group.";
-        break;
+        return "Permission denied. Add user to 'dialout' group.";
     case QSerialPort::OpenError:
-        errorMessage = "Cannot open port";
-        break;
+        return "Cannot open port";
     case QSerialPort::ResourceError:
-        errorMessage = "Device disconnected";
-        disconnect();
-        break;
+        return "Device disconnected";
     default:
-        errorMessage = m_serialPort->errorString();
-        break;
+        return m_serialPort->errorString();
+    }
+}
+
+void SerialHandler::onErrorOccurred(QSerialPort::SerialPortError error) {
+    if (error == QSerialPort::NoError) return;
+
+    if (m_reconnecting) {
+        // A reopen attempt failed, typically before udev has applied the
+        // node's permissions; the timer retries, so nothing is modal yet
+        m_lastReconnectError = errorText(error);
+        emit reconnectAttemptFailed(m_lastReconnectError);
+        return;
+    }
+
+    if (error == QSerialPort::ResourceError) {
+        if (m_autoReconnect) {
+            handleDeviceLost();
+            return;
+        }
+        disconnect();
     }
 
-    emit errorOccurred(errorMessage);
+    emit errorOccurred(errorText(error));
 }
@@ -8,25 +8,64 @@
 #include <QAudioFormat>
 #include <QTimer>
 #include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
 #include <atomic>
+#include <vector>
+#include "RealtimeScheduler.h"
+#include "AlsaSidetone.h"
+#include "core/SpscRing.h"
 
 class ToneGenerator;
+class QSocketNotifier;
 
 class KeyWatcher : public QThread {
     Q_OBJECT
 public:
-    explicit KeyWatcher(int fd, QObject *parent = nullptr);
+    explicit KeyWatcher(int fd, const RealtimeConfig& realtime = RealtimeConfig(),
+                        QObject *parent = nullptr);
     void stop();
 
+    // Valid once the thread has started
+    RealtimeStatus realtimeStatus() const;
+    const LatencyStats& latency() const { return m_latency; }
+
+    // Glitch filtering: an edge is only accepted once the line has held its
+    // new state for the minimum mark (key down) or space (key up) duration.
+    void setDebounce(qint64 minMarkUs, qint64 minSpaceUs);
+    quint64 rejectedMarks() const { return m_rejectedMarks; }
+    quint64 rejectedSpaces() const { return m_rejectedSpaces; }
+
+    // Heap allocations made by the capture thread since it began polling
+    quint64 allocations() const { return m_allocations; }
+
 signals:
-    void keyStateChanged(bool down);
+    // timestampNs is the monotonic time of the original (pre-debounce) edge
+    void keyStateChanged(bool down, qint64 timestampNs);
+    // The control lines can no longer be read (device unplugged)
+    void lineLost();
 
 protected:
     void run() override;
 
 private:
+    bool readKeyDown(bool *ok);
+
+    // Real-time mode sleeps on an absolute period instead of spinning, so a
+    // SCHED_FIFO thread never starves its core
+    static constexpr qint64 RT_POLL_PERIOD_NS = 250000;
+
     int m_fd;
     std::atomic<bool> m_running;
+    RealtimeConfig m_realtimeConfig;
+    RealtimeStatus m_realtimeStatus;
+    mutable QMutex m_statusMutex;
+    LatencyStats m_latency;
+    std::atomic<qint64> m_minMarkNs;
+    std::atomic<qint64> m_minSpaceNs;
+    std::atomic<quint64> m_rejectedMarks;
+    std::atomic<quint64> m_rejectedSpaces;
+    std::atomic<quint64> m_allocations;
 };
 
 class SerialHandler : public QObject {
@@ -37,10 +76,28 @@ public:
     ~SerialHandler();
 
     QStringList availablePorts() const;
+    // Enumerates on a worker thread and reports through portsEnumerated()
+    void enumeratePortsAsync();
     bool connectToPort(const QString& portName, qint32 baudRate = 9600);
     void disconnect();
     bool isConnected() const;
 
+    // Auto-reconnect: when the device drops out, the same adapter (matched
+    // by serial number and VID:PID) is reopened as soon as it reappears.
+    // Waiting for it is unlimited; once it is back, failed reopens are
+    // retried for a while and then reported through errorOccurred.
+    struct OutageStats {
+        quint64 count = 0;
+        qint64 lastMs = 0;
+        qint64 maxMs = 0;
+        qint64 totalMs = 0;
+    };
+    void setAutoReconnect(bool enabled);
+    bool autoReconnect() const { return m_autoReconnect; }
+    bool isReconnecting() const { return m_reconnecting; }
+    OutageStats outageStats() const { return m_outages; }
+    QString portName() const { return m_device.portName; }
+
     // Sidetone settings
     void setSidetoneEnabled(bool enabled);
     bool sidetoneEnabled() const { return m_sidetoneEnabled; }
@@ -48,29 +105,84 @@ public:
     int sidetoneFrequency() const { return m_sidetoneFreq; }
     void setSidetoneVolume(float volume);
 
+    // Direct ALSA/PipeWire output falls back to Qt Multimedia when the
+    // device cannot be opened. Switching reopens the output immediately,
+    // briefly pausing the key watcher if connected.
+    enum class SidetoneBackend { QtMultimedia, Alsa, PipeWire };
+    void setSidetoneBackend(SidetoneBackend backend, const AlsaSidetoneConfig& alsaConfig);
+    // Output actually in use, its buffer, and the measured key-to-tone delay
+    QString sidetoneDescription() const;
+    qint64 sidetoneBufferUs() const;
+    const LatencyStats *sidetoneLatency() const;
+
+public slots:
+    // Audio output is opened lazily, off the startup path; idempotent
+    void prepareAudio();
+    // Hotplug hint from DeviceMonitor; triggers an immediate reopen attempt
+    void onDeviceAppeared(const QString& devNode);
+
+public:
+    // Debounce / glitch rejection (applied in the capture thread)
+    void setDebounce(int minMarkMs, int minSpaceMs);
+    void setAdaptiveDebounce(bool enabled);
+    void setDebounceUnitTime(qint64 unitMs);
+    quint64 rejectedGlitches() const;
+
+    // Opt-in real-time capture; takes effect on the next connect
+    void setRealtimeConfig(const RealtimeConfig& config);
+    RealtimeConfig realtimeConfig() const { return m_realtimeConfig; }
+    RealtimeStatus realtimeStatus() const;
+    const LatencyStats *captureLatency() const;
+    quint64 captureAllocations() const;
+
 signals:
     void keyDown();
     void keyUp();
+    // Emitted alongside keyDown/keyUp with the capture timestamp
+    // (CLOCK_MONOTONIC ns); always emitted on the main thread
+    void keyEdge(bool down, qint64 timestampNs);
     void elementReceived(bool isDit); // For character mode
     void connected();
     void disconnected();
+    void connectionLost();              // Device vanished, reconnect pending
+    void reconnected(qint64 outageMs);  // Same device reopened
+    // A reopen attempt during an outage failed; it is retried. Errors are
+    // only reported through errorOccurred once the retries run out.
+    void reconnectAttemptFailed(const QString& error);
+    void keyInterrupted();              // Key was down when the device vanished
     void errorOccurred(const QString& error);
-    void dataReceived(const QByteArray& data);
+    void dataReceived(const QByteArray& data); // Raw bytes; allocates a copy per read while connected
+    void portsEnumerated(const QStringList& ports);
 
 private slots:
     void onReadyRead();
     void onErrorOccurred(QSerialPort::SerialPortError error);
-    void onKeyStateChanged(bool down);
+    void onKeyStateChanged(bool down, qint64 timestampNs);
+    void onLineLost();
+    void tryReconnect();
     void writeAudioData();
+    void drainKeyEdges();
 
 private:
     void parseData(const QByteArray& data);
     void initializeAudio();
-    void startTone();
+    void shutdownAudio();
+    void startTone(qint64 timestampNs);
     void stopTone();
+    void applyDebounce();
+    bool openPort(const QString& portName, qint32 baudRate);
+    void stopKeyWatcher();
+    void handleDeviceLost();
+    void abandonReconnect();
+    void giveUpReconnect();
+    void startKeyWatcher();
+    QString errorText(QSerialPort::SerialPortError error) const;
+    void rememberDevice(const QString& portName);
+    QString findRememberedDevice() const;
 
     QSerialPort *m_serialPort;
-    QByteArray m_buffer;
+    static constexpr int READ_CHUNK = 256;
+    char m_readBuffer[READ_CHUNK];
 
     // Serial parsing state machine
     enum class ParseState {
@@ -83,14 +195,69 @@ private:
     // Control line monitoring (interrupt-driven)
     KeyWatcher *m_keyWatcher;
 
+    // Edges reach the main thread through a fixed ring and an eventfd
+    // wake-up instead of queued signals, which allocate per event
+    struct CapturedEdge {
+        qint64 timestampNs;
+        bool down;
+    };
+    static constexpr size_t EDGE_RING_CAPACITY = 256;
+    morse::SpscRing<CapturedEdge, EDGE_RING_CAPACITY> m_edgeRing;
+    int m_edgeEventFd;
+    QSocketNotifier *m_edgeNotifier;
+    quint64 m_allocationsTotal; // Capture threads already stopped
+
+    // Debounce settings; adaptive mode raises the minimums to a fraction
+    // of the decoder's current unit time
+    int m_minMarkMs;
+    int m_minSpaceMs;
+    bool m_adaptiveDebounce;
+    qint64 m_unitTimeMs;
+    quint64 m_rejectedTotal;
+
+    RealtimeConfig m_realtimeConfig;
+
+    QThread *m_enumerationThread;
+    bool m_enumerateAgain;
+    bool m_enumeratedOnce; // Only the startup scan goes to the startup profile
+
+    // Identity of the connected adapter, used to find it again after an
+    // outage even if it comes back under a different ttyUSBn
+    struct DeviceIdentity {
+        QString portName;
+        QString serialNumber;
+        quint16 vendorId = 0;
+        quint16 productId = 0;
+        bool hasUsbIds = false;
+    };
+    DeviceIdentity m_device;
+    qint32 m_baudRate;
+    bool m_autoReconnect;
+    bool m_reconnecting;
+    QString m_lastReconnectError; // Most recent failed reopen, reported if we give up
+    int m_reconnectFailures;      // Failed reopens of a device that is present
+    std::atomic<bool> m_keyIsDown;
+    QElapsedTimer m_outageTimer;
+    QTimer *m_reconnectTimer;
+    OutageStats m_outages;
+
     // Audio/sidetone (push-mode)
     QAudioSink *m_audioSink;
+    bool m_audioPrepared;
     ToneGenerator *m_toneGenerator;
     QIODevice *m_audioIO;
     QTimer *m_audioTimer;
+    std::vector<char> m_audioBuffer; // Sized once when the sink starts
     bool m_sidetoneEnabled;
     int m_sidetoneFreq;
     float m_sidetoneVolume;
+
+    // Direct output, and the edge timing of tones through QAudioSink
+    SidetoneBackend m_sidetoneBackend;
+    AlsaSidetoneConfig m_alsaConfig;
+    AlsaSidetone *m_alsaSidetone;
+    std::atomic<qint64> m_toneEdgeNs; // Tone start awaiting measurement, 0 = none
+    LatencyStats m_sinkLatency;
 };
 
 #endif // SERIALHANDLER_H
@@ -0,0 +1,243 @@
+#include "SessionLogger.h"
+#include "core/Trace.h"
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+// %f follows the process locale, which Qt takes from the environment; the
+// log always uses a '.', so confidence is written as whole hundredths
+int confidenceHundredths(float confidence) {
+    return static_cast<int>(std::lround(std::clamp(confidence, 0.0f, 1.0f) * 100.0f));
+}
+
+// toLatin1() gives '\0' outside Latin-1, which must not reach the file
+char logCharacterByte(QChar character) {
+    char byte = character.toLatin1();
+    return byte != '\0' ? byte : '?';
+}
+}
+
+SessionLogger::SessionLogger(QObject *parent)
+    : QThread(parent)
+    , m_compress(false)
+    , m_zstream(nullptr)
+    , m_stopRequested(false)
+    , m_open(false)
+    , m_recordsWritten(0)
+    , m_recordsDropped(0)
+    , m_bytesWritten(0)
+    , m_pendingRecords(0)
+{
+    m_pending.reserve(FLUSH_BYTES * 2);
+    m_writing.reserve(FLUSH_BYTES * 2);
+}
+
+SessionLogger::~SessionLogger() {
+    close();
+}
+
+QString SessionLogger::defaultLogPath(bool compress) {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/sessions";
+    QDir().mkpath(dir);
+    QString name = "session-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".log";
+    if (compress) name += ".gz";
+    return dir + "/" + name;
+}
+
+bool SessionLogger::compressionAvailable() {
+#ifdef HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SessionLogger::open(const QString& path, bool compress) {
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "Cannot open session log" << path << m_file.errorString();
+        return false;
+    }
+
+    m_compress = compress && compressionAvailable();
+#ifdef HAVE_ZLIB
+    if (m_compress) {
+        z_stream *zs = new z_stream{};
+        // windowBits 15 + 16 selects a gzip wrapper
+        if (deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            delete zs;
+            m_compress = false;
+        } else {
+            m_zstream = zs;
+            m_compressed.resize(FLUSH_BYTES);
+        }
+    }
+#endif
+
+    m_stopRequested = false;
+    m_recordsWritten = 0;
+    m_recordsDropped = 0;
+    m_bytesWritten = 0;
+    m_pendingRecords = 0;
+    m_pending.clear();
+
+    QByteArray header = "# morse-decoder session log v2 started "
+                        + QDateTime::currentDateTime().toString(Qt::ISODateWithMs).toUtf8() + "\n";
+    m_pending.insert(m_pending.end(), header.constBegin(), header.constEnd());
+
+    m_open = true;
+    start(QThread::LowPriority);
+    return true;
+}
+
+void SessionLogger::close() {
+    if (!m_open) return;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopRequested = true;
+        m_wake.wakeOne();
+    }
+    wait();
+    m_open = false;
+
+#ifdef HAVE_ZLIB
+    if (m_zstream) {
+        z_stream *zs = static_cast<z_stream *>(m_zstream);
+        deflateEnd(zs);
+        delete zs;
+        m_zstream = nullptr;
+    }
+#endif
+    m_file.close();
+}
+
+void SessionLogger::append(char type, const char *payload, int length) {
+    if (!m_open) return;
+
+    char line[96];
+    int prefix = std::snprintf(line, sizeof(line), "%lld\t%c\t",
+                               static_cast<long long>(QDateTime::currentMSecsSinceEpoch()), type);
+
+    QMutexLocker lock(&m_mutex);
+    if (m_pending.size() + prefix + length + 1 > MAX_PENDING_BYTES) {
+        ++m_recordsDropped;
+        return;
+    }
+    m_pending.insert(m_pending.end(), line, line + prefix);
+    m_pending.insert(m_pending.end(), payload, payload + length);
+    m_pending.push_back('\n');
+    ++m_pendingRecords;
+
+    if (m_pending.size() >= FLUSH_BYTES) {
+        m_wake.wakeOne();
+    }
+}
+
+void SessionLogger::logCharacter(QChar character, float confidence) {
+    char buffer[16];
+    int hundredths = confidenceHundredths(confidence);
+    int length = std::snprintf(buffer, sizeof(buffer), "%c\t%d.%02d", logCharacterByte(character),
+                               hundredths / 100, hundredths % 100);
+    append('C', buffer, length);
+}
+
+void SessionLogger::logWordSpace() {
+    append('W', "", 0);
+}
+
+void SessionLogger::logError(const QString& pattern, float confidence) {
+    char buffer[48];
+    int length = 0;
+    for (int i = 0; i < pattern.size() && length < 32; ++i) {
+        buffer[length++] = logCharacterByte(pattern.at(i));
+    }
+    int hundredths = confidenceHundredths(confidence);
+    length += std::snprintf(buffer + length, sizeof(buffer) - length, "\t%d.%02d",
+                            hundredths / 100, hundredths % 100);
+    append('E', buffer, qMin(length, int(sizeof(buffer)) - 1));
+}
+
+void SessionLogger::logMark(qint64 durationMs, bool isDit) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%lld\t%s",
+                               static_cast<long long>(durationMs), isDit ? "dit" : "dah");
+    append('M', buffer, length);
+}
+
+void SessionLogger::logSpace(qint64 durationMs) {
+    char buffer[24];
+    int length = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(durationMs));
+    append('S', buffer, length);
+}
+
+void SessionLogger::logSpeedChange(int wpm, qint64 previousSegmentMs) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%d\t%lld",
+                               wpm, static_cast<long long>(previousSegmentMs));
+    append('V', buffer, length);
+}
+
+void SessionLogger::run() {
+    MORSE_TRACE_THREAD_NAME("session logger");
+    bool stopping = false;
+    while (!stopping) {
+        quint64 records = 0;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (!m_stopRequested && m_pending.size() < FLUSH_BYTES) {
+                m_wake.wait(&m_mutex, FLUSH_INTERVAL_MS);
+            }
+            stopping = m_stopRequested;
+            m_pending.swap(m_writing);
+            records = m_pendingRecords;
+            m_pendingRecords = 0;
+        }
+
+        if (!m_writing.empty() || stopping) {
+            MORSE_TRACE_SCOPE("SessionLogger::writeBatch");
+            writeBatch(m_writing, stopping);
+            m_recordsWritten += records;
+            m_writing.clear();
+        }
+    }
+}
+
+bool SessionLogger::writeBatch(const std::vector<char>& batch, bool finish) {
+#ifdef HAVE_ZLIB
+    if (m_compress && m_zstream) {
+        z_stream *zs = static_cast<z_stream *>(m_zstream);
+        zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(batch.data()));
+        zs->avail_in = static_cast<uInt>(batch.size());
+        int flush = finish ? Z_FINISH : Z_SYNC_FLUSH;
+        do {
+            zs->next_out = reinterpret_cast<Bytef *>(m_compressed.data());
+            zs->avail_out = static_cast<uInt>(m_compressed.size());
+            deflate(zs, flush);
+            qint64 produced = m_compressed.size() - zs->avail_out;
+            if (produced > 0 && m_file.write(m_compressed.data(), produced) != produced) {
+                return false;
+            }
+            m_bytesWritten += produced;
+        } while (zs->avail_out == 0);
+        return m_file.flush();
+    }
+#else
+    Q_UNUSED(finish);
+#endif
+    if (batch.empty()) return true;
+    qint64 written = m_file.write(batch.data(), static_cast<qint64>(batch.size()));
+    if (written > 0) m_bytesWritten += written;
+    return written == static_cast<qint64>(batch.size()) && m_file.flush();
+}
@@ -0,0 +1,80 @@
+#ifndef SESSIONLOGGER_H
+#define SESSIONLOGGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <atomic>
+#include <vector>
+
+// Writes decoded traffic to a line-oriented log from a background thread.
+// Producers only format into an in-memory batch under a short lock; the
+// writer swaps batches and issues one large write per flush, so the GUI and
+// decode path never wait on the disk. Each line is
+//
+//     <epoch ms>\t<type>\t<payload>
+//
+// with type C (character, confidence), W (word space), E (undecodable
+// pattern, confidence), M (mark: duration ms, dit/dah), S (space: duration
+// ms) or V (speed change: new WPM, ms sent at the previous speed).
+// Confidence runs from 0.00 (on a decision boundary) to 1.00. Batches always
+// end on a line boundary so the file can be followed with tail -f; with
+// compression each batch is a gzip sync-flush point for zcat.
+class SessionLogger : public QThread {
+    Q_OBJECT
+
+public:
+    explicit SessionLogger(QObject *parent = nullptr);
+    ~SessionLogger();
+
+    bool open(const QString& path, bool compress = false);
+    void close();
+    bool isOpen() const { return m_open; }
+    QString filePath() const { return m_file.fileName(); }
+
+    quint64 recordsWritten() const { return m_recordsWritten; }
+    quint64 recordsDropped() const { return m_recordsDropped; }
+    quint64 bytesWritten() const { return m_bytesWritten; }
+
+    static QString defaultLogPath(bool compress);
+    static bool compressionAvailable();
+
+public slots:
+    void logCharacter(QChar character, float confidence);
+    void logWordSpace();
+    void logError(const QString& pattern, float confidence);
+    void logMark(qint64 durationMs, bool isDit);
+    void logSpace(qint64 durationMs);
+    void logSpeedChange(int wpm, qint64 previousSegmentMs);
+
+protected:
+    void run() override;
+
+private:
+    void append(char type, const char *payload, int length);
+    bool writeBatch(const std::vector<char>& batch, bool finish);
+
+    static constexpr size_t FLUSH_BYTES = 64 * 1024;
+    static constexpr size_t MAX_PENDING_BYTES = 8 * 1024 * 1024;
+    static constexpr unsigned long FLUSH_INTERVAL_MS = 250;
+
+    QFile m_file;
+    bool m_compress;
+    void *m_zstream; // z_stream when compressing
+    std::vector<char> m_compressed;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    std::vector<char> m_pending;   // Filled by producers
+    std::vector<char> m_writing;   // Owned by the writer thread
+    bool m_stopRequested;
+
+    std::atomic<bool> m_open;
+    std::atomic<quint64> m_recordsWritten;
+    std::atomic<quint64> m_recordsDropped;
+    std::atomic<quint64> m_bytesWritten;
+    quint64 m_pendingRecords;
+};
+
+#endif // SESSIONLOGGER_H
@@ -0,0 +1,48 @@
+#include "StartupProfiler.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+
+namespace {
+QElapsedTimer g_clock;
+qint64 g_lastMarkNs = 0;
+QStringList g_phases;
+bool g_reported = false;
+}
+
+void StartupProfiler::start() {
+    g_clock.start();
+    g_lastMarkNs = 0;
+    g_phases.clear();
+    g_reported = false;
+}
+
+void StartupProfiler::mark(const char *phase) {
+    if (!g_clock.isValid() || g_reported) return;
+
+    qint64 now = g_clock.nsecsElapsed();
+    g_phases << QString("%1 %2 ms").arg(phase).arg((now - g_lastMarkNs) / 1e6, 0, 'f', 1);
+    g_lastMarkNs = now;
+}
+
+void StartupProfiler::report() {
+    if (!g_clock.isValid() || g_reported) return;
+    g_reported = true;
+
+    qInfo().noquote() << QString("Startup: %1 ms total (%2)")
+                             .arg(g_lastMarkNs / 1e6, 0, 'f', 1)
+                             .arg(g_phases.join(", "));
+}
+
+void StartupProfiler::recordDeferred(const char *task, qint64 durationMs) {
+    if (!g_clock.isValid()) return;
+
+    qInfo().noquote() << QString("Startup (deferred): %1 took %2 ms, ready %3 ms after launch")
+                             .arg(task)
+                             .arg(durationMs)
+                             .arg(g_clock.elapsed());
+}
+
+qint64 StartupProfiler::elapsedMs() {
+    return g_clock.isValid() ? g_clock.elapsed() : 0;
+}
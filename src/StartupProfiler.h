@@ -0,0 +1,18 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QtGlobal>
+
+// Records how long each launch phase takes so startup regressions show up
+// in the log. Phases are timed back to back from start(); work deferred
+// past the first event loop iteration is reported as it completes.
+class StartupProfiler {
+public:
+    static void start();
+    static void mark(const char *phase);
+    static void report();
+    static void recordDeferred(const char *task, qint64 durationMs);
+    static qint64 elapsedMs();
+};
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,167 @@
+#include "StatsPanel.h"
+#include <QFormLayout>
+#include <QVBoxLayout>
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+namespace {
+// Durations beyond this are rare enough to leave off the plot
+constexpr int PLOT_MAX_MS = 1000;
+
+const QColor CATEGORY_COLORS[OperatorStats::CategoryCount] = {
+    QColor(0, 120, 215),   // Dit
+    QColor(215, 80, 0),    // Dah
+    QColor(120, 120, 120), // Element gap
+    QColor(0, 160, 80),    // Character gap
+    QColor(160, 0, 160),   // Word gap
+};
+
+QString formatDistribution(const DurationHistogram& histogram) {
+    if (histogram.count() == 0) return "-";
+    return QString("%1 ms (p10 %2, p50 %3, p90 %4, n=%5)")
+        .arg(histogram.mean(), 0, 'f', 0)
+        .arg(histogram.quantile(0.1), 0, 'f', 0)
+        .arg(histogram.quantile(0.5), 0, 'f', 0)
+        .arg(histogram.quantile(0.9), 0, 'f', 0)
+        .arg(histogram.count());
+}
+}
+
+HistogramView::HistogramView(const OperatorStats *stats, QWidget *parent)
+    : QWidget(parent)
+    , m_stats(stats)
+{
+    setMinimumHeight(120);
+}
+
+void HistogramView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const int binsShown = PLOT_MAX_MS / DurationHistogram::BIN_MS;
+    const double xScale = double(width()) / binsShown;
+
+    // Normalize each category separately so sparse gaps stay visible
+    for (int c = 0; c < OperatorStats::CategoryCount; ++c) {
+        const DurationHistogram& histogram = m_stats->histogram(static_cast<OperatorStats::Category>(c));
+        if (histogram.count() == 0) continue;
+
+        const auto& bins = histogram.bins();
+        quint32 peak = *std::max_element(bins.begin(), bins.begin() + binsShown);
+        if (peak == 0) continue;
+
+        QPainterPath path;
+        path.moveTo(0, height());
+        for (int i = 0; i < binsShown; ++i) {
+            double y = height() - (double(bins[i]) / peak) * (height() - 4);
+            path.lineTo(i * xScale, y);
+            path.lineTo((i + 1) * xScale, y);
+        }
+        path.lineTo(width(), height());
+
+        QColor fill = CATEGORY_COLORS[c];
+        fill.setAlpha(60);
+        painter.fillPath(path, fill);
+        painter.setPen(CATEGORY_COLORS[c]);
+        painter.drawPath(path);
+    }
+
+    // 100 ms grid
+    painter.setPen(QPen(palette().mid().color(), 1, Qt::DotLine));
+    for (int ms = 100; ms < PLOT_MAX_MS; ms += 100) {
+        int x = static_cast<int>(ms / DurationHistogram::BIN_MS * xScale);
+        painter.drawLine(x, 0, x, height());
+    }
+}
+
+StatsPanel::StatsPanel(QWidget *parent)
+    : QWidget(parent)
+    , m_dirty(true)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    m_histogram = new HistogramView(&m_stats, this);
+    layout->addWidget(m_histogram, 1);
+
+    QFormLayout *form = new QFormLayout();
+    m_wpmLabel = new QLabel(this);
+    m_ditLabel = new QLabel(this);
+    m_dahLabel = new QLabel(this);
+    m_ratioLabel = new QLabel(this);
+    m_weightLabel = new QLabel(this);
+    m_charGapLabel = new QLabel(this);
+    m_wordGapLabel = new QLabel(this);
+
+    auto colored = [](const QString& text, OperatorStats::Category category) {
+        return QString("<span style='color:%1'>%2</span>").arg(CATEGORY_COLORS[category].name(), text);
+    };
+    form->addRow("Speed:", m_wpmLabel);
+    form->addRow(colored("Dit:", OperatorStats::Dit), m_ditLabel);
+    form->addRow(colored("Dah:", OperatorStats::Dah), m_dahLabel);
+    form->addRow("Dah/dit:", m_ratioLabel);
+    form->addRow(colored("Weight:", OperatorStats::ElementGap), m_weightLabel);
+    form->addRow(colored("Char gap:", OperatorStats::CharacterGap), m_charGapLabel);
+    form->addRow(colored("Word gap:", OperatorStats::WordGap), m_wordGapLabel);
+    layout->addLayout(form);
+
+    // Updates only mark the panel dirty; drawing happens at a fixed rate
+    connect(&m_refreshTimer, &QTimer::timeout, this, &StatsPanel::refresh);
+    m_refreshTimer.setInterval(250);
+}
+
+void StatsPanel::addMark(qint64 durationMs, bool isDit) {
+    m_stats.addMark(durationMs, isDit);
+    m_dirty = true;
+}
+
+void StatsPanel::addSpace(qint64 durationMs) {
+    m_stats.addSpace(durationMs);
+    m_dirty = true;
+}
+
+void StatsPanel::addCharacter() {
+    m_stats.addCharacter();
+    m_dirty = true;
+}
+
+void StatsPanel::setUnitTime(qint64 unitMs) {
+    m_stats.setUnitTime(unitMs);
+}
+
+void StatsPanel::reset() {
+    m_stats.reset();
+    m_dirty = true;
+    refresh();
+}
+
+void StatsPanel::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    m_refreshTimer.start();
+    refresh();
+}
+
+void StatsPanel::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    m_refreshTimer.stop();
+}
+
+void StatsPanel::refresh() {
+    if (!m_dirty || !isVisible()) return;
+    m_dirty = false;
+
+    m_wpmLabel->setText(QString("%1 WPM (dits), %2 WPM effective")
+                            .arg(m_stats.ditWpm(), 0, 'f', 1)
+                            .arg(m_stats.effectiveWpm(), 0, 'f', 1));
+    m_ditLabel->setText(formatDistribution(m_stats.histogram(OperatorStats::Dit)));
+    m_dahLabel->setText(formatDistribution(m_stats.histogram(OperatorStats::Dah)));
+    m_ratioLabel->setText(QString::number(m_stats.dahDitRatio(), 'f', 2));
+    m_weightLabel->setText(QString::number(m_stats.weight(), 'f', 2));
+    m_charGapLabel->setText(formatDistribution(m_stats.histogram(OperatorStats::CharacterGap))
+                            + QString(", CV %1%").arg(m_stats.characterGapVariation() * 100, 0, 'f', 0));
+    m_wordGapLabel->setText(formatDistribution(m_stats.histogram(OperatorStats::WordGap)));
+    m_histogram->update();
+}
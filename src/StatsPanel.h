@@ -0,0 +1,61 @@
+#ifndef STATSPANEL_H
+#define STATSPANEL_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QTimer>
+#include "OperatorStats.h"
+
+// Draws the mark and space distributions of an OperatorStats instance
+class HistogramView : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit HistogramView(const OperatorStats *stats, QWidget *parent = nullptr);
+    QSize sizeHint() const override { return QSize(360, 160); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    const OperatorStats *m_stats;
+};
+
+class StatsPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit StatsPanel(QWidget *parent = nullptr);
+
+    OperatorStats *stats() { return &m_stats; }
+
+public slots:
+    void addMark(qint64 durationMs, bool isDit);
+    void addSpace(qint64 durationMs);
+    void addCharacter();
+    void setUnitTime(qint64 unitMs);
+    void reset();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    OperatorStats m_stats;
+    QTimer m_refreshTimer;
+    bool m_dirty;
+
+    HistogramView *m_histogram;
+    QLabel *m_wpmLabel;
+    QLabel *m_ditLabel;
+    QLabel *m_dahLabel;
+    QLabel *m_ratioLabel;
+    QLabel *m_weightLabel;
+    QLabel *m_charGapLabel;
+    QLabel *m_wordGapLabel;
+};
+
+#endif // STATSPANEL_H
@@ -0,0 +1,119 @@
+#include "WaterfallPanel.h"
+#include <QHBoxLayout>
+#include <QMediaDevices>
+#include <QVBoxLayout>
+
+WaterfallPanel::WaterfallPanel(AudioInput *input, QWidget *parent)
+    : QWidget(parent)
+    , m_input(input)
+    , m_cursorHz(-1.0f)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *deviceLayout = new QHBoxLayout();
+    m_deviceCombo = new QComboBox(this);
+    m_listenBtn = new QPushButton("Listen", this);
+    m_listenBtn->setToolTip("Decode CW from this audio input");
+    deviceLayout->addWidget(new QLabel("Input:", this));
+    deviceLayout->addWidget(m_deviceCombo, 1);
+    deviceLayout->addWidget(m_listenBtn);
+    layout->addLayout(deviceLayout);
+
+    m_waterfall = new WaterfallWidget(m_input, this);
+    m_waterfall->setToolTip("Click a signal to decode it");
+    layout->addWidget(m_waterfall, 1);
+
+    QHBoxLayout *statusLayout = new QHBoxLayout();
+    m_toneLabel = new QLabel(this);
+    m_statsLabel = new QLabel(this);
+    statusLayout->addWidget(m_toneLabel);
+    statusLayout->addStretch();
+    statusLayout->addWidget(m_statsLabel);
+    layout->addLayout(statusLayout);
+
+    connect(m_listenBtn, &QPushButton::clicked, this, &WaterfallPanel::onListenClicked);
+    connect(m_waterfall, &WaterfallWidget::frequencySelected, this, &WaterfallPanel::onFrequencySelected);
+    connect(m_waterfall, &WaterfallWidget::cursorFrequencyChanged, this, &WaterfallPanel::onCursorFrequencyChanged);
+    connect(m_waterfall, &WaterfallWidget::frameStatsUpdated, this, &WaterfallPanel::onFrameStatsUpdated);
+    connect(m_input, &AudioInput::errorOccurred, m_statsLabel, &QLabel::setText);
+
+    QMediaDevices *devices = new QMediaDevices(this);
+    connect(devices, &QMediaDevices::audioInputsChanged, this, &WaterfallPanel::refreshDevices);
+    refreshDevices();
+    updateToneLabel();
+}
+
+QByteArray WaterfallPanel::deviceId() const {
+    return m_deviceCombo->currentData().toByteArray();
+}
+
+void WaterfallPanel::setDeviceId(const QByteArray& id) {
+    int index = m_deviceCombo->findData(id);
+    if (index >= 0) m_deviceCombo->setCurrentIndex(index);
+}
+
+void WaterfallPanel::setToneFrequency(float frequencyHz) {
+    m_input->setToneFrequency(frequencyHz);
+    m_waterfall->setToneFrequency(frequencyHz);
+    updateToneLabel();
+}
+
+void WaterfallPanel::refreshDevices() {
+    QByteArray selected = deviceId();
+    m_deviceCombo->clear();
+    for (const QAudioDevice& device : QMediaDevices::audioInputs()) {
+        m_deviceCombo->addItem(device.description(), device.id());
+    }
+    if (selected.isEmpty()) selected = QMediaDevices::defaultAudioInput().id();
+    setDeviceId(selected);
+    m_listenBtn->setEnabled(m_deviceCombo->count() > 0 || m_input->isRunning());
+}
+
+void WaterfallPanel::onListenClicked() {
+    if (m_input->isRunning()) {
+        m_input->stop();
+        m_listenBtn->setText("Listen");
+        m_deviceCombo->setEnabled(true);
+        m_statsLabel->clear();
+        return;
+    }
+
+    QByteArray id = deviceId();
+    for (const QAudioDevice& device : QMediaDevices::audioInputs()) {
+        if (device.id() != id) continue;
+        if (m_input->start(device)) {
+            m_waterfall->resetSpectrum();
+            m_listenBtn->setText("Stop");
+            m_deviceCombo->setEnabled(false);
+            m_statsLabel->setText(m_input->description());
+        }
+        return;
+    }
+    m_statsLabel->setText("Audio input not found");
+}
+
+void WaterfallPanel::onFrequencySelected(float frequencyHz) {
+    m_input->setToneFrequency(frequencyHz);
+    updateToneLabel();
+}
+
+void WaterfallPanel::onCursorFrequencyChanged(float frequencyHz) {
+    m_cursorHz = frequencyHz;
+    updateToneLabel();
+}
+
+void WaterfallPanel::updateToneLabel() {
+    QString text = QString("Tone: %1 Hz").arg(m_input->toneFrequency(), 0, 'f', 0);
+    if (m_cursorHz >= 0) text += QString("  Cursor: %1 Hz").arg(m_cursorHz, 0, 'f', 0);
+    m_toneLabel->setText(text);
+}
+
+void WaterfallPanel::onFrameStatsUpdated() {
+    WaterfallWidget::FrameStats stats = m_waterfall->frameStats();
+    m_statsLabel->setText(QString("%1 fps, frame %2 ms (max %3), %4 late, %5 rows dropped")
+                              .arg(stats.fps, 0, 'f', 0)
+                              .arg(stats.meanMs, 0, 'f', 2)
+                              .arg(stats.maxMs, 0, 'f', 2)
+                              .arg(stats.lateFrames)
+                              .arg(stats.droppedRows));
+}
@@ -0,0 +1,41 @@
+#ifndef WATERFALLPANEL_H
+#define WATERFALLPANEL_H
+
+#include <QWidget>
+#include <QComboBox>
+#include <QLabel>
+#include <QPushButton>
+#include "AudioInput.h"
+#include "WaterfallWidget.h"
+
+// Audio input controls, the waterfall and its frame metrics
+class WaterfallPanel : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaterfallPanel(AudioInput *input, QWidget *parent = nullptr);
+
+    QByteArray deviceId() const;
+    void setDeviceId(const QByteArray& id);
+    void setToneFrequency(float frequencyHz);
+
+private slots:
+    void onListenClicked();
+    void onFrequencySelected(float frequencyHz);
+    void onCursorFrequencyChanged(float frequencyHz);
+    void onFrameStatsUpdated();
+    void refreshDevices();
+
+private:
+    void updateToneLabel();
+
+    AudioInput *m_input;
+    WaterfallWidget *m_waterfall;
+    QComboBox *m_deviceCombo;
+    QPushButton *m_listenBtn;
+    QLabel *m_toneLabel;
+    QLabel *m_statsLabel;
+    float m_cursorHz;
+};
+
+#endif // WATERFALLPANEL_H
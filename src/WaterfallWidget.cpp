@@ -0,0 +1,257 @@
+#include "WaterfallWidget.h"
+#include "core/Trace.h"
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+constexpr int FRAME_MS = 16;               // 60 fps
+constexpr qint64 STATS_WINDOW_NS = 1000000000;
+constexpr qint64 LATE_FRAME_NS = 2 * FRAME_MS * 1000000LL;
+constexpr float RANGE_DB = 60.0f;          // Colors span this far above the floor
+constexpr float FLOOR_MARGIN_DB = 5.0f;    // Noise sits just above black
+constexpr float FLOOR_ALPHA = 0.02f;
+constexpr int SNAP_BINS = 3;               // Clicks snap to a peak this close
+
+// Black -> blue -> cyan -> yellow -> white
+QRgb paletteColor(int index) {
+    static const int STOPS[][3] = {
+        {0, 0, 0}, {0, 0, 160}, {0, 180, 220}, {240, 230, 0}, {255, 255, 255},
+    };
+    constexpr int SEGMENTS = 4;
+    float position = float(index) / 255.0f * SEGMENTS;
+    int segment = std::min(int(position), SEGMENTS - 1);
+    float t = position - float(segment);
+    auto mix = [&](int channel) {
+        return int(STOPS[segment][channel] + t * (STOPS[segment + 1][channel] - STOPS[segment][channel]));
+    };
+    return qRgb(mix(0), mix(1), mix(2));
+}
+}
+
+WaterfallWidget::WaterfallWidget(AudioInput *input, QWidget *parent)
+    : QWidget(parent)
+    , m_input(input)
+    , m_topRow(0)
+    , m_bins(1)
+    , m_binHz(1.0f)
+    , m_floorDb(0.0f)
+    , m_toneHz(input->toneFrequency())
+    , m_cursorX(-1)
+    , m_lastFrameNs(0)
+    , m_paintNs(0)
+    , m_windowStartNs(0)
+    , m_windowFrames(0)
+    , m_windowWorkNs(0)
+    , m_windowMaxNs(0)
+{
+    // Every pixel comes from the image, so Qt need not clear first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMouseTracking(true);
+    setCursor(Qt::CrossCursor);
+    setMinimumHeight(80);
+
+    for (int i = 0; i < 256; ++i) {
+        m_palette[i] = paletteColor(i);
+    }
+    std::fill(std::begin(m_lastRow.levels), std::end(m_lastRow.levels), 0.0f);
+
+    connect(&m_frameTimer, &QTimer::timeout, this, &WaterfallWidget::onFrame);
+    m_frameTimer.setInterval(FRAME_MS);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_clock.start();
+
+    resetSpectrum();
+}
+
+void WaterfallWidget::setToneFrequency(float frequencyHz) {
+    int oldX = columnForFrequency(m_toneHz);
+    m_toneHz = frequencyHz;
+    updateColumn(oldX);
+    updateColumn(columnForFrequency(m_toneHz));
+}
+
+void WaterfallWidget::resetSpectrum() {
+    m_bins = std::max(1, m_input->spectrumBins());
+    m_binHz = m_input->spectrumBinHz();
+    m_floorDb = 0.0f;
+    if (!m_image.isNull()) m_image.fill(Qt::black);
+    buildColumns();
+    update();
+}
+
+void WaterfallWidget::buildColumns() {
+    m_columnBins.resize(size_t(std::max(0, width())));
+    for (int x = 0; x < width(); ++x) {
+        m_columnBins[size_t(x)] = std::min(m_bins - 1, int((x + 0.5f) * m_bins / width()));
+    }
+}
+
+int WaterfallWidget::columnForFrequency(float frequencyHz) const {
+    return int(frequencyHz / (m_bins * m_binHz) * width());
+}
+
+float WaterfallWidget::frequencyForColumn(int x) const {
+    return (x + 0.5f) * m_bins * m_binHz / width();
+}
+
+void WaterfallWidget::updateColumn(int x) {
+    if (x >= 0 && x < width()) update(QRect(x, 0, 1, height()));
+}
+
+void WaterfallWidget::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    // History is dropped; rescaling it would cost more than it shows
+    m_image = QImage(size(), QImage::Format_RGB32);
+    m_image.fill(Qt::black);
+    m_topRow = 0;
+    buildColumns();
+}
+
+void WaterfallWidget::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    m_input->setSpectrumEnabled(true);
+    m_frameTimer.start();
+}
+
+void WaterfallWidget::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    m_input->setSpectrumEnabled(false);
+    m_frameTimer.stop();
+}
+
+void WaterfallWidget::onFrame() {
+    if (m_image.isNull()) return;
+    MORSE_TRACE_SCOPE("WaterfallWidget::onFrame");
+    qint64 startNs = m_clock.nsecsElapsed();
+
+    int newRows = 0;
+    while (m_input->popSpectrumRow(m_row)) {
+        renderRow(m_row);
+        ++newRows;
+    }
+    if (newRows == 0) return;
+
+    // The backing store is shifted down; only the exposed rows are painted
+    if (newRows < height()) {
+        scroll(0, newRows);
+    } else {
+        update();
+    }
+    // Painting happens after this returns; count the last paint instead
+    recordFrame(m_clock.nsecsElapsed() - startNs + m_paintNs);
+}
+
+void WaterfallWidget::renderRow(const AudioInput::SpectrumRow& row) {
+    const int rows = m_image.height();
+    m_topRow = (m_topRow + rows - 1) % rows;
+
+    float sum = 0.0f;
+    for (int i = 0; i < m_bins; ++i) sum += row.levels[i];
+    float mean = sum / m_bins;
+    m_floorDb = (m_floorDb == 0.0f) ? mean : m_floorDb + FLOOR_ALPHA * (mean - m_floorDb);
+
+    const float bottom = m_floorDb - FLOOR_MARGIN_DB;
+    const float scale = 255.0f / RANGE_DB;
+    QRgb colors[morse::SPECTRUM_MAX_BINS];
+    for (int i = 0; i < m_bins; ++i) {
+        int index = int((row.levels[i] - bottom) * scale);
+        colors[i] = m_palette[std::clamp(index, 0, 255)];
+    }
+
+    QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(m_topRow));
+    const int columns = std::min(m_image.width(), int(m_columnBins.size()));
+    for (int x = 0; x < columns; ++x) {
+        line[x] = colors[m_columnBins[size_t(x)]];
+    }
+    std::memcpy(m_lastRow.levels, row.levels, size_t(m_bins) * sizeof(float));
+}
+
+void WaterfallWidget::paintEvent(QPaintEvent *event) {
+    qint64 startNs = m_clock.nsecsElapsed();
+    QPainter painter(this);
+    QRect area = event->rect() & rect();
+    if (m_image.isNull() || area.isEmpty()) return;
+
+    // Widget row y shows image row (m_topRow + y), in at most two pieces
+    const int rows = m_image.height();
+    int y = area.top();
+    while (y <= area.bottom()) {
+        int source = (m_topRow + y) % rows;
+        int count = std::min(area.bottom() + 1 - y, rows - source);
+        painter.drawImage(QRect(area.left(), y, area.width(), count),
+                          m_image, QRect(area.left(), source, area.width(), count));
+        y += count;
+    }
+
+    int toneX = columnForFrequency(m_toneHz);
+    if (toneX >= area.left() && toneX <= area.right()) {
+        painter.setPen(QColor(255, 60, 60));
+        painter.drawLine(toneX, area.top(), toneX, area.bottom());
+    }
+    if (m_cursorX >= area.left() && m_cursorX <= area.right()) {
+        painter.setPen(QPen(Qt::white, 1, Qt::DotLine));
+        painter.drawLine(m_cursorX, area.top(), m_cursorX, area.bottom());
+    }
+    m_paintNs = m_clock.nsecsElapsed() - startNs;
+}
+
+void WaterfallWidget::mouseMoveEvent(QMouseEvent *event) {
+    int oldX = m_cursorX;
+    m_cursorX = qBound(0, int(event->position().x()), width() - 1);
+    updateColumn(oldX);
+    updateColumn(m_cursorX);
+    emit cursorFrequencyChanged(frequencyForColumn(m_cursorX));
+}
+
+void WaterfallWidget::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton || m_columnBins.empty()) return;
+
+    int x = qBound(0, int(event->position().x()), width() - 1);
+    int center = m_columnBins[size_t(x)];
+    int peak = center;
+    for (int bin = std::max(0, center - SNAP_BINS); bin <= std::min(m_bins - 1, center + SNAP_BINS); ++bin) {
+        if (m_lastRow.levels[bin] > m_lastRow.levels[peak]) peak = bin;
+    }
+    float frequencyHz = peak * m_binHz;
+    setToneFrequency(frequencyHz);
+    emit frequencySelected(frequencyHz);
+}
+
+void WaterfallWidget::leaveEvent(QEvent *event) {
+    QWidget::leaveEvent(event);
+    int oldX = m_cursorX;
+    m_cursorX = -1;
+    updateColumn(oldX);
+    emit cursorFrequencyChanged(-1.0f);
+}
+
+void WaterfallWidget::recordFrame(qint64 workNs) {
+    MORSE_TRACE_COUNTER("waterfall frame us", workNs / 1000);
+    qint64 nowNs = m_clock.nsecsElapsed();
+    qint64 gapNs = nowNs - m_lastFrameNs;
+    if (m_lastFrameNs > 0 && gapNs > LATE_FRAME_NS && gapNs < STATS_WINDOW_NS) {
+        ++m_stats.lateFrames; // Longer gaps are pauses in the input, not stalls
+    }
+    m_lastFrameNs = nowNs;
+
+    ++m_windowFrames;
+    m_windowWorkNs += workNs;
+    m_windowMaxNs = std::max(m_windowMaxNs, workNs);
+
+    qint64 elapsedNs = nowNs - m_windowStartNs;
+    if (elapsedNs < STATS_WINDOW_NS) return;
+
+    m_stats.fps = m_windowFrames * 1e9 / elapsedNs;
+    m_stats.meanMs = m_windowWorkNs / 1e6 / m_windowFrames;
+    m_stats.maxMs = m_windowMaxNs / 1e6;
+    m_stats.droppedRows = m_input->droppedRows();
+    m_windowStartNs = nowNs;
+    m_windowFrames = 0;
+    m_windowWorkNs = 0;
+    m_windowMaxNs = 0;
+    emit frameStatsUpdated();
+}
@@ -0,0 +1,91 @@
+#ifndef WATERFALLWIDGET_H
+#define WATERFALLWIDGET_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QTimer>
+#include <vector>
+#include "AudioInput.h"
+
+// Scrolling spectrum of the audio input, newest row at the top. Rows are
+// rendered once into a ring-scrolled image; each frame scrolls the widget
+// and repaints only the new rows, so the cost does not depend on its
+// height. A click tunes the tone detector to the strongest bin near the
+// cursor.
+class WaterfallWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    // Over the last second: frames that drew rows, and the time the GUI
+    // thread spent on them (rendering the rows and painting)
+    struct FrameStats {
+        double fps = 0.0;
+        double meanMs = 0.0;
+        double maxMs = 0.0;
+        quint64 lateFrames = 0;   // More than two frame periods apart, total
+        quint64 droppedRows = 0;  // Lost before reaching the widget, total
+    };
+
+    explicit WaterfallWidget(AudioInput *input, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override { return QSize(480, 240); }
+    FrameStats frameStats() const { return m_stats; }
+
+    void setToneFrequency(float frequencyHz);
+    void resetSpectrum(); // New device: geometry may have changed
+
+signals:
+    void frequencySelected(float frequencyHz);
+    void cursorFrequencyChanged(float frequencyHz); // Negative when outside
+    void frameStatsUpdated();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+
+private slots:
+    void onFrame();
+
+private:
+    void buildColumns();
+    void renderRow(const AudioInput::SpectrumRow& row);
+    int columnForFrequency(float frequencyHz) const;
+    float frequencyForColumn(int x) const;
+    void updateColumn(int x);
+    void recordFrame(qint64 workNs);
+
+    AudioInput *m_input;
+    QTimer m_frameTimer;
+
+    // Ring of rows: m_topRow holds the newest, older rows follow it
+    QImage m_image;
+    int m_topRow;
+    std::vector<int> m_columnBins; // Bin shown in each column
+    int m_bins;
+    float m_binHz;
+    QRgb m_palette[256];
+    float m_floorDb;               // Noise floor for the color scale, 0 until the first row
+    AudioInput::SpectrumRow m_row;
+    AudioInput::SpectrumRow m_lastRow; // For snapping clicks to a peak
+
+    float m_toneHz;
+    int m_cursorX;
+
+    // Frame metrics
+    QElapsedTimer m_clock;
+    qint64 m_lastFrameNs;
+    qint64 m_paintNs;
+    qint64 m_windowStartNs;
+    int m_windowFrames;
+    qint64 m_windowWorkNs;
+    qint64 m_windowMaxNs;
+    FrameStats m_stats;
+};
+
+#endif // WATERFALLWIDGET_H
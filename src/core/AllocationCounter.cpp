@@ -0,0 +1,151 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+// Read from inside malloc, so it must never need malloc itself
+__attribute__((tls_model("initial-exec"))) thread_local uint64_t t_allocations = 0;
+}
+
+namespace morse {
+
+bool AllocationCounter::isEnabled() {
+#ifdef MORSE_ALLOCATION_COUNTER
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t AllocationCounter::total() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::thisThread() {
+    return t_allocations;
+}
+
+} // namespace morse
+
+#ifdef MORSE_ALLOCATION_COUNTER
+namespace {
+void countAllocation() {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    ++t_allocations;
+}
+}
+
+#ifdef __GLIBC__
+// Qt's containers (QString, QByteArray, QList) allocate with malloc, so
+// the C allocator is replaced too and forwards to glibc's own entry points
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *p, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void *p);
+
+void *malloc(std::size_t size) {
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) {
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, std::size_t size) {
+    if (size) countAllocation(); // Growing in place still asks the allocator
+    return __libc_realloc(p, size);
+}
+
+void *memalign(std::size_t alignment, std::size_t size) {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size) {
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **result, std::size_t alignment, std::size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) return EINVAL;
+    countAllocation();
+    void *p = __libc_memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *result = p;
+    return 0;
+}
+
+void free(void *p) {
+    __libc_free(p);
+}
+}
+#define COUNTED_BY_MALLOC 1
+#else
+#define COUNTED_BY_MALLOC 0
+#endif
+
+namespace {
+void *countedAlloc(std::size_t size) {
+    if (!COUNTED_BY_MALLOC) countAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+void *countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    if (!COUNTED_BY_MALLOC) countAllocation();
+    void *p = nullptr;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (posix_memalign(&p, align < sizeof(void *) ? sizeof(void *) : align, size ? size : 1) != 0) return nullptr;
+    return p;
+}
+void *throwingAlloc(std::size_t size) {
+    while (true) {
+        if (void *p = countedAlloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *throwingAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    while (true) {
+        if (void *p = countedAlignedAlloc(size, alignment)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+}
+
+void *operator new(std::size_t size) { return throwingAlloc(size); }
+void *operator new[](std::size_t size) { return throwingAlloc(size); }
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return throwingAlignedAlloc(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return throwingAlignedAlloc(size, alignment); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, alignment);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedAlloc(size, alignment);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
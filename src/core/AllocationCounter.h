@@ -0,0 +1,33 @@
+#ifndef MORSE_ALLOCATIONCOUNTER_H
+#define MORSE_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+namespace morse {
+
+// Counts heap allocations, process wide and per thread. With
+// MORSE_ALLOCATION_COUNTER defined, this file replaces operator new/delete
+// and, on glibc, malloc, calloc, realloc and the aligned variants for any
+// binary that uses the counter, so Qt's container storage is counted as
+// well; each allocation then costs two extra increments. Elsewhere only
+// operator new is seen. Without the define every count is 0.
+class AllocationCounter {
+public:
+    static bool isEnabled();
+    static uint64_t total();      // Whole process since start
+    static uint64_t thisThread(); // Calling thread since it started
+};
+
+// Allocations made by the calling thread since construction
+class AllocationScope {
+public:
+    AllocationScope() : m_start(AllocationCounter::thisThread()) {}
+    uint64_t count() const { return AllocationCounter::thisThread() - m_start; }
+
+private:
+    uint64_t m_start;
+};
+
+} // namespace morse
+
+#endif // MORSE_ALLOCATIONCOUNTER_H
@@ -0,0 +1,323 @@
+#include "BandSimulator.h"
+#include "MorseCode.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace morse {
+
+namespace {
+constexpr double TWO_PI = 6.283185307179586;
+constexpr double RAMP_SECONDS = 0.005;      // Rise and fall time of a keyed element
+constexpr double QRN_DECAY_SECONDS = 0.04;  // Time constant of a static crash
+
+// Sum of four 16-bit uniforms: close enough to Gaussian for band noise
+constexpr float UNIFORM_SUM_MEAN = 2.0f * 65535.0f;
+constexpr float UNIFORM_SUM_SCALE = 1.0f / 37837.0f;
+
+uint32_t xorshift(uint32_t x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+// Appends a run, merging it into the previous one if the key state matches.
+// Even indices are key-up runs, odd indices key-down.
+void appendRun(std::vector<int32_t>& runs, bool keyDown, int32_t samples) {
+    if (samples <= 0) return;
+    bool lastIsDown = runs.size() % 2 == 0;
+    if (!runs.empty() && lastIsDown == keyDown) {
+        runs.back() += samples;
+        return;
+    }
+    if (runs.empty() && keyDown) runs.push_back(0);
+    runs.push_back(samples);
+}
+
+float smoothstep(float x) {
+    return x * x * (3.0f - 2.0f * x);
+}
+}
+
+BandSimulator::BandSimulator(int sampleRate)
+    : m_sampleRate(sampleRate)
+    , m_rampSamples(std::max(1, int(sampleRate * RAMP_SECONDS)))
+    , m_renderedFrames(0)
+    , m_noiseLevel(0.0f)
+    , m_qrnRate(0.0f)
+    , m_qrnLevel(0.0f)
+    , m_qrnEnvelope(0.0f)
+    , m_eventState(0)
+    , m_envelope{}
+    , m_noise{}
+    , m_pending{}
+    , m_pendingOffset(BLOCK)
+{
+    setSeed(1);
+    double decay = std::exp(-1.0 / (QRN_DECAY_SECONDS * sampleRate));
+    for (int i = 0; i < BLOCK; ++i) {
+        m_qrnDecay[i] = float(std::pow(decay, i));
+    }
+    m_qrnBlockDecay = float(std::pow(decay, BLOCK));
+}
+
+void BandSimulator::setSeed(uint32_t seed) {
+    uint32_t state = seed ? seed : 1;
+    for (uint32_t& lane : m_noiseState) {
+        state = xorshift(state + 0x9e3779b9u);
+        lane = state ? state : 1;
+    }
+    m_eventState = xorshift(state ^ 0x85ebca6bu) | 1;
+}
+
+void BandSimulator::setQrn(float crashesPerSecond, float level) {
+    m_qrnRate = crashesPerSecond;
+    m_qrnLevel = level;
+}
+
+int BandSimulator::addSignal(const SimulatedSignal& signal) {
+    int64_t unit = int64_t(m_sampleRate) * 1200 / (1000 * std::max(1, signal.wpm));
+    // Farnsworth spacing (ARRL): characters at full speed, gaps stretched so
+    // that the overall rate matches the slower speed
+    int64_t characterGap = 3 * unit;
+    int64_t wordGap = 7 * unit;
+    if (signal.farnsworthWpm > 0 && signal.farnsworthWpm < signal.wpm) {
+        double c = signal.wpm;
+        double s = signal.farnsworthWpm;
+        double delay = (60.0 * c - 37.2 * s) / (c * s) * m_sampleRate;
+        characterGap = int64_t(3.0 * delay / 19.0);
+        wordGap = int64_t(7.0 * delay / 19.0);
+    }
+
+    std::vector<int32_t> runs;
+    appendRun(runs, false, int32_t(int64_t(signal.startDelayMs) * m_sampleRate / 1000));
+
+    for (char c : signal.text) {
+        if (c == ' ') {
+            appendRun(runs, false, int32_t(wordGap - characterGap));
+            continue;
+        }
+        Pattern pattern = MorseCode::encode(c);
+        if (pattern.isEmpty()) continue;
+        for (int i = 0; i < pattern.storedLength(); ++i) {
+            appendRun(runs, true, int32_t(pattern.isDah(i) ? 3 * unit : unit));
+            appendRun(runs, false, int32_t(unit));
+        }
+        appendRun(runs, false, int32_t(characterGap - unit));
+    }
+    // Repeating stations pause a word space before starting over
+    appendRun(runs, false, int32_t(wordGap));
+
+    double w = TWO_PI * signal.frequencyHz / m_sampleRate;
+    for (int k = 0; k < LANES; ++k) {
+        m_phaseRe.push_back(float(std::cos(w * k)));
+        m_phaseIm.push_back(float(std::sin(w * k)));
+    }
+    m_stepRe.push_back(float(std::cos(w * LANES)));
+    m_stepIm.push_back(float(std::sin(w * LANES)));
+    m_blockRe.push_back(float(std::cos(w * BLOCK)));
+    m_blockIm.push_back(float(std::sin(w * BLOCK)));
+
+    m_runLeft.push_back(runs.empty() ? 0 : runs[0]);
+    m_keying.push_back(std::move(runs));
+    m_runIndex.push_back(0);
+    m_level.push_back(0.0f);
+    m_repeat.push_back(signal.repeat ? 1 : 0);
+    m_frequencies.push_back(signal.frequencyHz);
+    m_amplitudes.push_back(signal.amplitude);
+    m_qsbDepth.push_back(std::clamp(signal.qsbDepth, 0.0f, 1.0f));
+    m_qsbPhase.push_back(0.0);
+    m_qsbStep.push_back(TWO_PI * signal.qsbRateHz * BLOCK / m_sampleRate);
+    return signalCount() - 1;
+}
+
+void BandSimulator::clearSignals() {
+    m_keying.clear();
+    m_runIndex.clear();
+    m_runLeft.clear();
+    m_level.clear();
+    m_repeat.clear();
+    m_frequencies.clear();
+    m_amplitudes.clear();
+    m_phaseRe.clear();
+    m_phaseIm.clear();
+    m_stepRe.clear();
+    m_stepIm.clear();
+    m_blockRe.clear();
+    m_blockIm.clear();
+    m_qsbDepth.clear();
+    m_qsbPhase.clear();
+    m_qsbStep.clear();
+    m_pendingOffset = BLOCK;
+    m_renderedFrames = 0;
+}
+
+bool BandSimulator::finished() const {
+    bool any = false;
+    for (size_t s = 0; s < m_keying.size(); ++s) {
+        if (m_repeat[s]) continue;
+        any = true;
+        if (m_runIndex[s] < m_keying[s].size() || m_level[s] > 0.0f) return false;
+    }
+    return any || m_keying.empty();
+}
+
+void BandSimulator::render(float *out, int frames) {
+    int written = 0;
+    while (written < frames) {
+        if (m_pendingOffset == BLOCK) {
+            if (frames - written >= BLOCK) {
+                // Whole blocks go straight to the caller's buffer
+                renderBlock(out + written);
+                written += BLOCK;
+                continue;
+            }
+            renderBlock(m_pending);
+            m_pendingOffset = 0;
+        }
+        int count = std::min(frames - written, BLOCK - m_pendingOffset);
+        std::memcpy(out + written, m_pending + m_pendingOffset, count * sizeof(float));
+        m_pendingOffset += count;
+        written += count;
+    }
+    m_renderedFrames += frames;
+}
+
+bool BandSimulator::renderEnvelope(size_t s, float *envelope) {
+    const std::vector<int32_t>& runs = m_keying[s];
+    size_t& index = m_runIndex[s];
+    int32_t& left = m_runLeft[s];
+    float& level = m_level[s];
+    const float step = 1.0f / m_rampSamples;
+    bool audible = level > 0.0f;
+
+    int pos = 0;
+    while (pos < BLOCK) {
+        while (left == 0 && index < runs.size()) {
+            if (++index < runs.size()) left = runs[index];
+        }
+        bool keyDown = false;
+        int count = BLOCK - pos;
+        if (index >= runs.size()) {
+            if (m_repeat[s] && !runs.empty()) {
+                index = 0;
+                left = runs[0];
+                continue;
+            }
+        } else {
+            keyDown = index % 2 == 1;
+            count = std::min(count, int(left));
+            left -= count;
+        }
+
+        // Ramp towards the key state, then hold it
+        float target = keyDown ? 1.0f : 0.0f;
+        int i = 0;
+        for (; i < count && level != target; ++i) {
+            level = keyDown ? std::min(1.0f, level + step) : std::max(0.0f, level - step);
+            envelope[pos + i] = smoothstep(level);
+        }
+        std::fill(envelope + pos + i, envelope + pos + count, smoothstep(level));
+        audible = audible || level > 0.0f;
+        pos += count;
+    }
+    return audible;
+}
+
+void BandSimulator::renderBlock(float *out) {
+    std::fill(out, out + BLOCK, 0.0f);
+
+    for (size_t s = 0; s < m_keying.size(); ++s) {
+        // Slow fading, interpolated linearly across the block
+        double& qsbPhase = m_qsbPhase[s];
+        float depth = m_qsbDepth[s];
+        float gain0 = m_amplitudes[s] * (1.0f - depth * 0.5f * (1.0f - float(std::cos(qsbPhase))));
+        qsbPhase = std::fmod(qsbPhase + m_qsbStep[s], TWO_PI);
+        float gain1 = m_amplitudes[s] * (1.0f - depth * 0.5f * (1.0f - float(std::cos(qsbPhase))));
+        float gainStep = (gain1 - gain0) / BLOCK;
+
+        float re[LANES];
+        float im[LANES];
+        std::memcpy(re, &m_phaseRe[s * LANES], sizeof(re));
+        std::memcpy(im, &m_phaseIm[s * LANES], sizeof(im));
+
+        if (!renderEnvelope(s, m_envelope)) {
+            // Silent: advance the oscillator without rendering
+            const float br = m_blockRe[s];
+            const float bi = m_blockIm[s];
+            for (int k = 0; k < LANES; ++k) {
+                float r = re[k] * br - im[k] * bi;
+                im[k] = re[k] * bi + im[k] * br;
+                re[k] = r;
+            }
+        } else {
+            const float sr = m_stepRe[s];
+            const float si = m_stepIm[s];
+            for (int j = 0; j < BLOCK; j += LANES) {
+                for (int k = 0; k < LANES; ++k) {
+                    out[j + k] += (gain0 + gainStep * float(j + k)) * m_envelope[j + k] * re[k];
+                }
+                for (int k = 0; k < LANES; ++k) {
+                    float r = re[k] * sr - im[k] * si;
+                    im[k] = re[k] * si + im[k] * sr;
+                    re[k] = r;
+                }
+            }
+        }
+
+        // Pull the phasors back onto the unit circle against rounding drift
+        for (int k = 0; k < LANES; ++k) {
+            float g = 1.5f - 0.5f * (re[k] * re[k] + im[k] * im[k]);
+            re[k] *= g;
+            im[k] *= g;
+        }
+        std::memcpy(&m_phaseRe[s * LANES], re, sizeof(re));
+        std::memcpy(&m_phaseIm[s * LANES], im, sizeof(im));
+    }
+
+    addNoise(out);
+}
+
+void BandSimulator::addNoise(float *out) {
+    // Static crashes arrive as a Poisson process, checked once per block
+    if (m_qrnRate > 0.0f) {
+        m_eventState = xorshift(m_eventState);
+        float chance = m_qrnRate * BLOCK / m_sampleRate;
+        if ((m_eventState >> 8) * (1.0f / 16777216.0f) < chance) {
+            m_qrnEnvelope = 0.3f + 0.7f * float(xorshift(m_eventState) >> 8) / 16777216.0f;
+        }
+    }
+    float crash = m_qrnEnvelope * m_qrnLevel;
+    if (m_noiseLevel <= 0.0f && crash <= 1e-4f) {
+        m_qrnEnvelope = 0.0f;
+        return;
+    }
+
+    uint32_t state[LANES];
+    std::memcpy(state, m_noiseState, sizeof(state));
+    for (int j = 0; j < BLOCK; j += LANES) {
+        for (int k = 0; k < LANES; ++k) {
+            uint32_t a = xorshift(state[k]);
+            uint32_t b = xorshift(a);
+            state[k] = b;
+            float sum = float(a & 0xffff) + float(a >> 16) + float(b & 0xffff) + float(b >> 16);
+            m_noise[j + k] = (sum - UNIFORM_SUM_MEAN) * UNIFORM_SUM_SCALE;
+        }
+    }
+    std::memcpy(m_noiseState, state, sizeof(state));
+
+    for (int j = 0; j < BLOCK; ++j) {
+        out[j] += m_noise[j] * (m_noiseLevel + crash * m_qrnDecay[j]);
+    }
+    m_qrnEnvelope *= m_qrnBlockDecay;
+}
+
+void BandSimulator::toInt16(const float *in, int16_t *out, int frames) {
+    for (int i = 0; i < frames; ++i) {
+        float v = std::min(1.0f, std::max(-1.0f, in[i]));
+        out[i] = static_cast<int16_t>(v * 32767.0f);
+    }
+}
+
+} // namespace morse
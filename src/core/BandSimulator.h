@@ -0,0 +1,102 @@
+#ifndef MORSE_BANDSIMULATOR_H
+#define MORSE_BANDSIMULATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace morse {
+
+struct SimulatedSignal {
+    std::string text;
+    int wpm = 20;
+    int farnsworthWpm = 0;      // Slower overall speed via longer gaps; 0 = off
+    float frequencyHz = 700.0f;
+    float amplitude = 0.5f;     // Linear, full scale is 1.0
+    float qsbDepth = 0.0f;      // 0 = steady, 1 = fades to silence
+    float qsbRateHz = 0.1f;
+    int startDelayMs = 0;
+    bool repeat = false;        // Background stations keep calling
+};
+
+// Renders a simulated CW band: any number of keyed signals plus white
+// noise and impulsive static crashes (QRN), mixed in fixed blocks.
+//
+// Per-signal state is kept as structure-of-arrays and every inner loop
+// runs over BLOCK samples or LANES oscillator lanes without branches, so
+// the compiler vectorizes them. Each oscillator is LANES phasors spaced
+// one sample apart, all rotated by LANES samples per step, which avoids
+// sin() in the sample loop and the serial dependency of a single phasor.
+class BandSimulator {
+public:
+    static constexpr int BLOCK = 256;
+    static constexpr int LANES = 8;
+
+    explicit BandSimulator(int sampleRate = 44100);
+
+    // Keying is precomputed here; render() itself never allocates
+    int addSignal(const SimulatedSignal& signal);
+    void clearSignals();
+    int signalCount() const { return static_cast<int>(m_frequencies.size()); }
+
+    void setNoiseLevel(float rms) { m_noiseLevel = rms; }
+    void setQrn(float crashesPerSecond, float level);
+    void setSeed(uint32_t seed);
+
+    // Writes frames mono float samples; the mix is not clipped
+    void render(float *out, int frames);
+    // True once every non-repeating signal has sent its text
+    bool finished() const;
+    int64_t renderedFrames() const { return m_renderedFrames; }
+    int sampleRate() const { return m_sampleRate; }
+
+    // Converts with clipping to [-1, 1]
+    static void toInt16(const float *in, int16_t *out, int frames);
+
+private:
+    void renderBlock(float *out);
+    bool renderEnvelope(size_t signal, float *envelope); // False if silent throughout
+    void addNoise(float *out);
+
+    int m_sampleRate;
+    int m_rampSamples;
+    int64_t m_renderedFrames;
+
+    // Per-signal state (structure of arrays)
+    std::vector<std::vector<int32_t>> m_keying; // Alternating off/on run lengths in samples
+    std::vector<size_t> m_runIndex;
+    std::vector<int32_t> m_runLeft;
+    std::vector<float> m_level;                 // Keying envelope, 0..1
+    std::vector<uint8_t> m_repeat;
+    std::vector<float> m_frequencies;
+    std::vector<float> m_amplitudes;
+    std::vector<float> m_phaseRe;               // LANES per signal
+    std::vector<float> m_phaseIm;
+    std::vector<float> m_stepRe;                // Rotation by LANES samples
+    std::vector<float> m_stepIm;
+    std::vector<float> m_blockRe;               // Rotation by BLOCK samples, for silent blocks
+    std::vector<float> m_blockIm;
+    std::vector<float> m_qsbDepth;
+    std::vector<double> m_qsbPhase;
+    std::vector<double> m_qsbStep;              // Radians per block
+
+    // Noise
+    float m_noiseLevel;
+    float m_qrnRate;
+    float m_qrnLevel;
+    float m_qrnEnvelope;
+    uint32_t m_noiseState[LANES];
+    uint32_t m_eventState;
+    float m_qrnDecay[BLOCK];                    // Crash decay per sample offset
+    float m_qrnBlockDecay;
+
+    // Scratch buffers for one block
+    float m_envelope[BLOCK];
+    float m_noise[BLOCK];
+    float m_pending[BLOCK];                     // Rendered block not yet handed out
+    int m_pendingOffset;
+};
+
+} // namespace morse
+
+#endif // MORSE_BANDSIMULATOR_H
@@ -0,0 +1,599 @@
+#include "BatchDecoder.h"
+#include "DecoderEngine.h"
+#include "Trace.h"
+#include "WavReader.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <memory>
+#include <sys/stat.h>
+
+namespace morse {
+
+namespace {
+constexpr int64_t DETECT_BLOCK_SECONDS = 60;
+constexpr int64_t DETECT_WARMUP_SECONDS = 3;  // Lets the level trackers settle before a block
+constexpr int64_t TONE_ESTIMATE_SECONDS = 30; // All that estimateFrequency() looks at
+constexpr int64_t LINE_BREAK_SILENCE_US = 60 * 1000000LL;
+
+enum class Kind { Audio, KeyTimings, SessionLog };
+
+struct FileJob {
+    std::string path;
+    std::string referencePath;
+    std::string transcriptPath;
+    Kind kind;
+    BatchFileResult result;
+
+    WavReader wav; // Mapped; each detection block converts only its own samples
+    float toneHz = 0.0f;
+    struct DetectBlock {
+        bool startsDown = false;
+        std::vector<KeyEdge> edges;
+    };
+    std::vector<DetectBlock> blocks;
+
+    std::vector<KeyEdge> edges;
+    std::vector<BatchDecoder::Chunk> chunks;
+    std::vector<std::string> texts;
+
+    std::atomic<size_t> remaining{0};
+    std::atomic<int64_t> cpuNs{0};
+};
+
+struct Batch {
+    BatchOptions options;
+    WorkStealingPool *pool;
+    std::vector<std::unique_ptr<FileJob>> jobs;
+};
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Charges the lifetime of the object to the job's CPU time
+class CpuTimer {
+public:
+    explicit CpuTimer(FileJob& job) : m_job(job), m_start(nowNs()) {}
+    ~CpuTimer() { m_job.cpuNs.fetch_add(nowNs() - m_start, std::memory_order_relaxed); }
+
+private:
+    FileJob& m_job;
+    int64_t m_start;
+};
+
+bool endsWith(const std::string& text, const char *suffix) {
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+bool readFile(const char *path, std::string& contents) {
+    std::FILE *file = std::fopen(path, "rb");
+    if (!file) return false;
+    char buffer[65536];
+    size_t got;
+    contents.clear();
+    while ((got = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, got);
+    }
+    std::fclose(file);
+    return true;
+}
+
+// Rough speed from the marks, so the engine starts near the right unit
+int estimateWpm(const KeyEdge *edges, size_t count) {
+    std::vector<int64_t> marks;
+    for (size_t i = 0; i + 1 < count; ++i) {
+        if (edges[i].down && !edges[i + 1].down) {
+            marks.push_back(edges[i + 1].timeUs - edges[i].timeUs);
+        }
+    }
+    if (marks.size() < 4) return 20;
+    std::sort(marks.begin(), marks.end());
+    // Dits are the marks up to twice the short end of the distribution
+    int64_t shortMark = marks[marks.size() / 10];
+    size_t dits = std::upper_bound(marks.begin(), marks.end(), shortMark * 2) - marks.begin();
+    int64_t unitUs = std::max<int64_t>(marks[dits / 2], 1);
+    return int(std::clamp<int64_t>(1200000 / unitUs, 5, 50));
+}
+
+void finishFile(FileJob& job) {
+    MORSE_TRACE_SCOPE("batch finish");
+    CpuTimer timer(job);
+    std::string transcript;
+    for (size_t i = 0; i < job.texts.size(); ++i) {
+        if (i > 0) {
+            int64_t gap = job.edges[job.chunks[i].first].timeUs - job.edges[job.chunks[i - 1].end - 1].timeUs;
+            transcript += gap >= LINE_BREAK_SILENCE_US ? '\n' : ' ';
+        }
+        transcript += job.texts[i];
+    }
+    transcript += '\n';
+    job.texts.clear();
+
+    job.result.chunks = int(job.chunks.size());
+    for (char c : transcript) {
+        if (!std::isspace(static_cast<unsigned char>(c))) ++job.result.characters;
+    }
+
+    std::FILE *out = std::fopen(job.transcriptPath.c_str(), "wb");
+    if (!out || std::fwrite(transcript.data(), 1, transcript.size(), out) != transcript.size()) {
+        job.result.error = "cannot write " + job.transcriptPath;
+    }
+    if (out) std::fclose(out);
+
+    std::string reference;
+    if (!job.referencePath.empty() && readFile(job.referencePath.c_str(), reference)) {
+        reference = BatchDecoder::normalize(reference);
+        job.result.hasReference = true;
+        job.result.referenceCharacters = reference.size();
+        job.result.errors = BatchDecoder::editDistance(reference, BatchDecoder::normalize(transcript));
+    }
+}
+
+void decodeStage(Batch& batch, FileJob& job) {
+    {
+        CpuTimer timer(job);
+        job.chunks = BatchDecoder::splitAtSilences(job.edges, batch.options.splitSilenceMs * 1000);
+        job.texts.assign(job.chunks.size(), std::string());
+    }
+    if (job.chunks.empty()) {
+        finishFile(job);
+        return;
+    }
+
+    job.remaining.store(job.chunks.size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < job.chunks.size(); ++i) {
+        batch.pool->submit([&job, i]() {
+            {
+                MORSE_TRACE_SCOPE("batch decode chunk");
+                CpuTimer timer(job);
+                const BatchDecoder::Chunk& chunk = job.chunks[i];
+                job.texts[i] = BatchDecoder::decodeChunk(job.edges.data() + chunk.first, chunk.end - chunk.first);
+            }
+            if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                finishFile(job);
+            }
+        });
+    }
+}
+
+// Concatenates the blocks, dropping edges that do not change the key state
+void mergeBlocks(FileJob& job) {
+    bool down = false;
+    for (const FileJob::DetectBlock& block : job.blocks) {
+        for (const KeyEdge& edge : block.edges) {
+            if (edge.down == down) continue;
+            job.edges.push_back(edge);
+            down = edge.down;
+        }
+    }
+    job.blocks.clear();
+}
+
+void detectStage(Batch& batch, FileJob& job) {
+    const int sampleRate = job.wav.sampleRate();
+    const size_t blockSamples = size_t(sampleRate) * DETECT_BLOCK_SECONDS;
+    const size_t blockCount = (job.wav.frames() + blockSamples - 1) / blockSamples;
+    if (blockCount == 0) {
+        job.wav.close();
+        decodeStage(batch, job);
+        return;
+    }
+    job.blocks.resize(blockCount);
+    job.remaining.store(blockCount, std::memory_order_relaxed);
+
+    for (size_t b = 0; b < blockCount; ++b) {
+        batch.pool->submit([&batch, &job, b, blockSamples, sampleRate]() {
+            {
+                MORSE_TRACE_SCOPE("batch detect block");
+                CpuTimer timer(job);
+                size_t start = b * blockSamples;
+                size_t end = std::min(job.wav.frames(), start + blockSamples);
+                size_t warmup = std::min(start, size_t(sampleRate) * DETECT_WARMUP_SECONDS);
+                int64_t originUs = int64_t(start - warmup) * 1000000 / sampleRate;
+                int64_t startUs = int64_t(start) * 1000000 / sampleRate;
+
+                // Only this block and its warm-up are ever converted to floats
+                std::vector<float> samples(warmup + end - start);
+                job.wav.read(start - warmup, samples.size(), samples.data());
+                ToneDetector detector(sampleRate, job.toneHz);
+                std::vector<KeyEdge> edges;
+                detector.process(samples.data(), warmup, edges);
+                FileJob::DetectBlock& block = job.blocks[b];
+                block.startsDown = detector.keyIsDown();
+                edges.clear();
+                detector.process(samples.data() + warmup, end - start, edges);
+                // The state left by the warm-up is restated at the block start;
+                // merging drops it again when the previous block agrees
+                block.edges.reserve(edges.size() + 1);
+                block.edges.push_back({startUs, block.startsDown});
+                for (const KeyEdge& edge : edges) {
+                    block.edges.push_back({edge.timeUs + originUs, edge.down});
+                }
+            }
+            if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                {
+                    CpuTimer timer(job);
+                    mergeBlocks(job);
+                    job.wav.close();
+                }
+                decodeStage(batch, job);
+            }
+        });
+    }
+}
+
+void loadStage(Batch& batch, FileJob& job) {
+    MORSE_TRACE_SCOPE("batch load");
+    bool ok;
+    {
+        CpuTimer timer(job);
+        switch (job.kind) {
+        case Kind::Audio:
+            ok = job.wav.open(job.path.c_str(), &job.result.error);
+            if (ok) {
+                const int sampleRate = job.wav.sampleRate();
+                job.result.recordingSeconds = double(job.wav.frames()) / sampleRate;
+                std::vector<float> head(std::min(job.wav.frames(), size_t(sampleRate) * TONE_ESTIMATE_SECONDS));
+                job.wav.read(0, head.size(), head.data());
+                job.toneHz = ToneDetector::estimateFrequency(head.data(), head.size(), sampleRate);
+            }
+            break;
+        case Kind::KeyTimings:
+            ok = BatchDecoder::loadKeyTimings(job.path.c_str(), job.edges, &job.result.error);
+            break;
+        case Kind::SessionLog:
+        default:
+            ok = BatchDecoder::loadSessionLog(job.path.c_str(), job.edges, &job.result.error);
+            break;
+        }
+        if (ok && job.kind != Kind::Audio && !job.edges.empty()) {
+            job.result.recordingSeconds = (job.edges.back().timeUs - job.edges.front().timeUs) / 1e6;
+        }
+    }
+    if (!ok) return;
+
+    if (job.kind == Kind::Audio) {
+        detectStage(batch, job);
+    } else {
+        decodeStage(batch, job);
+    }
+}
+
+struct DecodeCollector {
+    std::string text;
+};
+
+void collectEvent(const Event& event, void *context) {
+    std::string& text = static_cast<DecodeCollector *>(context)->text;
+    switch (event.type) {
+    case EventType::Character:
+        text += event.character;
+        break;
+    case EventType::DecodingError:
+        text += '*'; // One symbol, so a lost character scores as one error
+        break;
+    case EventType::WordSpace:
+        if (!text.empty() && text.back() != ' ') text += ' ';
+        break;
+    default:
+        break;
+    }
+}
+}
+
+bool BatchDecoder::loadKeyTimings(const char *path, std::vector<KeyEdge>& edges, std::string *error) {
+    std::string contents;
+    if (!readFile(path, contents)) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    edges.clear();
+    size_t lineStart = 0;
+    int lineNumber = 0;
+    while (lineStart < contents.size()) {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = contents.size();
+        std::string line = contents.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        ++lineNumber;
+
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.resize(comment);
+        long long timeUs;
+        int state;
+        char extra;
+        int fields = std::sscanf(line.c_str(), "%lld %d %c", &timeUs, &state, &extra);
+        if (fields <= 0) continue; // Blank or comment
+        if (fields != 2 || (state != 0 && state != 1)
+                || (!edges.empty() && timeUs < edges.back().timeUs)) {
+            if (error) *error = "malformed line " + std::to_string(lineNumber);
+            return false;
+        }
+        edges.push_back({timeUs, state == 1});
+    }
+    return true;
+}
+
+bool BatchDecoder::loadSessionLog(const char *path, std::vector<KeyEdge>& edges, std::string *error) {
+    std::string contents;
+    if (!readFile(path, contents)) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    edges.clear();
+    size_t lineStart = 0;
+    while (lineStart < contents.size()) {
+        size_t lineEnd = contents.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = contents.size();
+        const char *line = contents.c_str() + lineStart;
+        lineStart = lineEnd + 1;
+
+        // Marks are logged at key-up with their length, at millisecond resolution
+        long long epochMs;
+        long long durationMs;
+        if (std::sscanf(line, "%lld\tM\t%lld", &epochMs, &durationMs) != 2) continue;
+        int64_t upUs = epochMs * 1000;
+        int64_t downUs = upUs - durationMs * 1000;
+        if (!edges.empty()) downUs = std::max(downUs, edges.back().timeUs);
+        if (upUs <= downUs) continue;
+        edges.push_back({downUs, true});
+        edges.push_back({upUs, false});
+    }
+    if (edges.empty()) {
+        if (error) *error = "no mark records";
+        return false;
+    }
+    return true;
+}
+
+std::vector<BatchDecoder::Chunk> BatchDecoder::splitAtSilences(const std::vector<KeyEdge>& edges, int64_t silenceUs) {
+    std::vector<Chunk> chunks;
+    size_t first = 0;
+    while (first < edges.size() && !edges[first].down) ++first;
+
+    for (size_t i = first + 1; i < edges.size(); ++i) {
+        if (edges[i].down && !edges[i - 1].down && edges[i].timeUs - edges[i - 1].timeUs >= silenceUs) {
+            chunks.push_back({first, i});
+            first = i;
+        }
+    }
+    if (first < edges.size()) {
+        chunks.push_back({first, edges.size()});
+    }
+    return chunks;
+}
+
+std::string BatchDecoder::decodeChunk(const KeyEdge *edges, size_t count) {
+    DecodeCollector collector;
+    DecoderEngine engine(estimateWpm(edges, count));
+    engine.setCallback(collectEvent, &collector);
+
+    int64_t lastUs = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const KeyEdge& edge = edges[i];
+        if (engine.nextDeadlineUs() <= edge.timeUs) {
+            engine.poll(edge.timeUs);
+        }
+        if (edge.down) {
+            engine.keyDown(edge.timeUs);
+        } else {
+            engine.keyUp(edge.timeUs);
+        }
+        lastUs = edge.timeUs;
+    }
+    engine.flush(lastUs);
+
+    while (!collector.text.empty() && collector.text.back() == ' ') {
+        collector.text.pop_back();
+    }
+    return collector.text;
+}
+
+std::string BatchDecoder::normalize(const std::string& text) {
+    std::string normalized;
+    normalized.reserve(text.size());
+    bool space = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) normalized += ' ';
+        space = false;
+        normalized += char(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return normalized;
+}
+
+size_t BatchDecoder::editDistance(const std::string& reference, const std::string& decoded) {
+    const size_t n = reference.size();
+    if (n == 0) return decoded.size();
+    if (decoded.empty()) return n;
+
+    // Reference positions are bits, 64 per block; each block holds the
+    // vertical deltas of its column slice as positive/negative bit vectors
+    const size_t blocks = (n + 63) / 64;
+    std::vector<uint64_t> equal(256 * blocks, 0);
+    for (size_t i = 0; i < n; ++i) {
+        equal[size_t(static_cast<unsigned char>(reference[i])) * blocks + i / 64] |= uint64_t(1) << (i % 64);
+    }
+    std::vector<uint64_t> positive(blocks, ~uint64_t(0));
+    std::vector<uint64_t> negative(blocks, 0);
+    const uint64_t lastBit = uint64_t(1) << ((n - 1) % 64);
+    const uint64_t highBit = uint64_t(1) << 63;
+    size_t score = n;
+
+    for (char c : decoded) {
+        const uint64_t *eqRow = &equal[size_t(static_cast<unsigned char>(c)) * blocks];
+        int carry = 1; // The top row grows by one per decoded character
+        for (size_t b = 0; b < blocks; ++b) {
+            uint64_t pv = positive[b];
+            uint64_t mv = negative[b];
+            uint64_t eq = eqRow[b] | (carry < 0 ? 1 : 0);
+            uint64_t xv = eqRow[b] | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            if (b + 1 == blocks) {
+                if (ph & lastBit) ++score;
+                else if (mh & lastBit) --score;
+            }
+            int out = (ph & highBit) ? 1 : (mh & highBit) ? -1 : 0;
+
+            ph <<= 1;
+            mh <<= 1;
+            if (carry < 0) mh |= 1;
+            else if (carry > 0) ph |= 1;
+            positive[b] = mh | ~(xv | ph);
+            negative[b] = ph & xv;
+            carry = out;
+        }
+    }
+    return score;
+}
+
+BatchReport BatchDecoder::run(const BatchOptions& options) {
+    BatchReport report;
+    Batch batch;
+    batch.options = options;
+    if (batch.options.outputDirectory.empty()) {
+        batch.options.outputDirectory = options.inputDirectory + "/transcripts";
+    }
+    mkdir(batch.options.outputDirectory.c_str(), 0755);
+
+    std::vector<std::string> names;
+    if (DIR *dir = opendir(options.inputDirectory.c_str())) {
+        while (dirent *entry = readdir(dir)) {
+            names.push_back(entry->d_name);
+        }
+        closedir(dir);
+    }
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        std::unique_ptr<FileJob> job(new FileJob());
+        size_t extension;
+        if (endsWith(name, ".wav") || endsWith(name, ".WAV")) {
+            job->kind = Kind::Audio;
+            extension = 4;
+        } else if (endsWith(name, ".keys")) {
+            job->kind = Kind::KeyTimings;
+            extension = 5;
+        } else if (endsWith(name, ".log")) {
+            job->kind = Kind::SessionLog;
+            extension = 4;
+        } else {
+            continue;
+        }
+        std::string stem = name.substr(0, name.size() - extension);
+        job->path = options.inputDirectory + "/" + name;
+        job->transcriptPath = batch.options.outputDirectory + "/" + stem + ".transcript.txt";
+        std::string reference = options.inputDirectory + "/" + stem + ".txt";
+        if (fileExists(reference)) job->referencePath = reference;
+        job->result.name = name;
+        batch.jobs.push_back(std::move(job));
+    }
+
+    int64_t startNs = nowNs();
+    {
+        WorkStealingPool pool(options.threads);
+        batch.pool = &pool;
+        // Longest first, so a big file does not start last and trail the batch
+        std::vector<std::pair<long long, FileJob *>> bySize;
+        for (std::unique_ptr<FileJob>& job : batch.jobs) {
+            struct stat info;
+            long long size = stat(job->path.c_str(), &info) == 0 ? info.st_size : 0;
+            bySize.push_back({size, job.get()});
+        }
+        std::stable_sort(bySize.begin(), bySize.end(),
+                         [](const auto& a, const auto& b) { return a.first > b.first; });
+        for (const auto& entry : bySize) {
+            FileJob *job = entry.second;
+            pool.submit([&batch, job]() { loadStage(batch, *job); });
+        }
+        pool.wait();
+        report.threads = pool.threadCount();
+        report.steals = pool.steals();
+    }
+    report.wallSeconds = (nowNs() - startNs) / 1e9;
+
+    for (std::unique_ptr<FileJob>& job : batch.jobs) {
+        job->result.cpuSeconds = job->cpuNs.load() / 1e9;
+        report.files.push_back(job->result);
+    }
+    return report;
+}
+
+std::string BatchReport::format() const {
+    std::string text;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-32s %9s %7s %8s %9s %8s\n",
+                  "file", "length s", "chunks", "chars", "accuracy", "cpu s");
+    text += line;
+
+    double recordingSeconds = 0.0;
+    double cpuSeconds = 0.0;
+    size_t characters = 0;
+    size_t referenceCharacters = 0;
+    size_t errors = 0;
+    int scored = 0;
+    int failed = 0;
+    for (const BatchFileResult& file : files) {
+        if (!file.error.empty()) {
+            std::snprintf(line, sizeof(line), "%-32s failed: %s\n", file.name.c_str(), file.error.c_str());
+            text += line;
+            ++failed;
+            continue;
+        }
+        char accuracy[16] = "-";
+        if (file.hasReference && file.referenceCharacters > 0) {
+            double value = 1.0 - double(file.errors) / file.referenceCharacters;
+            std::snprintf(accuracy, sizeof(accuracy), "%.1f%%", 100.0 * std::max(value, 0.0));
+            referenceCharacters += file.referenceCharacters;
+            errors += file.errors;
+            ++scored;
+        }
+        std::snprintf(line, sizeof(line), "%-32s %9.1f %7d %8zu %9s %8.3f\n",
+                      file.name.c_str(), file.recordingSeconds, file.chunks, file.characters,
+                      accuracy, file.cpuSeconds);
+        text += line;
+        recordingSeconds += file.recordingSeconds;
+        cpuSeconds += file.cpuSeconds;
+        characters += file.characters;
+    }
+
+    std::snprintf(line, sizeof(line), "\n%zu files (%d failed), %.2f h of recordings, %zu characters\n",
+                  files.size(), failed, recordingSeconds / 3600.0, characters);
+    text += line;
+    double wall = std::max(wallSeconds, 1e-9);
+    std::snprintf(line, sizeof(line),
+                  "Wall %.2f s on %d threads: %.0fx real time, %.0f characters/s, "
+                  "%.0f%% parallel efficiency, %llu steals\n",
+                  wallSeconds, threads, recordingSeconds / wall, characters / wall,
+                  100.0 * cpuSeconds / (wall * std::max(threads, 1)),
+                  static_cast<unsigned long long>(steals));
+    text += line;
+    if (scored > 0) {
+        double accuracy = referenceCharacters ? 1.0 - double(errors) / referenceCharacters : 0.0;
+        std::snprintf(line, sizeof(line), "Accuracy %.2f%% (%zu errors in %zu reference characters, %d files)\n",
+                      100.0 * std::max(accuracy, 0.0), errors, referenceCharacters, scored);
+        text += line;
+    }
+    return text;
+}
+
+} // namespace morse
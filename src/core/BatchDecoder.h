@@ -0,0 +1,71 @@
+#ifndef MORSE_BATCHDECODER_H
+#define MORSE_BATCHDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ToneDetector.h"
+
+namespace morse {
+
+struct BatchOptions {
+    std::string inputDirectory;
+    std::string outputDirectory;   // Empty: <input>/transcripts
+    int threads = 0;               // 0: one per hardware thread
+    int64_t splitSilenceMs = 3000; // Recordings are cut into chunks at silences this long
+};
+
+struct BatchFileResult {
+    std::string name;
+    std::string error;             // Empty when the file decoded
+    double recordingSeconds = 0.0;
+    int chunks = 0;
+    size_t characters = 0;
+    double cpuSeconds = 0.0;
+    bool hasReference = false;
+    size_t referenceCharacters = 0;
+    size_t errors = 0;             // Edit distance to the reference transcript
+};
+
+struct BatchReport {
+    std::vector<BatchFileResult> files;
+    double wallSeconds = 0.0;
+    int threads = 0;
+    uint64_t steals = 0;
+
+    std::string format() const;
+};
+
+// Decodes a directory of recordings on all cores. Audio (.wav) goes through
+// a ToneDetector, key timing files (.keys) and plain session logs (.log)
+// are read as edges directly. Every recording is cut at long silences into
+// chunks that are decoded independently by their own DecoderEngine in
+// simulated time, so one long file spreads over the whole pool. Transcripts
+// are written as <name>.transcript.txt; when a <name>.txt reference sits
+// next to the recording, the transcript is scored against it.
+class BatchDecoder {
+public:
+    static BatchReport run(const BatchOptions& options);
+
+    // "<microseconds> <1|0>" per line, '#' starts a comment
+    static bool loadKeyTimings(const char *path, std::vector<KeyEdge>& edges, std::string *error = nullptr);
+    // Mark records of an uncompressed session log
+    static bool loadSessionLog(const char *path, std::vector<KeyEdge>& edges, std::string *error = nullptr);
+
+    struct Chunk {
+        size_t first;  // Index of the first key-down
+        size_t end;    // One past the last edge
+    };
+    static std::vector<Chunk> splitAtSilences(const std::vector<KeyEdge>& edges, int64_t silenceUs);
+    static std::string decodeChunk(const KeyEdge *edges, size_t count);
+
+    // Upper case, whitespace runs collapsed to one space
+    static std::string normalize(const std::string& text);
+    // Levenshtein distance, bit-parallel (Myers), O(n * m / 64)
+    static size_t editDistance(const std::string& reference, const std::string& decoded);
+};
+
+} // namespace morse
+
+#endif // MORSE_BATCHDECODER_H
@@ -0,0 +1,384 @@
+#include "DecoderEngine.h"
+#include <algorithm>
+#include <cmath>
+
+namespace morse {
+
+namespace {
+// Units outside 5-60 WPM are not plausible speeds
+constexpr int64_t MIN_UNIT_US = 20000;
+constexpr int64_t MAX_UNIT_US = 240000;
+
+// Hypotheses are scored by the log-distance of a duration to the nearest
+// ideal multiple of their unit (1 or 3 for marks, 1, 3 or 7 for spaces)
+constexpr double SCORE_ALPHA = 0.4;
+constexpr double SEED_ERROR = 0.2;        // ~20% off the nearest ideal length
+constexpr double SWITCH_RATIO = 0.5;      // Candidate must fit twice as well
+constexpr double MIN_SWITCH_SCORE = 0.15; // ...and the current model be poor
+constexpr int MIN_SWITCH_SAMPLES = 3;
+constexpr double CANDIDATE_ALPHA = 0.5;
+
+double markError(int64_t durationUs, int64_t unitUs) {
+    double ratio = double(durationUs) / unitUs;
+    return std::min(std::fabs(std::log(ratio)), std::fabs(std::log(ratio / 3.0)));
+}
+
+double spaceError(int64_t durationUs, int64_t unitUs) {
+    double ratio = double(durationUs) / unitUs;
+    return std::min({std::fabs(std::log(ratio)),
+                     std::fabs(std::log(ratio / 3.0)),
+                     std::fabs(std::log(ratio / 7.0))});
+}
+
+void updateScore(double& score, int samples, double error) {
+    score = samples == 0 ? error : score + SCORE_ALPHA * (error - score);
+}
+
+// Log-distance of a duration from its decision boundary, as a fraction of
+// the distance from the boundary to the ideal length on the chosen side
+float decisionConfidence(int64_t durationUs, int64_t boundaryUs, int64_t idealUs) {
+    if (durationUs <= 0 || boundaryUs <= 0 || idealUs <= 0 || idealUs == boundaryUs) return 1.0f;
+    double margin = std::log(double(durationUs) / boundaryUs) / std::log(double(idealUs) / boundaryUs);
+    return static_cast<float>(std::clamp(margin, 0.0, 1.0));
+}
+}
+
+DecoderEngine::DecoderEngine(int wpm)
+    : m_callback(nullptr)
+    , m_context(nullptr)
+    , m_keyIsDown(false)
+    , m_keyDownAt(0)
+    , m_keyUpAt(-1)
+    , m_characterDeadline(NO_DEADLINE)
+    , m_wordDeadline(NO_DEADLINE)
+    , m_wpm(20)
+    , m_ditAvg(0)
+    , m_dahAvg(0)
+    , m_sampleCount(0)
+    , m_lastReportedUnit(0)
+    , m_activeScore(0.0)
+    , m_segmentStartUs(-1)
+    , m_markDurations{}
+    , m_markConfidence{}
+    , m_gapConfidence(1.0f)
+{
+    setWpm(wpm);
+}
+
+void DecoderEngine::setCallback(Callback callback, void *context) {
+    m_callback = callback;
+    m_context = context;
+}
+
+void DecoderEngine::setWpm(int wpm) {
+    m_wpm = std::clamp(wpm, 5, 50);
+    int64_t unit = nominalUnitUs();
+    m_ditAvg = unit;
+    m_dahAvg = unit * 3;
+    clearCandidates();
+    notifyTiming(0);
+}
+
+int64_t DecoderEngine::nominalUnitUs() const {
+    // PARIS standard: "PARIS" = 50 units
+    // At X WPM, we send X times "PARIS" per minute
+    // So unit time = 60 s / (50 * WPM)
+    return 60000000 / (50 * m_wpm);
+}
+
+int64_t DecoderEngine::unitUs() const {
+    // Blend of the dit average and a third of the dah average
+    return (m_ditAvg + m_dahAvg / 3) / 2;
+}
+
+void DecoderEngine::reset() {
+    m_currentPattern.clear();
+    m_gapConfidence = 1.0f;
+    m_characterDeadline = NO_DEADLINE;
+    m_wordDeadline = NO_DEADLINE;
+    m_keyIsDown = false;
+    m_keyUpAt = -1;
+    m_sampleCount = 0;
+    m_segmentStartUs = -1;
+
+    int64_t unit = nominalUnitUs();
+    m_ditAvg = unit;
+    m_dahAvg = unit * 3;
+    clearCandidates();
+    notifyTiming(0);
+}
+
+void DecoderEngine::keyDown(int64_t timeUs) {
+    if (m_keyIsDown) return;
+
+    // Boundaries that expired before this edge still count
+    poll(timeUs);
+
+    m_keyIsDown = true;
+    m_keyDownAt = timeUs;
+    if (m_segmentStartUs < 0) m_segmentStartUs = timeUs;
+    if (m_keyUpAt >= 0) {
+        Event event = makeEvent(EventType::Space, timeUs);
+        event.durationUs = timeUs - m_keyUpAt;
+        emitEvent(event);
+        // A gap inside a character was judged against the 3 unit boundary
+        if (!m_currentPattern.isEmpty()) {
+            int64_t unit = unitUs();
+            m_gapConfidence = std::min(m_gapConfidence, decisionConfidence(event.durationUs, unit * 3, unit));
+        }
+        trackSpeed(event.durationUs, false, timeUs);
+    }
+    m_characterDeadline = NO_DEADLINE;
+    m_wordDeadline = NO_DEADLINE;
+}
+
+void DecoderEngine::keyUp(int64_t timeUs) {
+    if (!m_keyIsDown) return;
+
+    m_keyIsDown = false;
+    m_keyUpAt = timeUs;
+    processKeyDuration(timeUs - m_keyDownAt, timeUs);
+    notifyTiming(timeUs);
+
+    // Character gap = 3 units, word gap = 7 units
+    scheduleBoundaries(timeUs, unitUs());
+}
+
+void DecoderEngine::element(bool isDit, int64_t timeUs) {
+    // For character mode where device sends elements directly
+    poll(timeUs);
+    appendElement(isDit, timeUs, 1.0f);
+    scheduleBoundaries(timeUs, nominalUnitUs());
+}
+
+void DecoderEngine::abortElement() {
+    if (!m_keyIsDown) return;
+
+    // Drop the interrupted mark but let the partial character finish as usual
+    m_keyIsDown = false;
+    m_keyUpAt = -1;
+    scheduleBoundaries(m_keyDownAt, unitUs());
+}
+
+void DecoderEngine::scheduleBoundaries(int64_t timeUs, int64_t unit) {
+    m_characterDeadline = timeUs + unit * 3;
+    m_wordDeadline = timeUs + unit * 7;
+}
+
+int64_t DecoderEngine::nextDeadlineUs() const {
+    return std::min(m_characterDeadline, m_wordDeadline);
+}
+
+void DecoderEngine::poll(int64_t timeUs) {
+    if (m_characterDeadline != NO_DEADLINE && timeUs >= m_characterDeadline) {
+        int64_t at = m_characterDeadline;
+        m_characterDeadline = NO_DEADLINE;
+        finalizeCharacter(at);
+    }
+
+    if (m_wordDeadline != NO_DEADLINE && timeUs >= m_wordDeadline) {
+        int64_t at = m_wordDeadline;
+        m_wordDeadline = NO_DEADLINE;
+        m_characterDeadline = NO_DEADLINE;
+        finalizeCharacter(at);
+        emitEvent(makeEvent(EventType::WordSpace, at));
+    }
+}
+
+void DecoderEngine::flush(int64_t timeUs) {
+    if (m_keyIsDown) keyUp(timeUs);
+    poll(NO_DEADLINE - 1);
+}
+
+void DecoderEngine::processKeyDuration(int64_t durationUs, int64_t timeUs) {
+    // A speed switch applies to this mark already
+    trackSpeed(durationUs, true, timeUs);
+
+    // Determine if dit or dah based on threshold
+    int64_t threshold = (m_ditAvg + m_dahAvg) / 2;
+    bool isDit = durationUs < threshold;
+    float confidence = markConfidence(durationUs, isDit);
+
+    // Update adaptive timing
+    updateTimingAverages(durationUs, isDit);
+
+    Event mark = makeEvent(EventType::Mark, timeUs);
+    mark.durationUs = durationUs;
+    mark.isDit = isDit;
+    mark.confidence = confidence;
+    emitEvent(mark);
+
+    int index = m_currentPattern.length;
+    appendElement(isDit, timeUs, confidence);
+    if (index < Pattern::MAX_ELEMENTS) {
+        m_markDurations[index] = durationUs;
+    }
+}
+
+float DecoderEngine::markConfidence(int64_t durationUs, bool isDit) const {
+    return decisionConfidence(durationUs, (m_ditAvg + m_dahAvg) / 2, isDit ? m_ditAvg : m_dahAvg);
+}
+
+void DecoderEngine::trackSpeed(int64_t durationUs, bool isMark, int64_t timeUs) {
+    int64_t activeUnit = unitUs();
+    if (activeUnit <= 0 || durationUs <= 0) return;
+
+    // Pauses longer than a word gap carry no speed information
+    if (!isMark && durationUs > activeUnit * 10) return;
+
+    double activeError = isMark ? markError(durationUs, activeUnit) : spaceError(durationUs, activeUnit);
+    updateScore(m_activeScore, 1, activeError);
+
+    SpeedHypothesis *best = nullptr;
+    for (SpeedHypothesis& candidate : m_candidates) {
+        if (candidate.samples == 0) continue;
+
+        double ratio = double(durationUs) / candidate.unitUs;
+        double error = isMark ? markError(durationUs, candidate.unitUs) : spaceError(durationUs, candidate.unitUs);
+        updateScore(candidate.score, candidate.samples, error);
+        ++candidate.samples;
+
+        // Marks refine the candidate's unit, as a dit or a dah
+        if (isMark) {
+            bool asDit = std::fabs(std::log(ratio)) < std::fabs(std::log(ratio / 3.0));
+            int64_t target = asDit ? durationUs : durationUs / 3;
+            candidate.unitUs += static_cast<int64_t>(CANDIDATE_ALPHA * (target - candidate.unitUs));
+        }
+
+        if (!best || candidate.score < best->score) best = &candidate;
+    }
+
+    if (best && best->samples >= MIN_SWITCH_SAMPLES
+        && m_activeScore > MIN_SWITCH_SCORE
+        && best->score < m_activeScore * SWITCH_RATIO) {
+        switchTo(*best, timeUs);
+        return;
+    }
+
+    // A mark the current model cannot explain may be a new speed: try both
+    // readings of it
+    if (isMark && activeError > SEED_ERROR) {
+        seedCandidate(durationUs);
+        seedCandidate(durationUs / 3);
+    }
+}
+
+void DecoderEngine::seedCandidate(int64_t unitUs) {
+    if (unitUs < MIN_UNIT_US || unitUs > MAX_UNIT_US) return;
+
+    // Reuse a candidate already near this speed, else replace the worst
+    SpeedHypothesis *slot = nullptr;
+    for (SpeedHypothesis& candidate : m_candidates) {
+        if (candidate.samples > 0 && std::llabs(candidate.unitUs - unitUs) * 5 < unitUs) return;
+        if (!slot || candidate.samples == 0
+            || (slot->samples > 0 && candidate.score > slot->score)) {
+            slot = &candidate;
+        }
+    }
+
+    slot->unitUs = unitUs;
+    slot->score = 0.0; // Fits the seeding mark exactly
+    slot->samples = 1;
+}
+
+void DecoderEngine::switchTo(SpeedHypothesis& candidate, int64_t timeUs) {
+    int64_t unit = candidate.unitUs;
+    m_ditAvg = unit;
+    m_dahAvg = unit * 3;
+    m_sampleCount = 0; // Fast adaptation while the new speed settles
+    m_activeScore = candidate.score;
+    clearCandidates();
+
+    // Re-read the character in progress at the new speed
+    int stored = m_currentPattern.storedLength();
+    int64_t threshold = (m_ditAvg + m_dahAvg) / 2;
+    Pattern corrected;
+    for (int i = 0; i < stored; ++i) {
+        bool isDah = m_markDurations[i] >= 0 ? m_markDurations[i] >= threshold : m_currentPattern.isDah(i);
+        corrected.append(isDah);
+        if (m_markDurations[i] >= 0) {
+            m_markConfidence[i] = markConfidence(m_markDurations[i], !isDah);
+        }
+    }
+    corrected.length = m_currentPattern.length;
+    m_currentPattern = corrected;
+
+    Event event = makeEvent(EventType::SpeedChange, timeUs);
+    event.unitUs = unit;
+    event.durationUs = timeUs - m_segmentStartUs;
+    emitEvent(event);
+    m_segmentStartUs = timeUs;
+
+    notifyTiming(timeUs);
+}
+
+void DecoderEngine::clearCandidates() {
+    for (SpeedHypothesis& candidate : m_candidates) {
+        candidate = SpeedHypothesis();
+    }
+    m_activeScore = 0.0;
+}
+
+void DecoderEngine::appendElement(bool isDit, int64_t timeUs, float confidence) {
+    if (m_currentPattern.length < Pattern::MAX_ELEMENTS) {
+        m_markDurations[m_currentPattern.length] = -1; // Set by the caller for keyed marks
+        m_markConfidence[m_currentPattern.length] = confidence;
+    }
+    m_currentPattern.append(!isDit);
+
+    Event event = makeEvent(EventType::Element, timeUs);
+    event.isDit = isDit;
+    event.confidence = confidence;
+    emitEvent(event);
+}
+
+void DecoderEngine::updateTimingAverages(int64_t durationUs, bool isDit) {
+    // Exponential moving average for adaptive timing
+    const double alpha = (m_sampleCount < 10) ? 0.5 : 0.2;
+
+    if (isDit) {
+        m_ditAvg = static_cast<int64_t>(alpha * durationUs + (1 - alpha) * m_ditAvg);
+    } else {
+        m_dahAvg = static_cast<int64_t>(alpha * durationUs + (1 - alpha) * m_dahAvg);
+    }
+
+    m_sampleCount++;
+}
+
+void DecoderEngine::finalizeCharacter(int64_t timeUs) {
+    if (m_currentPattern.isEmpty()) return;
+
+    char decoded = MorseCode::decode(m_currentPattern);
+    Event event = makeEvent(decoded ? EventType::Character : EventType::DecodingError, timeUs);
+    event.character = decoded;
+    event.pattern = m_currentPattern;
+    event.confidence = m_gapConfidence;
+    for (int i = 0; i < m_currentPattern.storedLength(); ++i) {
+        event.confidence = std::min(event.confidence, m_markConfidence[i]);
+    }
+    emitEvent(event);
+
+    m_currentPattern.clear();
+    m_gapConfidence = 1.0f;
+}
+
+void DecoderEngine::notifyTiming(int64_t timeUs) {
+    int64_t unit = unitUs();
+    if (unit != m_lastReportedUnit) {
+        m_lastReportedUnit = unit;
+        Event event = makeEvent(EventType::Timing, timeUs);
+        event.unitUs = unit;
+        emitEvent(event);
+    }
+}
+
+Event DecoderEngine::makeEvent(EventType type, int64_t timeUs) const {
+    Event event{};
+    event.type = type;
+    event.confidence = 1.0f;
+    event.timestampUs = timeUs;
+    event.unitUs = m_lastReportedUnit;
+    return event;
+}
+
+} // namespace morse
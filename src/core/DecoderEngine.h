@@ -0,0 +1,125 @@
+#ifndef MORSE_DECODERENGINE_H
+#define MORSE_DECODERENGINE_H
+
+#include <cstdint>
+#include "MorseCode.h"
+
+namespace morse {
+
+enum class EventType : uint8_t {
+    Element,        // isDit, confidence
+    Character,      // character, pattern, confidence
+    WordSpace,
+    DecodingError,  // pattern, confidence
+    Mark,           // durationUs, isDit, confidence
+    Space,          // durationUs
+    Timing,         // unitUs changed
+    SpeedChange,    // Re-locked to a new speed: unitUs, durationUs of the previous segment
+};
+
+struct Event {
+    EventType type;
+    bool isDit;
+    char character;
+    Pattern pattern;
+    // How clearly the durations fell on one side of their decision
+    // boundaries: 0 right on a boundary, 1 at or past the ideal length. A
+    // character takes the weakest of its marks and inner gaps.
+    float confidence;
+    int64_t timestampUs;
+    int64_t durationUs;
+    int64_t unitUs;
+};
+
+// Adaptive Morse decoder without Qt, timers or allocation. Callers feed
+// key edges with timestamps and call poll() at or after nextDeadlineUs()
+// so character and word boundaries are detected; with recorded timestamps
+// the engine decodes in simulated time. Events are delivered synchronously
+// to a plain function callback.
+//
+// Besides the slow moving averages, a few competing speed hypotheses are
+// scored on every mark and space. When one of them explains the recent
+// elements much better than the current model (a different operator took
+// over), the engine switches to it within a handful of elements and
+// re-classifies the character in progress.
+class DecoderEngine {
+public:
+    using Callback = void (*)(const Event& event, void *context);
+
+    explicit DecoderEngine(int wpm = 20);
+
+    void setCallback(Callback callback, void *context);
+
+    void setWpm(int wpm);
+    int wpm() const { return m_wpm; }
+    void reset();
+
+    void keyDown(int64_t timeUs);
+    void keyUp(int64_t timeUs);
+    void element(bool isDit, int64_t timeUs); // Character mode
+    void abortElement();                      // Key state lost mid-mark
+
+    void poll(int64_t timeUs);
+    int64_t nextDeadlineUs() const;           // NO_DEADLINE when idle
+    void flush(int64_t timeUs);               // End of input: finish any character
+
+    int64_t unitUs() const;
+    bool keyIsDown() const { return m_keyIsDown; }
+
+    static constexpr int64_t NO_DEADLINE = INT64_MAX;
+
+private:
+    struct SpeedHypothesis {
+        int64_t unitUs = 0;
+        double score = 0.0;   // Moving average of the fit error, lower is better
+        int samples = 0;
+    };
+
+    static constexpr int CANDIDATE_COUNT = 3;
+
+    int64_t nominalUnitUs() const;
+    void trackSpeed(int64_t durationUs, bool isMark, int64_t timeUs);
+    void seedCandidate(int64_t unitUs);
+    void switchTo(SpeedHypothesis& candidate, int64_t timeUs);
+    void clearCandidates();
+    void processKeyDuration(int64_t durationUs, int64_t timeUs);
+    float markConfidence(int64_t durationUs, bool isDit) const;
+    void updateTimingAverages(int64_t durationUs, bool isDit);
+    void appendElement(bool isDit, int64_t timeUs, float confidence);
+    void finalizeCharacter(int64_t timeUs);
+    void notifyTiming(int64_t timeUs);
+    void scheduleBoundaries(int64_t timeUs, int64_t unit);
+    void emitEvent(const Event& event) { if (m_callback) m_callback(event, m_context); }
+    Event makeEvent(EventType type, int64_t timeUs) const;
+
+    Callback m_callback;
+    void *m_context;
+
+    Pattern m_currentPattern;
+    bool m_keyIsDown;
+    int64_t m_keyDownAt;
+    int64_t m_keyUpAt;       // -1 until the first key-up
+    int64_t m_characterDeadline;
+    int64_t m_wordDeadline;
+    int m_wpm;
+
+    // Adaptive timing
+    int64_t m_ditAvg;
+    int64_t m_dahAvg;
+    int m_sampleCount;
+    int64_t m_lastReportedUnit;
+
+    // Speed change tracking
+    SpeedHypothesis m_candidates[CANDIDATE_COUNT];
+    double m_activeScore;
+    int64_t m_segmentStartUs; // -1 until the first key-down
+    int64_t m_markDurations[Pattern::MAX_ELEMENTS]; // Marks of the current character
+
+    // Confidence of the current character's marks and weakest inner gap
+    float m_markConfidence[Pattern::MAX_ELEMENTS];
+    float m_gapConfidence;
+};
+
+} // namespace morse
+
+#endif // MORSE_DECODERENGINE_H
@@ -0,0 +1,433 @@
+#include "ExchangeRecognizer.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+namespace morse {
+
+namespace {
+enum CharClass { LETTER, DIGIT, SLASH, OTHER };
+
+// Callsign grammar: alternatives of segments, each a character class set
+// repeated min..max times. Base form: up to two prefix characters, a
+// letter, one or two digits and a one to four letter suffix (K1ABC, 9A1AA,
+// 3DA0XX, VK4IOG), optionally with a foreign prefix (DL/K1ABC), a portable
+// suffix (/P, /M, /QRP, /3) or both (DL/K1ABC/P).
+struct Segment {
+    uint8_t classes;
+    int min;
+    int max;
+};
+
+constexpr uint8_t L = 1 << LETTER;
+constexpr uint8_t D = 1 << DIGIT;
+constexpr uint8_t S = 1 << SLASH;
+
+const std::vector<std::vector<Segment>>& callsignGrammar() {
+    static const std::vector<std::vector<Segment>> grammar = {
+        {{L | D, 0, 2}, {L, 1, 1}, {D, 1, 2}, {L, 1, 4}},
+        {{L | D, 0, 2}, {L, 1, 1}, {D, 1, 2}, {L, 1, 4}, {S, 1, 1}, {L | D, 1, 4}},
+        {{L | D, 1, 4}, {S, 1, 1}, {L | D, 0, 2}, {L, 1, 1}, {D, 1, 2}, {L, 1, 4}},
+        {{L | D, 1, 4}, {S, 1, 1}, {L | D, 0, 2}, {L, 1, 1}, {D, 1, 2}, {L, 1, 4}, {S, 1, 1}, {L | D, 1, 4}},
+    };
+    return grammar;
+}
+
+int classOf(char c) {
+    if (c >= 'A' && c <= 'Z') return LETTER;
+    if (c >= '0' && c <= '9') return DIGIT;
+    return c == '/' ? SLASH : OTHER;
+}
+
+// Cut numbers as sent in contests: 5NN = 599, 1TT = 100
+int digitOf(char c) {
+    switch (c) {
+    case 'T': case 'O': return 0;
+    case 'A': return 1;
+    case 'E': return 5;
+    case 'N': return 9;
+    default: return c >= '0' && c <= '9' ? c - '0' : -1;
+    }
+}
+
+bool isRstShaped(int32_t value, int length) {
+    if (length == 2) return value / 10 >= 1 && value / 10 <= 5 && value % 10 >= 1;
+    if (length == 3) return value / 100 >= 1 && value / 100 <= 5 && value / 10 % 10 >= 1 && value % 10 >= 1;
+    return false;
+}
+
+std::string normalizePattern(const std::string& text) {
+    std::string normalized;
+    bool space = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            space = !normalized.empty();
+            continue;
+        }
+        if (space) normalized += ' ';
+        space = false;
+        normalized += char(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return normalized;
+}
+
+void copyWord(char *out, const char *text) {
+    size_t length = std::min(std::strlen(text), size_t(MAX_WORD));
+    std::memcpy(out, text, length);
+    out[length] = '\0';
+}
+}
+
+ExchangeRecognizer::ExchangeRecognizer()
+    : m_callback(nullptr)
+    , m_context(nullptr)
+    , m_numberFormat(ExchangeNumber::Serial)
+{
+    compile();
+}
+
+void ExchangeRecognizer::setCallback(Callback callback, void *context) {
+    m_callback = callback;
+    m_context = context;
+}
+
+int ExchangeRecognizer::addPattern(const std::string& text, PatternKind kind) {
+    std::string normalized = normalizePattern(text);
+    if (normalized.empty()) return -1;
+
+    auto existing = m_patternIds.find(normalized);
+    if (existing != m_patternIds.end()) {
+        // A delimiter stays a delimiter when a keyword list repeats it
+        if (kind == PatternKind::Delimiter) m_patterns[size_t(existing->second)].kind = kind;
+        return existing->second;
+    }
+
+    int id = static_cast<int>(m_patterns.size());
+    int words = 1 + static_cast<int>(std::count(normalized.begin(), normalized.end(), ' '));
+    m_patterns.push_back({normalized, kind, words});
+    m_patternIds.emplace(std::move(normalized), id);
+    return id;
+}
+
+void ExchangeRecognizer::addDefaultPatterns() {
+    for (const char *keyword : {"CQ", "TEST", "CQ TEST", "DE", "QRZ", "AGN", "NR", "TU QRZ"}) {
+        addPattern(keyword, PatternKind::Keyword);
+    }
+    // Prosigns decode as + (AR), = (BT) and ( (KN)
+    for (const char *delimiter : {"K", "KN", "BK", "TU", "SK", "AR", "73", "+", "=", "("}) {
+        addPattern(delimiter, PatternKind::Delimiter);
+    }
+}
+
+void ExchangeRecognizer::clearPatterns() {
+    m_patterns.clear();
+    m_patternIds.clear();
+}
+
+bool ExchangeRecognizer::loadPatterns(const char *path, PatternKind kind, std::string *error) {
+    std::ifstream file(path);
+    if (!file) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        addPattern(line, kind);
+    }
+    return true;
+}
+
+void ExchangeRecognizer::compile() {
+    compileAutomaton();
+    compileCallsignDfa();
+    reset();
+}
+
+int ExchangeRecognizer::symbolOf(char c) {
+    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+    if (c >= 'A' && c <= 'Z') return 1 + (c - 'A');
+    if (c >= '0' && c <= '9') return 27 + (c - '0');
+    switch (c) {
+    case ' ': return SYMBOL_SPACE;
+    case '/': return 37;
+    case '?': return 38;
+    case '+': return 39;
+    case '=': return 40;
+    case '(': return 41;
+    default: return 42;
+    }
+}
+
+void ExchangeRecognizer::compileAutomaton() {
+    // Trie of " pattern ", so every match lines up with word boundaries
+    m_next.assign(SYMBOLS, -1);
+    m_outputs.assign(1, -1);
+    for (size_t id = 0; id < m_patterns.size(); ++id) {
+        const std::string padded = ' ' + m_patterns[id].text + ' ';
+        int32_t state = 0;
+        for (char c : padded) {
+            size_t slot = size_t(state) * SYMBOLS + size_t(symbolOf(c));
+            if (m_next[slot] < 0) {
+                m_next[slot] = static_cast<int32_t>(m_outputs.size());
+                m_next.resize(m_next.size() + SYMBOLS, -1);
+                m_outputs.push_back(-1);
+            }
+            state = m_next[slot];
+        }
+        m_outputs[size_t(state)] = static_cast<int32_t>(id);
+    }
+
+    // Breadth-first: failure links fill in the missing transitions, so the
+    // stream never walks back up the trie
+    const size_t states = m_outputs.size();
+    std::vector<int32_t> fail(states, 0);
+    m_outputLink.assign(states, 0);
+    std::vector<int32_t> queue;
+    queue.reserve(states);
+    for (int symbol = 0; symbol < SYMBOLS; ++symbol) {
+        int32_t& child = m_next[size_t(symbol)];
+        if (child < 0) {
+            child = 0;
+        } else {
+            queue.push_back(child);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const int32_t state = queue[head];
+        for (int symbol = 0; symbol < SYMBOLS; ++symbol) {
+            int32_t& child = m_next[size_t(state) * SYMBOLS + size_t(symbol)];
+            const int32_t fallback = m_next[size_t(fail[size_t(state)]) * SYMBOLS + size_t(symbol)];
+            if (child < 0) {
+                child = fallback;
+                continue;
+            }
+            fail[size_t(child)] = fallback;
+            m_outputLink[size_t(child)] = m_outputs[size_t(fallback)] >= 0 ? fallback : m_outputLink[size_t(fallback)];
+            queue.push_back(child);
+        }
+    }
+}
+
+void ExchangeRecognizer::compileCallsignDfa() {
+    // Subset construction over NFA positions (alternative, segment, count)
+    const auto& grammar = callsignGrammar();
+    using Position = std::array<int, 3>;
+    using Set = std::vector<Position>;
+
+    auto close = [&](Set set, bool *accepting) {
+        *accepting = false;
+        for (size_t i = 0; i < set.size(); ++i) {
+            const Position p = set[i];
+            const auto& segments = grammar[size_t(p[0])];
+            if (p[1] == int(segments.size())) {
+                *accepting = true;
+                continue;
+            }
+            if (p[2] >= segments[size_t(p[1])].min) {
+                Position next{p[0], p[1] + 1, 0};
+                if (std::find(set.begin(), set.end(), next) == set.end()) set.push_back(next);
+            }
+        }
+        std::sort(set.begin(), set.end());
+        return set;
+    };
+
+    std::map<Set, int> ids;
+    std::vector<Set> sets;
+    std::vector<uint8_t> accept;
+    auto intern = [&](Set set) {
+        bool accepting = false;
+        set = close(std::move(set), &accepting);
+        auto found = ids.find(set);
+        if (found != ids.end()) return found->second;
+        int id = static_cast<int>(sets.size());
+        ids.emplace(set, id);
+        sets.push_back(set);
+        accept.push_back(accepting ? 1 : 0);
+        return id;
+    };
+
+    intern(Set());   // 0: dead
+    Set start;
+    for (size_t a = 0; a < grammar.size(); ++a) start.push_back({int(a), 0, 0});
+    intern(start);   // 1: start
+
+    m_callsignNext.clear();
+    for (size_t state = 0; state < sets.size(); ++state) {
+        for (int cls = 0; cls < CLASSES; ++cls) {
+            Set moved;
+            for (const Position& p : sets[state]) {
+                const auto& segments = grammar[size_t(p[0])];
+                if (p[1] == int(segments.size())) continue;
+                const Segment& segment = segments[size_t(p[1])];
+                if (p[2] < segment.max && (segment.classes & (1 << cls))) {
+                    moved.push_back({p[0], p[1], p[2] + 1});
+                }
+            }
+            m_callsignNext.push_back(static_cast<uint8_t>(moved.empty() ? 0 : intern(moved)));
+        }
+    }
+    m_callsignAccept = accept;
+}
+
+bool ExchangeRecognizer::isCallsign(const char *word) const {
+    uint8_t state = 1;
+    for (const char *c = word; *c; ++c) {
+        char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(*c)));
+        state = m_callsignNext[size_t(state) * CLASSES + size_t(classOf(upper))];
+    }
+    return m_callsignAccept[state] != 0;
+}
+
+void ExchangeRecognizer::reset() {
+    m_state = 0;
+    m_position = 0;
+    step(SYMBOL_SPACE); // The stream starts on a word boundary
+    m_wordLength = 0;
+    m_wordStart = 0;
+    m_wordTooLong = false;
+    m_numeric = true;
+    m_hasDigit = false;
+    m_number = 0;
+    m_callsignState = 1;
+    m_lastWasSpace = true;
+    clearExchange();
+}
+
+void ExchangeRecognizer::step(int symbol) {
+    m_state = m_next[size_t(m_state) * SYMBOLS + size_t(symbol)];
+}
+
+void ExchangeRecognizer::addCharacter(char character) {
+    if (character == ' ') {
+        addWordSpace();
+        return;
+    }
+    char c = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+    step(symbolOf(c));
+    ++m_position;
+    m_lastWasSpace = false;
+
+    if (m_wordLength == 0) m_wordStart = m_position - 1;
+    if (m_wordLength < MAX_WORD) {
+        m_word[m_wordLength++] = c;
+    } else {
+        m_wordTooLong = true;
+    }
+    m_callsignState = m_callsignNext[size_t(m_callsignState) * CLASSES + size_t(classOf(c))];
+
+    int digit = digitOf(c);
+    if (digit < 0) {
+        m_numeric = false;
+    } else if (m_numeric) {
+        m_hasDigit = m_hasDigit || (c >= '0' && c <= '9');
+        m_number = m_number < 1000000 ? m_number * 10 + digit : m_number;
+    }
+}
+
+void ExchangeRecognizer::addWordSpace() {
+    if (m_lastWasSpace) return;
+    step(SYMBOL_SPACE);
+    ++m_position;
+    m_lastWasSpace = true;
+    endWord();
+
+    m_wordLength = 0;
+    m_wordTooLong = false;
+    m_numeric = true;
+    m_hasDigit = false;
+    m_number = 0;
+    m_callsignState = 1;
+}
+
+void ExchangeRecognizer::endWord() {
+    m_word[m_wordLength] = '\0';
+
+    // Patterns ending here, longest first along the dictionary chain; a
+    // one-word pattern can only have matched this exact word
+    bool known = false;
+    int delimiter = -1;
+    int32_t first = m_outputs[size_t(m_state)] >= 0 ? m_state : m_outputLink[size_t(m_state)];
+    for (int32_t s = first; s > 0; s = m_outputLink[size_t(s)]) {
+        const PatternEntry& pattern = m_patterns[size_t(m_outputs[size_t(s)])];
+        if (pattern.words == 1) known = true;
+        if (pattern.kind == PatternKind::Delimiter && delimiter < 0) delimiter = m_outputs[size_t(s)];
+    }
+
+    const bool fits = !m_wordTooLong && m_wordLength > 0;
+    const bool callsign = fits && delimiter < 0 && m_callsignAccept[m_callsignState];
+    if (callsign) {
+        emitField(ExchangeFieldType::Callsign, 0, known, m_word);
+        copyWord(m_exchange.callsign, m_word);
+        m_exchange.known = known;
+    } else if (fits && delimiter < 0 && m_numeric && m_hasDigit && m_wordLength <= 6) {
+        if (m_exchange.rst < 0 && isRstShaped(m_number, m_wordLength)) {
+            emitField(ExchangeFieldType::Rst, m_number, false, m_word);
+            m_exchange.rst = m_number;
+        } else {
+            int maxZone = m_numberFormat == ExchangeNumber::CqZone ? 40
+                        : m_numberFormat == ExchangeNumber::ItuZone ? 90 : 0;
+            if (m_number >= 1 && m_number <= maxZone) {
+                emitField(ExchangeFieldType::Zone, m_number, false, m_word);
+                m_exchange.zone = m_number;
+            } else {
+                emitField(ExchangeFieldType::Serial, m_number, false, m_word);
+                m_exchange.serial = m_number;
+            }
+        }
+    }
+    if ((callsign || m_exchange.rst >= 0 || m_exchange.serial >= 0 || m_exchange.zone >= 0) && m_exchangeEmpty) {
+        m_exchange.startPosition = m_wordStart;
+        m_exchangeEmpty = false;
+    }
+
+    for (int32_t s = first; s > 0; s = m_outputLink[size_t(s)]) {
+        const int32_t id = m_outputs[size_t(s)];
+        const PatternEntry& pattern = m_patterns[size_t(id)];
+        if (callsign && pattern.words == 1) continue; // Reported as a known callsign
+        emitField(ExchangeFieldType::Keyword, id, false, pattern.text.c_str());
+    }
+
+    if (delimiter >= 0) closeExchange(delimiter);
+}
+
+void ExchangeRecognizer::emitField(ExchangeFieldType type, int32_t value, bool known, const char *text) {
+    if (!m_callback) return;
+    ExchangeEvent event{};
+    event.kind = ExchangeEvent::Kind::Field;
+    event.field.type = type;
+    event.field.value = value;
+    event.field.known = known;
+    copyWord(event.field.text, text);
+    event.position = m_position;
+    m_callback(event, m_context);
+}
+
+void ExchangeRecognizer::closeExchange(int delimiter) {
+    if (!m_exchangeEmpty && m_callback) {
+        ExchangeEvent event{};
+        event.kind = ExchangeEvent::Kind::Exchange;
+        event.exchange = m_exchange;
+        event.exchange.delimiter = delimiter;
+        event.exchange.endPosition = m_position;
+        event.position = m_position;
+        m_callback(event, m_context);
+    }
+    clearExchange();
+}
+
+void ExchangeRecognizer::clearExchange() {
+    m_exchange = ExchangeRecord{};
+    m_exchange.rst = -1;
+    m_exchange.serial = -1;
+    m_exchange.zone = -1;
+    m_exchange.delimiter = -1;
+    m_exchangeEmpty = true;
+}
+
+} // namespace morse
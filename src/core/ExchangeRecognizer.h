@@ -0,0 +1,156 @@
+#ifndef MORSE_EXCHANGERECOGNIZER_H
+#define MORSE_EXCHANGERECOGNIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace morse {
+
+enum class ExchangeFieldType : uint8_t {
+    Callsign,
+    Rst,      // value: e.g. 599; cut numbers (5NN) are expanded
+    Serial,   // value: the number
+    Zone,     // value: the zone
+    Keyword,  // value: pattern id
+};
+
+// Numbers after the RST, depending on the contest
+enum class ExchangeNumber : uint8_t {
+    Serial,
+    CqZone,   // 1-40, otherwise read as a serial
+    ItuZone,  // 1-90, otherwise read as a serial
+};
+
+enum class PatternKind : uint8_t {
+    Keyword,
+    Delimiter, // Closes the current exchange (K, TU, AR, ...)
+};
+
+constexpr int MAX_WORD = 15; // Longer words are never callsigns or numbers
+
+struct ExchangeField {
+    ExchangeFieldType type;
+    int32_t value;
+    bool known;               // Callsign that is also a configured pattern
+    char text[MAX_WORD + 1];  // The word, or the pattern for a keyword
+};
+
+struct ExchangeRecord {
+    char callsign[MAX_WORD + 1]; // Last callsign heard, empty if none
+    bool known;
+    int32_t rst;                 // -1 when absent
+    int32_t serial;
+    int32_t zone;
+    int32_t delimiter;           // Pattern id that closed the exchange
+    uint64_t startPosition;      // Character positions in the stream
+    uint64_t endPosition;
+};
+
+struct ExchangeEvent {
+    enum class Kind : uint8_t { Field, Exchange } kind;
+    ExchangeField field;         // Kind::Field
+    ExchangeRecord exchange;     // Kind::Exchange
+    uint64_t position;           // Characters consumed so far
+};
+
+// Streaming extraction of contest exchanges from decoded text. All
+// configured literal patterns (keywords, prosigns, callsign lists with
+// thousands of entries) are compiled into one Aho-Corasick automaton with
+// full transitions, and callsigns are recognized by a DFA compiled from a
+// small grammar, so each character costs two table lookups no matter how
+// many patterns there are. Words are classified as they end: callsign,
+// RST (cut numbers allowed), serial number or zone. Fields accumulate
+// into an exchange record that a delimiter pattern closes and reports.
+class ExchangeRecognizer {
+public:
+    using Callback = void (*)(const ExchangeEvent& event, void *context);
+
+    ExchangeRecognizer();
+
+    void setCallback(Callback callback, void *context);
+    void setNumberFormat(ExchangeNumber format) { m_numberFormat = format; }
+    ExchangeNumber numberFormat() const { return m_numberFormat; }
+
+    // Patterns match whole words; inner whitespace matches one word space.
+    // Returns the pattern id, or -1 for an empty pattern. Takes effect on
+    // the next compile().
+    int addPattern(const std::string& text, PatternKind kind);
+    void addDefaultPatterns(); // Contest keywords and exchange delimiters
+    void clearPatterns();
+    // One pattern per line, '#' starts a comment; false if unreadable
+    bool loadPatterns(const char *path, PatternKind kind, std::string *error = nullptr);
+    void compile();            // Also resets the stream
+
+    size_t patternCount() const { return m_patterns.size(); }
+    const std::string& patternText(int id) const { return m_patterns[size_t(id)].text; }
+    PatternKind patternKind(int id) const { return m_patterns[size_t(id)].kind; }
+    size_t automatonStates() const { return m_outputs.size(); }
+
+    void addCharacter(char character);
+    void addWordSpace();
+    void reset();
+
+    // Runs a whole word through the callsign DFA
+    bool isCallsign(const char *word) const;
+
+private:
+    struct PatternEntry {
+        std::string text;
+        PatternKind kind;
+        int words;
+    };
+
+    static constexpr int SYMBOL_SPACE = 0;
+    static constexpr int SYMBOLS = 43;   // Space, A-Z, 0-9, / ? + = ( and other
+
+    static constexpr int CLASSES = 4;    // Letter, digit, '/', other
+
+    static int symbolOf(char character);
+    void compileAutomaton();
+    void compileCallsignDfa();
+    void step(int symbol);
+    void endWord();
+    void emitField(ExchangeFieldType type, int32_t value, bool known, const char *text);
+    void closeExchange(int delimiter);
+    void clearExchange();
+
+    Callback m_callback;
+    void *m_context;
+    ExchangeNumber m_numberFormat;
+    std::vector<PatternEntry> m_patterns;
+    std::unordered_map<std::string, int> m_patternIds;
+
+    // Aho-Corasick with full transitions. Patterns are distinct, so a
+    // state ends at most one; dictionary links chain the shorter patterns
+    // that end at the same place.
+    std::vector<int32_t> m_next;       // state * SYMBOLS + symbol
+    std::vector<int32_t> m_outputs;    // Pattern id ending at a state, -1 if none
+    std::vector<int32_t> m_outputLink; // Next state on the dictionary chain, 0 ends it
+
+    // Callsign DFA over character classes; state 0 rejects
+    std::vector<uint8_t> m_callsignNext; // state * CLASSES + class
+    std::vector<uint8_t> m_callsignAccept;
+
+    // Stream state
+    int32_t m_state;
+    uint64_t m_wordStart;
+    uint8_t m_callsignState;
+    char m_word[MAX_WORD + 1];
+    int m_wordLength;
+    bool m_wordTooLong;
+    bool m_numeric;        // Only digits and cut-number letters so far
+    bool m_hasDigit;
+    int32_t m_number;
+    uint64_t m_position;
+    bool m_lastWasSpace;
+
+    ExchangeRecord m_exchange;
+    bool m_exchangeEmpty;
+};
+
+} // namespace morse
+
+#endif // MORSE_EXCHANGERECOGNIZER_H
@@ -0,0 +1,532 @@
+#include "HistoryStore.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace morse {
+
+namespace {
+constexpr char SEGMENT_MAGIC[4] = {'M', 'K', 'H', 'S'};
+constexpr char INDEX_MAGIC[4] = {'M', 'K', 'H', 'I'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr int64_t CHECKPOINT_INTERVAL_MS = 1000;
+constexpr size_t CONTEXT_CHARS = 40;
+
+struct SegmentHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t textBytes;       // Published after the text is written
+    uint32_t checkpointCount;
+    int64_t createdMs;
+    uint32_t sealed;
+    uint32_t reserved[9];
+};
+static_assert(sizeof(SegmentHeader) == 64, "Segment header is 64 bytes");
+
+struct Checkpoint {
+    uint32_t offset;
+    uint32_t reserved;
+    int64_t epochMs;
+};
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t termCount;
+    uint32_t postingCount;
+};
+
+struct IndexTerm {
+    uint32_t trigram;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Header page, checkpoint table, text
+constexpr size_t CHECKPOINTS_OFFSET = 4096;
+constexpr size_t TEXT_OFFSET = CHECKPOINTS_OFFSET + HistoryStore::CHECKPOINT_CAPACITY * sizeof(Checkpoint);
+constexpr size_t SEGMENT_FILE_SIZE = TEXT_OFFSET + HistoryStore::TEXT_CAPACITY;
+
+uint32_t trigramAt(const char *text) {
+    return (uint32_t(uint8_t(text[0])) << 16) | (uint32_t(uint8_t(text[1])) << 8) | uint8_t(text[2]);
+}
+
+std::string normalizeQuery(const std::string& query) {
+    std::string normalized;
+    for (char c : query) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            if (!normalized.empty() && normalized.back() != ' ') normalized += ' ';
+        } else {
+            normalized += char(std::toupper(static_cast<unsigned char>(c)));
+        }
+    }
+    while (!normalized.empty() && normalized.back() == ' ') normalized.pop_back();
+    return normalized;
+}
+
+void appendContext(std::string& context, const char *text, size_t from, size_t to) {
+    for (size_t i = from; i < to; ++i) {
+        if (text[i] == '\n') {
+            context += " / ";
+        } else {
+            context += text[i];
+        }
+    }
+}
+}
+
+struct HistoryStore::Segment {
+    uint32_t id = 0;
+    int fd = -1;
+    void *map = nullptr;
+    SegmentHeader *header = nullptr;
+    Checkpoint *checkpoints = nullptr;
+    char *text = nullptr;
+
+    // Sealed segments only
+    void *indexMap = nullptr;
+    size_t indexSize = 0;
+    const IndexTerm *terms = nullptr;
+    uint32_t termCount = 0;
+    const uint32_t *postings = nullptr;
+
+    ~Segment() {
+        if (indexMap) munmap(indexMap, indexSize);
+        if (map) {
+            msync(map, SEGMENT_FILE_SIZE, MS_ASYNC);
+            munmap(map, SEGMENT_FILE_SIZE);
+        }
+        if (fd >= 0) ::close(fd);
+    }
+
+    int64_t timeAt(uint32_t offset) const {
+        const Checkpoint *begin = checkpoints;
+        const Checkpoint *end = begin + header->checkpointCount;
+        const Checkpoint *it = std::upper_bound(begin, end, offset,
+            [](uint32_t value, const Checkpoint& checkpoint) { return value < checkpoint.offset; });
+        return it == begin ? header->createdMs : (it - 1)->epochMs;
+    }
+};
+
+HistoryStore::HistoryStore()
+    : m_lockFd(-1)
+    , m_nextId(1)
+    , m_lastCharacter('\n')
+    , m_lastAppendMs(0)
+{
+}
+
+HistoryStore::~HistoryStore() {
+    close();
+}
+
+std::string HistoryStore::segmentPath(uint32_t id, const char *suffix) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/seg-%06u%s", id, suffix);
+    return m_directory + name;
+}
+
+bool HistoryStore::open(const std::string& directory) {
+    close();
+    int lockFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (lockFd < 0) {
+        m_error = directory + ": " + std::strerror(errno);
+        return false;
+    }
+    if (flock(lockFd, LOCK_EX | LOCK_NB) != 0) {
+        m_error = directory + " is in use by another process";
+        ::close(lockFd);
+        return false;
+    }
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        m_error = directory + ": " + std::strerror(errno);
+        ::close(lockFd);
+        return false;
+    }
+
+    // Every segment file counts towards the next id, even one that turns
+    // out to be unreadable, so it is never reused
+    std::vector<uint32_t> ids;
+    while (dirent *entry = readdir(dir)) {
+        unsigned id = 0;
+        char suffix[8] = {};
+        int fields = std::sscanf(entry->d_name, "seg-%6u.%7s", &id, suffix);
+        if (fields < 1) continue;
+        m_nextId = std::max<uint32_t>(m_nextId, id + 1);
+        if (fields == 2 && std::strcmp(suffix, "log") == 0) {
+            ids.push_back(id);
+        }
+    }
+    closedir(dir);
+    std::sort(ids.begin(), ids.end());
+
+    m_directory = directory;
+    m_lockFd = lockFd;
+    std::string skipped;
+    for (uint32_t id : ids) {
+        if (!openSegment(id, false)) {
+            skipped += (skipped.empty() ? "" : ", ") + segmentPath(id, ".log").substr(directory.size() + 1);
+        }
+    }
+    if (!skipped.empty()) m_error = "Skipped unreadable history segments: " + skipped;
+
+    // Only the last segment is appended to; an earlier one left unsealed
+    // (its successor was created after a crash) is sealed and indexed now
+    for (size_t i = 0; i + 1 < m_segments.size(); ++i) {
+        Segment& segment = *m_segments[i];
+        if (segment.header->sealed) continue;
+        segment.header->sealed = 1;
+        msync(segment.map, SEGMENT_FILE_SIZE, MS_SYNC);
+        if (writeIndex(segment)) mapIndex(segment); // Otherwise it is scanned
+    }
+
+    // Only the active segment's index lives in memory; rebuild it from its text
+    if (!m_segments.empty() && !m_segments.back()->header->sealed) {
+        const Segment& active = *m_segments.back();
+        for (uint32_t offset = 2; offset < active.header->textBytes; ++offset) {
+            indexActive(offset);
+        }
+        uint32_t count = active.header->checkpointCount;
+        m_lastAppendMs = count ? active.checkpoints[count - 1].epochMs : active.header->createdMs;
+    }
+    if (!m_segments.empty() && m_segments.back()->header->textBytes > 0) {
+        const Segment& last = *m_segments.back();
+        m_lastCharacter = last.text[last.header->textBytes - 1];
+    }
+    return true;
+}
+
+void HistoryStore::close() {
+    if (!m_segments.empty() && !m_segments.back()->header->sealed) {
+        msync(m_segments.back()->map, SEGMENT_FILE_SIZE, MS_SYNC);
+    }
+    m_segments.clear();
+    m_activeIndex.clear();
+    m_directory.clear();
+    if (m_lockFd >= 0) ::close(m_lockFd); // Drops the flock
+    m_lockFd = -1;
+    m_nextId = 1;
+    m_error.clear();
+    m_lastCharacter = '\n';
+    m_lastAppendMs = 0;
+}
+
+bool HistoryStore::openSegment(uint32_t id, bool create) {
+    std::string path = segmentPath(id, ".log");
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+    if (fd < 0) return false;
+
+    std::unique_ptr<Segment> segment(new Segment());
+    segment->id = id;
+    segment->fd = fd;
+
+    struct stat info;
+    bool sized = create ? ftruncate(fd, SEGMENT_FILE_SIZE) == 0 // Sparse until written
+                        : fstat(fd, &info) == 0 && size_t(info.st_size) == SEGMENT_FILE_SIZE;
+    void *map = sized ? mmap(nullptr, SEGMENT_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (map == MAP_FAILED) {
+        if (create) unlink(path.c_str());
+        return false;
+    }
+    segment->map = map;
+    segment->header = static_cast<SegmentHeader *>(map);
+    segment->checkpoints = reinterpret_cast<Checkpoint *>(static_cast<char *>(map) + CHECKPOINTS_OFFSET);
+    segment->text = static_cast<char *>(map) + TEXT_OFFSET;
+
+    SegmentHeader *header = segment->header;
+    if (create) {
+        std::memcpy(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+        header->version = FORMAT_VERSION;
+    } else if (std::memcmp(header->magic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0
+               || header->version != FORMAT_VERSION
+               || header->textBytes > TEXT_CAPACITY
+               || header->checkpointCount > CHECKPOINT_CAPACITY) {
+        return false;
+    }
+
+    // A sealed segment whose index was never written (crash) gets one now
+    if (header->sealed && !mapIndex(*segment)) {
+        if (!writeIndex(*segment) || !mapIndex(*segment)) return false;
+    }
+    m_segments.push_back(std::move(segment));
+    return true;
+}
+
+bool HistoryStore::startNewSegment(int64_t epochMs) {
+    uint32_t id = m_nextId;
+    if (!openSegment(id, true)) {
+        int error = errno;
+        m_error = "Cannot create " + segmentPath(id, ".log") + ": " + std::strerror(error);
+        if (error == EEXIST) ++m_nextId; // Appeared since open(); the next append tries past it
+        return false;
+    }
+    m_nextId = id + 1;
+    m_segments.back()->header->createdMs = epochMs;
+    m_activeIndex.clear();
+    return true;
+}
+
+void HistoryStore::sealActive() {
+    Segment& active = *m_segments.back();
+    active.header->sealed = 1;
+    msync(active.map, SEGMENT_FILE_SIZE, MS_SYNC);
+    writeIndex(active);
+    mapIndex(active);
+    m_activeIndex.clear();
+}
+
+void HistoryStore::indexActive(uint32_t offset) {
+    // Trigram ending at offset
+    m_activeIndex[trigramAt(m_segments.back()->text + offset - 2)].push_back(offset - 2);
+}
+
+bool HistoryStore::append(char character, int64_t epochMs) {
+    if (!isOpen() || character == '\0') return true;
+    character = char(std::toupper(static_cast<unsigned char>(character)));
+
+    bool needSegment = m_segments.empty() || m_segments.back()->header->sealed;
+    if (!needSegment) {
+        const SegmentHeader *header = m_segments.back()->header;
+        // Room for a session break, the character and a checkpoint
+        needSegment = header->textBytes + 2 > TEXT_CAPACITY || header->checkpointCount + 1 > CHECKPOINT_CAPACITY;
+        if (needSegment) sealActive();
+    }
+    if (needSegment && !startNewSegment(epochMs)) return false;
+
+    Segment& active = *m_segments.back();
+    SegmentHeader *header = active.header;
+    uint32_t offset = header->textBytes;
+
+    // The previous character may be the last of the previous segment
+    if (m_lastCharacter != '\n' && epochMs - m_lastAppendMs >= SESSION_GAP_MS) {
+        active.text[offset] = '\n';
+        if (offset >= 2) indexActive(offset);
+        ++offset;
+        m_lastCharacter = '\n';
+    }
+    if (character == ' ' && (m_lastCharacter == ' ' || m_lastCharacter == '\n')) {
+        header->textBytes = offset;
+        return true;
+    }
+
+    uint32_t count = header->checkpointCount;
+    if (count == 0 || epochMs - active.checkpoints[count - 1].epochMs >= CHECKPOINT_INTERVAL_MS) {
+        active.checkpoints[count] = Checkpoint{offset, 0, epochMs};
+        header->checkpointCount = count + 1;
+    }
+
+    active.text[offset] = character;
+    if (offset >= 2) indexActive(offset);
+    header->textBytes = offset + 1;
+    m_lastCharacter = character;
+    m_lastAppendMs = epochMs;
+    return true;
+}
+
+bool HistoryStore::writeIndex(Segment& segment) {
+    // Sealed segments are indexed from their text; the active one from memory
+    std::unordered_map<uint32_t, std::vector<uint32_t>> rebuilt;
+    const std::unordered_map<uint32_t, std::vector<uint32_t>> *source = &m_activeIndex;
+    if (m_segments.empty() || m_segments.back().get() != &segment || m_activeIndex.empty()) {
+        for (uint32_t offset = 2; offset < segment.header->textBytes; ++offset) {
+            rebuilt[trigramAt(segment.text + offset - 2)].push_back(offset - 2);
+        }
+        source = &rebuilt;
+    }
+
+    std::vector<uint32_t> trigrams;
+    trigrams.reserve(source->size());
+    for (const auto& entry : *source) trigrams.push_back(entry.first);
+    std::sort(trigrams.begin(), trigrams.end());
+
+    IndexHeader header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.termCount = uint32_t(trigrams.size());
+    header.postingCount = 0;
+    std::vector<IndexTerm> terms;
+    terms.reserve(trigrams.size());
+    for (uint32_t trigram : trigrams) {
+        uint32_t count = uint32_t(source->at(trigram).size());
+        terms.push_back(IndexTerm{trigram, header.postingCount, count});
+        header.postingCount += count;
+    }
+
+    // Written under a temporary name so a crash never leaves a torn index
+    std::string path = segmentPath(segment.id, ".idx");
+    std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+              && std::fwrite(terms.data(), sizeof(IndexTerm), terms.size(), file) == terms.size();
+    for (uint32_t trigram : trigrams) {
+        const std::vector<uint32_t>& postings = source->at(trigram);
+        ok = ok && std::fwrite(postings.data(), sizeof(uint32_t), postings.size(), file) == postings.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool HistoryStore::mapIndex(Segment& segment) {
+    std::string path = segmentPath(segment.id, ".idx");
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(IndexHeader);
+    void *map = ok ? mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const IndexHeader *header = static_cast<const IndexHeader *>(map);
+    size_t expected = sizeof(IndexHeader) + size_t(header->termCount) * sizeof(IndexTerm)
+                      + size_t(header->postingCount) * sizeof(uint32_t);
+    if (std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+        || header->version != FORMAT_VERSION || expected != size_t(info.st_size)) {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    segment.indexMap = map;
+    segment.indexSize = info.st_size;
+    segment.termCount = header->termCount;
+    segment.terms = reinterpret_cast<const IndexTerm *>(header + 1);
+    segment.postings = reinterpret_cast<const uint32_t *>(segment.terms + header->termCount);
+    return true;
+}
+
+std::vector<HistoryMatch> HistoryStore::search(const std::string& query, size_t maxResults) const {
+    std::vector<HistoryMatch> matches;
+    std::string normalized = normalizeQuery(query);
+    if (normalized.empty() || maxResults == 0) return matches;
+
+    for (size_t i = m_segments.size(); i-- > 0 && matches.size() < maxResults;) {
+        searchSegment(*m_segments[i], normalized, maxResults, matches);
+        if (i > 0 && matches.size() < maxResults) {
+            searchBoundary(*m_segments[i - 1], *m_segments[i], normalized, maxResults, matches);
+        }
+    }
+    return matches;
+}
+
+void HistoryStore::searchSegment(const Segment& segment, const std::string& query,
+                                 size_t maxResults, std::vector<HistoryMatch>& matches) const {
+    const uint32_t textBytes = segment.header->textBytes;
+    const char *text = segment.text;
+    if (query.size() > textBytes) return;
+
+    // Candidate start offsets, in ascending order
+    // A sealed segment whose index could not be written is scanned
+    const bool active = &segment == m_segments.back().get() && !segment.header->sealed;
+    const bool indexed = segment.indexMap || active;
+    std::vector<uint32_t> candidates;
+    if (query.size() < 3 || !indexed) {
+        // Too short for the index; scan the text
+        const char *end = text + textBytes;
+        for (const char *p = text; (p = std::search(p, end, query.begin(), query.end())) != end; ++p) {
+            candidates.push_back(uint32_t(p - text));
+        }
+    } else {
+        // Postings of the rarest trigram, shifted back to the match start
+        const uint32_t *postings = nullptr;
+        size_t postingCount = SIZE_MAX;
+        size_t position = 0;
+        for (size_t i = 0; i + 3 <= query.size(); ++i) {
+            uint32_t trigram = trigramAt(query.data() + i);
+            const uint32_t *list = nullptr;
+            size_t count = 0;
+            if (segment.indexMap) {
+                const IndexTerm *end = segment.terms + segment.termCount;
+                const IndexTerm *term = std::lower_bound(segment.terms, end, trigram,
+                    [](const IndexTerm& t, uint32_t value) { return t.trigram < value; });
+                if (term != end && term->trigram == trigram) {
+                    list = segment.postings + term->first;
+                    count = term->count;
+                }
+            } else {
+                auto found = m_activeIndex.find(trigram);
+                if (found != m_activeIndex.end()) {
+                    list = found->second.data();
+                    count = found->second.size();
+                }
+            }
+            if (count == 0) return; // A trigram of the query never occurs here
+            if (count < postingCount) {
+                postings = list;
+                postingCount = count;
+                position = i;
+            }
+        }
+        for (size_t i = 0; i < postingCount; ++i) {
+            if (postings[i] < position) continue;
+            uint32_t start = uint32_t(postings[i] - position);
+            if (start + query.size() <= textBytes && std::memcmp(text + start, query.data(), query.size()) == 0) {
+                candidates.push_back(start);
+            }
+        }
+    }
+
+    for (auto it = candidates.rbegin(); it != candidates.rend() && matches.size() < maxResults; ++it) {
+        uint32_t start = *it;
+        size_t from = start > CONTEXT_CHARS ? start - CONTEXT_CHARS : 0;
+        size_t to = std::min<size_t>(textBytes, start + query.size() + CONTEXT_CHARS);
+
+        HistoryMatch match;
+        match.epochMs = segment.timeAt(start);
+        match.segment = segment.id;
+        match.offset = start;
+        appendContext(match.context, text, from, start);
+        match.matchStart = match.context.size();
+        appendContext(match.context, text, start, to);
+        matches.push_back(std::move(match));
+    }
+}
+
+void HistoryStore::searchBoundary(const Segment& older, const Segment& newer, const std::string& query,
+                                  size_t maxResults, std::vector<HistoryMatch>& matches) const {
+    // Consecutive ids only: text was lost across a gap
+    if (query.size() < 2 || older.id + 1 != newer.id) return;
+    const uint32_t olderBytes = older.header->textBytes;
+    const uint32_t newerBytes = newer.header->textBytes;
+    const uint32_t tail = std::min<uint32_t>(olderBytes, uint32_t(query.size() - 1));
+    const uint32_t head = std::min<uint32_t>(newerBytes, uint32_t(query.size() - 1));
+    std::string joined(older.text + olderBytes - tail, tail);
+    joined.append(newer.text, head);
+
+    // Matches that start in the older segment and end in the newer one
+    for (uint32_t start = tail; start-- > 0 && matches.size() < maxResults;) {
+        if (start + query.size() > joined.size() || joined.compare(start, query.size(), query) != 0) continue;
+        uint32_t offset = olderBytes - tail + start;
+        size_t end = start + query.size() - tail; // Within the newer segment
+
+        HistoryMatch match;
+        match.epochMs = older.timeAt(offset);
+        match.segment = older.id;
+        match.offset = offset;
+        appendContext(match.context, older.text, offset > CONTEXT_CHARS ? offset - CONTEXT_CHARS : 0, offset);
+        match.matchStart = match.context.size();
+        appendContext(match.context, older.text, offset, olderBytes);
+        appendContext(match.context, newer.text, 0, std::min<size_t>(newerBytes, end + CONTEXT_CHARS));
+        matches.push_back(std::move(match));
+    }
+}
+
+uint64_t HistoryStore::totalBytes() const {
+    uint64_t total = 0;
+    for (const auto& segment : m_segments) total += segment->header->textBytes;
+    return total;
+}
+
+} // namespace morse
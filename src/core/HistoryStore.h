@@ -0,0 +1,90 @@
+#ifndef MORSE_HISTORYSTORE_H
+#define MORSE_HISTORYSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace morse {
+
+struct HistoryMatch {
+    int64_t epochMs;      // Within a second of when the match was heard
+    std::string context;  // The match with surrounding text, newlines as " / "
+    size_t matchStart;    // Offset of the match within context
+    uint32_t segment;
+    uint32_t offset;
+};
+
+// Append-only store of all decoded text, searchable by substring.
+//
+// Text goes into fixed-size segment files that are memory-mapped, with a
+// table of (offset, time) checkpoints at most a second apart. Every
+// character extends a trigram index of the active segment in memory; when
+// a segment fills up it is sealed and its index written once as a sorted
+// table next to it. A search maps only the index tables, looks up the
+// rarest trigram of the query and verifies its candidates against the
+// text, so it touches a few pages per segment instead of reading them.
+//
+// The directory is locked with flock while open, so only one process
+// appends. Segments that cannot be read are skipped and never reused: new
+// ids continue past every segment file on disk.
+class HistoryStore {
+public:
+    static constexpr uint32_t TEXT_CAPACITY = 1u << 20;    // Bytes per segment
+    static constexpr uint32_t CHECKPOINT_CAPACITY = 65536;
+    static constexpr int64_t SESSION_GAP_MS = 60000;       // Longer silences start a new line
+
+    HistoryStore();
+    ~HistoryStore();
+    HistoryStore(const HistoryStore&) = delete;
+    HistoryStore& operator=(const HistoryStore&) = delete;
+
+    // False if the directory cannot be read or is locked by another
+    // process; true with lastError() set if some segments were skipped
+    bool open(const std::string& directory);
+    void close();
+    bool isOpen() const { return !m_directory.empty(); }
+    const std::string& lastError() const { return m_error; }
+
+    // Characters are stored upper-cased; ' ' marks a word space. False,
+    // with lastError() set, if no segment could be created for it.
+    bool append(char character, int64_t epochMs);
+
+    // Newest matches first; queries are case-insensitive. Matches may span
+    // two consecutive segments.
+    std::vector<HistoryMatch> search(const std::string& query, size_t maxResults) const;
+
+    size_t segmentCount() const { return m_segments.size(); }
+    uint64_t totalBytes() const;
+
+private:
+    struct Segment;
+
+    bool openSegment(uint32_t id, bool create);
+    bool startNewSegment(int64_t epochMs);
+    void sealActive();
+    bool writeIndex(Segment& segment);
+    bool mapIndex(Segment& segment);
+    void indexActive(uint32_t offset);
+    void searchSegment(const Segment& segment, const std::string& query,
+                       size_t maxResults, std::vector<HistoryMatch>& matches) const;
+    void searchBoundary(const Segment& older, const Segment& newer, const std::string& query,
+                        size_t maxResults, std::vector<HistoryMatch>& matches) const;
+    std::string segmentPath(uint32_t id, const char *suffix) const;
+
+    std::string m_directory;
+    int m_lockFd;
+    uint32_t m_nextId;  // Past every segment file found on disk
+    std::string m_error;
+    char m_lastCharacter; // Last one stored, '\n' at the start
+    std::vector<std::unique_ptr<Segment>> m_segments; // Oldest first; the last one is active
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_activeIndex;
+    int64_t m_lastAppendMs;
+};
+
+} // namespace morse
+
+#endif // MORSE_HISTORYSTORE_H
@@ -0,0 +1,65 @@
+#include "HotPathReplay.h"
+#include "MorseCode.h"
+#include "PracticeText.h"
+#include <cstdio>
+
+namespace morse {
+
+namespace {
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+}
+
+std::vector<KeyEdge> HotPathReplay::generate(double hours, uint32_t seed) {
+    std::vector<KeyEdge> edges;
+    const int64_t endUs = static_cast<int64_t>(hours * 3600e6);
+    uint32_t rng = seed ? seed : 1;
+    int64_t timeUs = 1000000;
+
+    // Each QSO at its own speed; every duration (in tenths of a unit) is
+    // jittered by up to +-10%, with character gaps sent a little long
+    for (uint32_t qso = 0; timeUs < endUs; ++qso) {
+        const int64_t unitUs = 1200000 / int64_t(16 + nextRandom(rng) % 15);
+        auto jittered = [&](int64_t tenths) {
+            int64_t base = tenths * unitUs / 10;
+            return base + base * int64_t(nextRandom(rng) % 201) / 1000 - base / 10;
+        };
+
+        const std::string text = PracticeText::qso(seed + qso);
+        for (char c : text) {
+            if (c == ' ') {
+                timeUs += jittered(40); // Completes the word gap
+                continue;
+            }
+            Pattern pattern = MorseCode::encode(c);
+            for (int i = 0; i < pattern.storedLength(); ++i) {
+                edges.push_back({timeUs, true});
+                timeUs += jittered(pattern.isDah(i) ? 30 : 10);
+                edges.push_back({timeUs, false});
+                timeUs += jittered(i + 1 < pattern.storedLength() ? 10 : 35);
+            }
+        }
+        timeUs += jittered(200);
+    }
+    return edges;
+}
+
+std::string HotPathReport::format() const {
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "Replayed %zu key edges (%.2f h of keying, %zu characters)\n"
+                  "Capture thread: %llu allocations after %zu warm-up edges\n"
+                  "Main thread: %llu allocations after %zu warm-up edges\n%s\n",
+                  edges, seconds / 3600.0, characters,
+                  static_cast<unsigned long long>(captureAllocations), warmupEdges,
+                  static_cast<unsigned long long>(decodeAllocations), warmupEdges,
+                  !counted ? "UNCHECKED: built without MORSE_ALLOCATION_COUNTER"
+                           : passed() ? "PASS" : "FAIL");
+    return text;
+}
+
+} // namespace morse
@@ -0,0 +1,39 @@
+#ifndef MORSE_HOTPATHREPLAY_H
+#define MORSE_HOTPATHREPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ToneDetector.h"
+
+namespace morse {
+
+struct HotPathReport {
+    size_t edges = 0;
+    double seconds = 0.0;            // Keying time covered by the replay
+    size_t characters = 0;
+    size_t warmupEdges = 0;          // Not counted
+    uint64_t captureAllocations = 0; // After warm-up, producer thread
+    uint64_t decodeAllocations = 0;  // After warm-up, main thread
+    bool counted = false;            // Built with the allocation counter
+
+    bool passed() const { return counted && captureAllocations == 0 && decodeAllocations == 0; }
+    std::string format() const;
+};
+
+// Key edges for replaying a keying session through the live pipeline, and
+// the report of the allocation check in morse-decoder --check-allocations.
+// The replay itself lives with the Qt code, so it runs the real
+// MorseDecoder and SessionLogger rather than a copy of them.
+class HotPathReplay {
+public:
+    static constexpr size_t WARMUP_EDGES = 1000;
+
+    // Generated QSOs at varying speeds with timing jitter
+    static std::vector<KeyEdge> generate(double hours, uint32_t seed);
+};
+
+} // namespace morse
+
+#endif // MORSE_HOTPATHREPLAY_H
@@ -0,0 +1,92 @@
+#include "MorseCode.h"
+
+namespace morse {
+
+namespace {
+
+struct Entry {
+    const char *pattern;
+    char character;
+};
+
+const Entry ENTRIES[] = {
+    // Letters
+    {".-", 'A'}, {"-...", 'B'}, {"-.-.", 'C'}, {"-..", 'D'}, {".", 'E'},
+    {"..-.", 'F'}, {"--.", 'G'}, {"....", 'H'}, {"..", 'I'}, {".---", 'J'},
+    {"-.-", 'K'}, {".-..", 'L'}, {"--", 'M'}, {"-.", 'N'}, {"---", 'O'},
+    {".--.", 'P'}, {"--.-", 'Q'}, {".-.", 'R'}, {"...", 'S'}, {"-", 'T'},
+    {"..-", 'U'}, {"...-", 'V'}, {".--", 'W'}, {"-..-", 'X'}, {"-.--", 'Y'},
+    {"--..", 'Z'},
+
+    // Numbers
+    {"-----", '0'}, {".----", '1'}, {"..---", '2'}, {"...--", '3'}, {"....-", '4'},
+    {".....", '5'}, {"-....", '6'}, {"--...", '7'}, {"---..", '8'}, {"----.", '9'},
+
+    // Punctuation
+    {".-.-.-", '.'}, {"--..--", ','}, {"..--..", '?'}, {".----.", '\''},
+    {"-.-.--", '!'}, {"-..-.", '/'}, {"-.--.", '('}, {"-.--.-", ')'},
+    {".-...", '&'}, {"---...", ':'}, {"-.-.-.", ';'}, {"-...-", '='},
+    {".-.-.", '+'}, {"-....-", '-'}, {"..--.-", '_'}, {".-..-.", '"'},
+    {"...-..-", '$'}, {".--.-.", '@'},
+};
+
+// Indexed by Pattern::code (sentinel + up to 8 element bits) and by ASCII
+struct Tables {
+    char decode[1 << (Pattern::MAX_ELEMENTS + 1)] = {};
+    Pattern encode[128] = {};
+
+    Tables() {
+        for (const Entry& entry : ENTRIES) {
+            Pattern pattern = Pattern::fromString(entry.pattern);
+            decode[pattern.code] = entry.character;
+            encode[static_cast<unsigned char>(entry.character)] = pattern;
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+} // namespace
+
+int Pattern::toString(char *out, int capacity) const {
+    if (capacity <= 0) return 0;
+
+    int count = storedLength();
+    if (count > capacity - 1) count = capacity - 1;
+    for (int i = 0; i < count; ++i) {
+        out[i] = isDah(i) ? '-' : '.';
+    }
+    if (overflowed() && count == storedLength() && count < capacity - 1) {
+        out[count++] = OVERFLOW_MARK;
+    }
+    out[count] = '\0';
+    return count;
+}
+
+Pattern Pattern::fromString(const char *text) {
+    Pattern pattern;
+    for (; text && *text; ++text) {
+        if (*text == '.' || *text == '-') {
+            pattern.append(*text == '-');
+        }
+    }
+    return pattern;
+}
+
+char MorseCode::decode(Pattern pattern) {
+    if (pattern.isEmpty() || pattern.overflowed()) return '\0';
+    return tables().decode[pattern.code];
+}
+
+Pattern MorseCode::encode(char character) {
+    if (character >= 'a' && character <= 'z') {
+        character = static_cast<char>(character - 'a' + 'A');
+    }
+    unsigned char index = static_cast<unsigned char>(character);
+    return index < 128 ? tables().encode[index] : Pattern();
+}
+
+} // namespace morse
@@ -0,0 +1,49 @@
+#ifndef MORSE_MORSECODE_H
+#define MORSE_MORSECODE_H
+
+#include <cstdint>
+
+namespace morse {
+
+// A sequence of elements packed behind a sentinel bit: the empty pattern is
+// 0b1 and each element shifts in a 0 (dit) or 1 (dah). Patterns up to
+// MAX_ELEMENTS long index the decode table directly. Longer patterns keep
+// their first MAX_ELEMENTS elements and count the rest.
+struct Pattern {
+    static constexpr int MAX_ELEMENTS = 8;
+    static constexpr char OVERFLOW_MARK = '+';
+    static constexpr int MAX_STRING = MAX_ELEMENTS + 2; // Elements, overflow mark, NUL
+
+    uint16_t code = 1;
+    uint8_t length = 0;
+
+    void append(bool isDah) {
+        if (length < MAX_ELEMENTS) {
+            code = static_cast<uint16_t>((code << 1) | (isDah ? 1 : 0));
+        }
+        if (length < UINT8_MAX) ++length;
+    }
+    void clear() { code = 1; length = 0; }
+    bool isEmpty() const { return length == 0; }
+    bool overflowed() const { return length > MAX_ELEMENTS; }
+    int storedLength() const { return length < MAX_ELEMENTS ? length : MAX_ELEMENTS; }
+    bool isDah(int index) const { return (code >> (storedLength() - 1 - index)) & 1; }
+
+    // Writes '.'/'-' characters, OVERFLOW_MARK if elements were dropped,
+    // and a terminating NUL; returns the length
+    int toString(char *out, int capacity) const;
+    static Pattern fromString(const char *text);
+};
+
+class MorseCode {
+public:
+    // '\0' for patterns that are not in the table
+    static char decode(Pattern pattern);
+    // Empty pattern for characters without a code; letters are case-folded
+    static Pattern encode(char character);
+    static bool isValid(Pattern pattern) { return decode(pattern) != '\0'; }
+};
+
+} // namespace morse
+
+#endif // MORSE_MORSECODE_H
@@ -0,0 +1,104 @@
+#include "PracticeText.h"
+#include <algorithm>
+#include <random>
+
+namespace morse {
+
+namespace {
+// LCWO order: the 40 characters of the Koch method
+constexpr char KOCH_ORDER[] = "KMRSUAPTLOWI.NJEF0YV,G5/Q9ZH38B?427C1D6X";
+constexpr char ALPHANUMERIC[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+constexpr const char *PREFIXES[] = {
+    "W", "K", "N", "AA", "KB", "WA", "VE", "G", "M", "DL", "F", "EA", "I", "ON",
+    "PA", "OH", "SM", "LA", "JA", "VK", "ZL", "OK", "SP", "HA", "YO", "LZ", "UA"
+};
+constexpr const char *NAMES[] = {
+    "JOHN", "BOB", "ANN", "MIKE", "TOM", "SUE", "JIM", "PETE", "LIZ", "HANS",
+    "JEAN", "PAUL", "KARL", "ERIK", "TONY", "ED", "RAY", "DAN", "BILL", "JO"
+};
+constexpr const char *QTHS[] = {
+    "BOSTON", "DENVER", "AUSTIN", "OTTAWA", "LONDON", "BERLIN", "PARIS", "MADRID",
+    "ROME", "OSLO", "TOKYO", "SYDNEY", "PRAGUE", "VIENNA", "DUBLIN", "LYON"
+};
+constexpr const char *RIGS[] = { "IC7300", "K3", "FT991", "TS590", "KX2", "QRP 5W" };
+constexpr const char *RSTS[] = { "599", "579", "569", "559", "449", "339" };
+
+template <typename T, size_t N>
+const T& pick(const T (&items)[N], std::mt19937& rng) {
+    return items[std::uniform_int_distribution<size_t>(0, N - 1)(rng)];
+}
+
+std::string groups(const std::string& alphabet, int count, int length, std::mt19937& rng) {
+    std::string text;
+    if (alphabet.empty()) return text;
+    std::uniform_int_distribution<size_t> index(0, alphabet.size() - 1);
+    for (int g = 0; g < count; ++g) {
+        if (g > 0) text += ' ';
+        for (int i = 0; i < length; ++i) {
+            text += alphabet[index(rng)];
+        }
+    }
+    return text;
+}
+
+std::string makeCallsign(std::mt19937& rng) {
+    std::uniform_int_distribution<int> letter('A', 'Z');
+    std::uniform_int_distribution<int> suffixLength(1, 3);
+    std::string call = pick(PREFIXES, rng);
+    call += char('0' + std::uniform_int_distribution<int>(0, 9)(rng));
+    for (int i = suffixLength(rng); i > 0; --i) {
+        call += char(letter(rng));
+    }
+    return call;
+}
+}
+
+std::string PracticeText::kochCharacters(int lesson) {
+    int count = std::clamp(lesson, 1, KOCH_LESSONS) + 1;
+    return std::string(KOCH_ORDER, count);
+}
+
+std::string PracticeText::kochGroups(int lesson, int groupCount, int groupLength, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::string alphabet = kochCharacters(lesson);
+    std::string text;
+    // Half of every group draws from the newest character so it gets practiced
+    std::uniform_int_distribution<int> coin(0, 1);
+    std::uniform_int_distribution<size_t> index(0, alphabet.size() - 1);
+    for (int g = 0; g < groupCount; ++g) {
+        if (g > 0) text += ' ';
+        for (int i = 0; i < groupLength; ++i) {
+            text += coin(rng) ? alphabet.back() : alphabet[index(rng)];
+        }
+    }
+    return text;
+}
+
+std::string PracticeText::randomGroups(int groupCount, int groupLength, uint32_t seed) {
+    std::mt19937 rng(seed);
+    return groups(ALPHANUMERIC, groupCount, groupLength, rng);
+}
+
+std::string PracticeText::callsign(uint32_t seed) {
+    std::mt19937 rng(seed);
+    return makeCallsign(rng);
+}
+
+std::string PracticeText::qso(uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::string me = makeCallsign(rng);
+    std::string you = makeCallsign(rng);
+    std::string name = pick(NAMES, rng);
+    std::string qth = pick(QTHS, rng);
+    std::string rst = pick(RSTS, rng);
+
+    std::string text = "CQ CQ CQ DE " + me + ' ' + me + " K ";
+    text += me + " DE " + you + ' ' + you + " K ";
+    text += you + " DE " + me + " GM TNX FER CALL UR RST " + rst + ' ' + rst;
+    text += " NAME " + name + ' ' + name + " QTH " + qth + ' ' + qth + " HW? " + you + " DE " + me + " K ";
+    text += me + " DE " + you + " R TNX " + name + " RIG " + pick(RIGS, rng) + " 73 " + me + " DE " + you + " SK";
+    return text;
+}
+
+} // namespace morse
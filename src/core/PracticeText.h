@@ -0,0 +1,27 @@
+#ifndef MORSE_PRACTICETEXT_H
+#define MORSE_PRACTICETEXT_H
+
+#include <cstdint>
+#include <string>
+
+namespace morse {
+
+// Practice material: Koch lessons, random five-letter groups and
+// plausible QSO exchanges. The same seed always yields the same text, so
+// rendered corpora can be reproduced.
+class PracticeText {
+public:
+    static constexpr int KOCH_LESSONS = 39; // Lesson n teaches n + 1 characters
+
+    // Characters introduced up to the given lesson, in Koch order
+    static std::string kochCharacters(int lesson);
+
+    static std::string kochGroups(int lesson, int groups, int groupLength, uint32_t seed);
+    static std::string randomGroups(int groups, int groupLength, uint32_t seed);
+    static std::string qso(uint32_t seed);
+    static std::string callsign(uint32_t seed);
+};
+
+} // namespace morse
+
+#endif // MORSE_PRACTICETEXT_H
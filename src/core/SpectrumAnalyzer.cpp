@@ -0,0 +1,114 @@
+#include "SpectrumAnalyzer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace morse {
+
+namespace {
+constexpr float PI = 3.14159265358979f;
+constexpr float RESOLUTION_HZ = 12.0f;
+constexpr int MIN_FFT_SIZE = 256;
+constexpr int MAX_FFT_SIZE = 8192;
+constexpr float POWER_FLOOR = 1e-20f; // -200 dB, keeps log10 finite
+
+int bitReverse(int value, int bits) {
+    int result = 0;
+    for (int i = 0; i < bits; ++i) {
+        result = (result << 1) | (value & 1);
+        value >>= 1;
+    }
+    return result;
+}
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(int sampleRate, float maxHz, int rowsPerSecond)
+    : m_callback(nullptr)
+    , m_context(nullptr)
+    , m_sampleRate(std::max(1, sampleRate))
+    , m_fftSize(MIN_FFT_SIZE)
+    , m_log2Size(0)
+    , m_writePos(0)
+    , m_sinceRow(0)
+{
+    while (m_fftSize < MAX_FFT_SIZE && float(m_sampleRate) / float(m_fftSize) > RESOLUTION_HZ) {
+        m_fftSize *= 2;
+    }
+    while ((1 << m_log2Size) < m_fftSize) ++m_log2Size;
+
+    int wanted = int(std::ceil(maxHz / binHz())) + 1;
+    m_bins = std::clamp(wanted, 1, std::min(m_fftSize / 2, SPECTRUM_MAX_BINS));
+    m_hop = std::max(1, m_sampleRate / std::max(1, rowsPerSecond));
+
+    // Hann window; its coherent gain is 1/2, so a sine of amplitude 1
+    // peaks at fftSize / 4
+    m_window.resize(size_t(m_fftSize));
+    for (int i = 0; i < m_fftSize; ++i) {
+        m_window[size_t(i)] = 0.5f - 0.5f * std::cos(2.0f * PI * float(i) / float(m_fftSize));
+    }
+    m_scaleDb = -20.0f * std::log10(float(m_fftSize) / 4.0f);
+
+    m_twiddles.resize(size_t(m_fftSize / 2));
+    for (int i = 0; i < m_fftSize / 2; ++i) {
+        float angle = -2.0f * PI * float(i) / float(m_fftSize);
+        m_twiddles[size_t(i)] = std::complex<float>(std::cos(angle), std::sin(angle));
+    }
+    m_history.assign(size_t(m_fftSize), 0.0f);
+    m_buffer.resize(size_t(m_fftSize));
+    m_levels.resize(size_t(m_bins));
+}
+
+void SpectrumAnalyzer::setCallback(RowCallback callback, void *context) {
+    m_callback = callback;
+    m_context = context;
+}
+
+void SpectrumAnalyzer::reset() {
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    m_writePos = 0;
+    m_sinceRow = 0;
+}
+
+void SpectrumAnalyzer::process(const float *samples, size_t count) {
+    const size_t size = m_history.size();
+    for (size_t i = 0; i < count; ++i) {
+        m_history[m_writePos] = samples[i];
+        if (++m_writePos == size) m_writePos = 0;
+        if (++m_sinceRow == m_hop) {
+            m_sinceRow = 0;
+            computeRow();
+        }
+    }
+}
+
+void SpectrumAnalyzer::computeRow() {
+    const int n = m_fftSize;
+
+    // Oldest sample first, windowed, stored in bit-reversed order
+    for (int i = 0; i < n; ++i) {
+        size_t source = (m_writePos + size_t(i)) & size_t(n - 1);
+        m_buffer[size_t(bitReverse(i, m_log2Size))] =
+            std::complex<float>(m_history[source] * m_window[size_t(i)], 0.0f);
+    }
+
+    // Iterative radix-2 decimation in time
+    for (int length = 2; length <= n; length <<= 1) {
+        const int half = length / 2;
+        const int stride = n / length;
+        for (int start = 0; start < n; start += length) {
+            for (int k = 0; k < half; ++k) {
+                std::complex<float> odd = m_buffer[size_t(start + k + half)] * m_twiddles[size_t(k * stride)];
+                std::complex<float> even = m_buffer[size_t(start + k)];
+                m_buffer[size_t(start + k)] = even + odd;
+                m_buffer[size_t(start + k + half)] = even - odd;
+            }
+        }
+    }
+
+    for (int k = 0; k < m_bins; ++k) {
+        float power = std::norm(m_buffer[size_t(k)]);
+        m_levels[size_t(k)] = 10.0f * std::log10(std::max(power, POWER_FLOOR)) + m_scaleDb;
+    }
+    if (m_callback) m_callback(m_levels.data(), m_bins, m_context);
+}
+
+} // namespace morse
@@ -0,0 +1,58 @@
+#ifndef MORSE_SPECTRUMANALYZER_H
+#define MORSE_SPECTRUMANALYZER_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace morse {
+
+// Rows never carry more bins than this, so they fit fixed-size buffers
+constexpr int SPECTRUM_MAX_BINS = 512;
+
+// Sliding power spectrum for a waterfall. Samples go into a window of
+// fftSize(); every hop (sampleRate / rowsPerSecond samples) the window is
+// Hann-weighted and transformed, and the bins from 0 Hz up to maxHz are
+// reported in dB relative to a full-scale sine. The FFT size is chosen for
+// bins of at most 12 Hz. process() never allocates.
+class SpectrumAnalyzer {
+public:
+    using RowCallback = void (*)(const float *levelsDb, int bins, void *context);
+
+    explicit SpectrumAnalyzer(int sampleRate = 48000, float maxHz = 3000.0f, int rowsPerSecond = 60);
+
+    void setCallback(RowCallback callback, void *context);
+    void process(const float *samples, size_t count);
+    void reset();
+
+    int sampleRate() const { return m_sampleRate; }
+    int fftSize() const { return m_fftSize; }
+    int bins() const { return m_bins; }
+    float binHz() const { return float(m_sampleRate) / float(m_fftSize); }
+    int hop() const { return m_hop; }
+
+private:
+    void computeRow();
+
+    RowCallback m_callback;
+    void *m_context;
+    int m_sampleRate;
+    int m_fftSize;
+    int m_log2Size;
+    int m_bins;
+    int m_hop;
+    float m_scaleDb;             // Puts a full-scale sine at 0 dB
+
+    std::vector<float> m_window;
+    std::vector<float> m_history; // Ring of the last fftSize samples
+    size_t m_writePos;
+    int m_sinceRow;
+
+    std::vector<std::complex<float>> m_twiddles;
+    std::vector<std::complex<float>> m_buffer;
+    std::vector<float> m_levels;
+};
+
+} // namespace morse
+
+#endif // MORSE_SPECTRUMANALYZER_H
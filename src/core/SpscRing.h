@@ -0,0 +1,46 @@
+#ifndef MORSE_SPSCRING_H
+#define MORSE_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace morse {
+
+// Fixed-capacity single-producer/single-consumer queue. push() and pop()
+// are wait-free and never allocate; a full ring rejects the push.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Ring elements are copied by value");
+
+public:
+    bool push(const T& value) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity) return false;
+        m_items[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) return false;
+        value = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+} // namespace morse
+
+#endif // MORSE_SPSCRING_H
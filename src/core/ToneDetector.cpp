@@ -0,0 +1,152 @@
+#include "ToneDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace morse {
+
+namespace {
+constexpr float PI = 3.14159265358979f;
+
+constexpr float ATTACK = 0.5f;          // Signal peak follows rises quickly
+constexpr float SIGNAL_DECAY = 0.002f;  // ...and relaxes over a few seconds
+constexpr float NOISE_ALPHA = 0.02f;    // Average over ~50 blocks of key-up
+constexpr float DOWN_SNR = 3.0f;        // Minimum margins over the average noise
+constexpr float UP_SNR = 2.0f;
+constexpr float DOWN_THRESHOLD = 0.55f; // Fractions of the noise-to-signal range
+constexpr float UP_THRESHOLD = 0.35f;
+constexpr int CONFIRM_BLOCKS = 2;
+
+constexpr float ESTIMATE_STEP_HZ = 10.0f;
+constexpr int ESTIMATE_MAX_SECONDS = 30;
+
+float goertzelCoefficient(float frequencyHz, int sampleRate) {
+    return 2.0f * std::cos(2.0f * PI * frequencyHz / float(sampleRate));
+}
+}
+
+ToneDetector::ToneDetector(int sampleRate, float frequencyHz, int blockMs)
+    : m_sampleRate(sampleRate)
+    , m_frequencyHz(frequencyHz)
+    , m_blockSize(std::max(16, sampleRate * blockMs / 1000))
+    , m_coefficient(0.0f)
+{
+    updateCoefficient();
+    reset();
+}
+
+void ToneDetector::setFrequency(float frequencyHz) {
+    m_frequencyHz = frequencyHz;
+    updateCoefficient();
+    // The old levels describe a different signal
+    m_signal = m_noise;
+}
+
+void ToneDetector::updateCoefficient() {
+    m_coefficient = goertzelCoefficient(m_frequencyHz, m_sampleRate);
+}
+
+void ToneDetector::reset() {
+    m_s1 = 0.0f;
+    m_s2 = 0.0f;
+    m_filled = 0;
+    m_blocks = 0;
+    m_signal = 0.0f;
+    m_noise = -1.0f;
+    m_keyDown = false;
+    m_pendingBlocks = 0;
+}
+
+int64_t ToneDetector::positionUs() const {
+    int64_t samples = m_blocks * m_blockSize + m_filled;
+    return samples * 1000000 / m_sampleRate;
+}
+
+void ToneDetector::process(const float *samples, size_t count, std::vector<KeyEdge>& edges) {
+    float s1 = m_s1;
+    float s2 = m_s2;
+    const float coefficient = m_coefficient;
+
+    for (size_t i = 0; i < count; ++i) {
+        float s0 = samples[i] + coefficient * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+        if (++m_filled == m_blockSize) {
+            m_s1 = s1;
+            m_s2 = s2;
+            finishBlock(edges);
+            s1 = 0.0f;
+            s2 = 0.0f;
+        }
+    }
+    m_s1 = s1;
+    m_s2 = s2;
+}
+
+void ToneDetector::finishBlock(std::vector<KeyEdge>& edges) {
+    float power = m_s1 * m_s1 + m_s2 * m_s2 - m_coefficient * m_s1 * m_s2;
+    float magnitude = std::sqrt(std::max(power, 0.0f)) * 2.0f / float(m_blockSize);
+
+    if (m_noise < 0.0f) {
+        m_noise = magnitude;
+        m_signal = magnitude;
+    }
+    if (magnitude > m_signal) {
+        m_signal += (magnitude - m_signal) * ATTACK;
+    } else {
+        m_signal -= (m_signal - m_noise) * SIGNAL_DECAY;
+    }
+
+    float range = m_signal - m_noise;
+    float downThreshold = std::max(m_noise * DOWN_SNR, m_noise + range * DOWN_THRESHOLD);
+    float upThreshold = std::max(m_noise * UP_SNR, m_noise + range * UP_THRESHOLD);
+    bool above = magnitude > (m_keyDown ? upThreshold : downThreshold);
+    if (!m_keyDown && !above) {
+        m_noise += (magnitude - m_noise) * NOISE_ALPHA;
+    }
+
+    if (above == m_keyDown) {
+        m_pendingBlocks = 0;
+    } else if (++m_pendingBlocks == CONFIRM_BLOCKS) {
+        m_keyDown = above;
+        m_pendingBlocks = 0;
+        // Stamped at the centre of the first block of the change, for both
+        // edges alike, so durations are unbiased
+        int64_t centre = (m_blocks - (CONFIRM_BLOCKS - 1)) * m_blockSize + m_blockSize / 2;
+        edges.push_back({centre * 1000000 / m_sampleRate, m_keyDown});
+    }
+
+    ++m_blocks;
+    m_filled = 0;
+}
+
+float ToneDetector::estimateFrequency(const float *samples, size_t count, int sampleRate,
+                                      float minHz, float maxHz) {
+    count = std::min(count, size_t(sampleRate) * ESTIMATE_MAX_SECONDS);
+    const int bins = std::max(1, int((maxHz - minHz) / ESTIMATE_STEP_HZ) + 1);
+    const size_t frame = size_t(sampleRate / 50); // 20 ms, about 50 Hz wide
+
+    float bestPower = -1.0f;
+    float bestHz = minHz;
+    for (int bin = 0; bin < bins; ++bin) {
+        float hz = minHz + bin * ESTIMATE_STEP_HZ;
+        float coefficient = goertzelCoefficient(hz, sampleRate);
+        double total = 0.0;
+        for (size_t start = 0; start + frame <= count; start += frame) {
+            float s1 = 0.0f;
+            float s2 = 0.0f;
+            for (size_t i = start; i < start + frame; ++i) {
+                float s0 = samples[i] + coefficient * s1 - s2;
+                s2 = s1;
+                s1 = s0;
+            }
+            total += s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+        }
+        if (total > bestPower) {
+            bestPower = float(total);
+            bestHz = hz;
+        }
+    }
+    return bestHz;
+}
+
+} // namespace morse
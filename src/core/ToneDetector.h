@@ -0,0 +1,64 @@
+#ifndef MORSE_TONEDETECTOR_H
+#define MORSE_TONEDETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace morse {
+
+struct KeyEdge {
+    int64_t timeUs;
+    bool down;
+};
+
+// Turns CW audio into key edges. A Goertzel filter measures the tone in
+// short blocks; the magnitude is compared against a threshold halfway
+// between the average noise (tracked while the key is up) and a tracked
+// signal peak, with hysteresis. A change of state must hold for two blocks,
+// so fading and noise spikes do not chatter the key.
+class ToneDetector {
+public:
+    explicit ToneDetector(int sampleRate, float frequencyHz = 700.0f, int blockMs = 5);
+
+    void setFrequency(float frequencyHz);
+    float frequency() const { return m_frequencyHz; }
+    int sampleRate() const { return m_sampleRate; }
+    void reset();
+
+    // Samples continue where the previous call stopped; edges are appended
+    // with times relative to the first sample since reset()
+    void process(const float *samples, size_t count, std::vector<KeyEdge>& edges);
+
+    bool keyIsDown() const { return m_keyDown; }
+    int64_t positionUs() const;
+    float signalLevel() const { return m_signal; }
+    float noiseLevel() const { return m_noise; }
+
+    // Strongest steady tone between minHz and maxHz, in 10 Hz steps
+    static float estimateFrequency(const float *samples, size_t count, int sampleRate,
+                                   float minHz = 300.0f, float maxHz = 1200.0f);
+
+private:
+    void updateCoefficient();
+    void finishBlock(std::vector<KeyEdge>& edges);
+
+    int m_sampleRate;
+    float m_frequencyHz;
+    int m_blockSize;
+    float m_coefficient;
+
+    float m_s1;
+    float m_s2;
+    int m_filled;
+    int64_t m_blocks;
+
+    float m_signal;
+    float m_noise;
+    bool m_keyDown;
+    int m_pendingBlocks;   // Consecutive blocks disagreeing with m_keyDown
+};
+
+} // namespace morse
+
+#endif // MORSE_TONEDETECTOR_H
@@ -0,0 +1,237 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace morse {
+
+std::atomic<bool> Tracer::s_enabled(false);
+
+namespace {
+constexpr uint64_t RING_MASK = Tracer::RING_CAPACITY - 1;
+static_assert((Tracer::RING_CAPACITY & RING_MASK) == 0, "Ring capacity must be a power of two");
+
+// Written only by its owning thread. Readers copy it and then discard
+// anything the writer may have overwritten meanwhile.
+struct ThreadRing {
+    TraceEvent events[Tracer::RING_CAPACITY];
+    std::atomic<uint64_t> head{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<bool> retired{false};
+    int tid = 0;
+};
+
+// Rings outlive their threads so a dump still shows threads that have
+// exited (e.g. a key watcher before a reconnect). Past MAX_RINGS, rings
+// of exited threads are reused.
+constexpr size_t MAX_RINGS = 32;
+std::mutex g_registryMutex;
+std::vector<ThreadRing *> g_rings;
+int g_nextTid = 1;
+
+struct RingHolder {
+    ThreadRing *ring = nullptr;
+    const char *name = nullptr;
+    ~RingHolder() {
+        if (ring) ring->retired.store(true, std::memory_order_release);
+    }
+};
+
+thread_local RingHolder t_holder;
+
+ThreadRing *currentRing() {
+    if (t_holder.ring) return t_holder.ring;
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    ThreadRing *ring = nullptr;
+    if (g_rings.size() >= MAX_RINGS) {
+        for (ThreadRing *candidate : g_rings) {
+            if (candidate->retired.load(std::memory_order_acquire)) {
+                ring = candidate;
+                break;
+            }
+        }
+    }
+    if (!ring) {
+        ring = new ThreadRing();
+        g_rings.push_back(ring);
+    }
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->retired.store(false, std::memory_order_relaxed);
+    ring->name.store(t_holder.name, std::memory_order_relaxed);
+    ring->tid = g_nextTid++;
+    t_holder.ring = ring;
+    return ring;
+}
+
+void record(ThreadRing *ring, const TraceEvent& event) {
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->events[head & RING_MASK] = event;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void writeEscaped(std::FILE *file, const char *text) {
+    for (const char *p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') std::fputc('\\', file);
+        if (static_cast<unsigned char>(*p) >= 0x20) std::fputc(*p, file);
+    }
+}
+
+// %f follows the process locale, which Qt takes from the environment, and
+// JSON needs a '.': scaled is the value times 10^decimals
+void writeFixed(std::FILE *file, int64_t scaled, int decimals) {
+    int64_t divisor = 1;
+    for (int i = 0; i < decimals; ++i) divisor *= 10;
+    if (scaled < 0) {
+        std::fputc('-', file);
+        scaled = -scaled;
+    }
+    std::fprintf(file, "%lld", static_cast<long long>(scaled / divisor));
+    if (decimals > 0) {
+        std::fprintf(file, ".%0*lld", decimals, static_cast<long long>(scaled % divisor));
+    }
+}
+}
+
+int64_t Tracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const char *name) {
+    t_holder.name = name;
+    currentRing()->name.store(name, std::memory_order_relaxed);
+}
+
+void Tracer::complete(const char *name, int64_t startNs, int64_t endNs) {
+    record(currentRing(), TraceEvent{name, startNs, endNs - startNs, 0, 'X'});
+}
+
+void Tracer::instant(const char *name) {
+    record(currentRing(), TraceEvent{name, nowNs(), 0, 0, 'i'});
+}
+
+void Tracer::counter(const char *name, int64_t value) {
+    record(currentRing(), TraceEvent{name, nowNs(), value, 0, 'C'});
+}
+
+void Tracer::flow(const char *name, uint64_t id, bool begin) {
+    record(currentRing(), TraceEvent{name, nowNs(), 0, id, begin ? 's' : 'f'});
+}
+
+double Tracer::measureEventCostNs() {
+    // Same work as a TraceScope: two clock reads and one ring write
+    constexpr int ITERATIONS = 20000;
+    std::unique_ptr<ThreadRing> ring(new ThreadRing());
+    int64_t start = nowNs();
+    for (int i = 0; i < ITERATIONS; ++i) {
+        int64_t begin = nowNs();
+        record(ring.get(), TraceEvent{"calibration", begin, nowNs() - begin, 0, 'X'});
+    }
+    return double(nowNs() - start) / ITERATIONS;
+}
+
+bool Tracer::writeChromeJson(const char *path, int64_t windowNs, TraceDumpStats *stats) {
+    struct Snapshot {
+        int tid;
+        const char *name;
+        std::vector<TraceEvent> events;
+    };
+    std::vector<Snapshot> snapshots;
+    const int64_t now = nowNs();
+    const int64_t from = now - windowNs;
+    int64_t earliest = now;
+
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        for (ThreadRing *ring : g_rings) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+            std::vector<TraceEvent> copied;
+            copied.reserve(head - first);
+            for (uint64_t i = first; i < head; ++i) {
+                copied.push_back(ring->events[i & RING_MASK]);
+            }
+            // Entries the writer reached while we were copying are torn
+            uint64_t after = ring->head.load(std::memory_order_acquire);
+            uint64_t valid = after > RING_CAPACITY ? after - RING_CAPACITY : 0;
+            size_t skip = valid > first ? std::min<size_t>(valid - first, copied.size()) : 0;
+
+            Snapshot snapshot{ring->tid, ring->name.load(std::memory_order_relaxed), {}};
+            for (size_t i = skip; i < copied.size(); ++i) {
+                if (copied[i].timestampNs >= from) {
+                    earliest = std::min(earliest, copied[i].timestampNs);
+                    snapshot.events.push_back(copied[i]);
+                }
+            }
+            snapshots.push_back(std::move(snapshot));
+        }
+    }
+
+    TraceDumpStats result;
+    result.eventCostNs = measureEventCostNs();
+    for (const Snapshot& snapshot : snapshots) {
+        result.events += static_cast<int>(snapshot.events.size());
+        if (!snapshot.events.empty()) ++result.threads;
+    }
+    int64_t span = std::max<int64_t>(now - earliest, 1);
+    result.overheadPercent = 100.0 * result.events * result.eventCostNs / span;
+    if (stats) *stats = result;
+
+    std::FILE *file = std::fopen(path, "w");
+    if (!file) return false;
+
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    for (const Snapshot& snapshot : snapshots) {
+        if (snapshot.events.empty()) continue;
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                     first ? "" : ",\n", snapshot.tid);
+        writeEscaped(file, snapshot.name ? snapshot.name : "thread");
+        std::fputs("\"}}", file);
+        first = false;
+
+        for (const TraceEvent& event : snapshot.events) {
+            std::fputs(",\n{\"name\":\"", file);
+            writeEscaped(file, event.name);
+            std::fprintf(file, "\",\"ph\":\"%c\",\"ts\":", event.phase);
+            writeFixed(file, event.timestampNs, 3); // Microseconds
+            std::fprintf(file, ",\"pid\":1,\"tid\":%d", snapshot.tid);
+            switch (event.phase) {
+            case 'X':
+                std::fputs(",\"dur\":", file);
+                writeFixed(file, event.value, 3);
+                break;
+            case 'i':
+                std::fputs(",\"s\":\"t\"", file);
+                break;
+            case 'C':
+                std::fprintf(file, ",\"args\":{\"value\":%lld}", static_cast<long long>(event.value));
+                break;
+            case 's':
+            case 'f':
+                std::fprintf(file, ",\"cat\":\"flow\",\"id\":%llu%s",
+                             static_cast<unsigned long long>(event.id),
+                             event.phase == 'f' ? ",\"bp\":\"e\"" : "");
+                break;
+            }
+            std::fputc('}', file);
+        }
+    }
+    std::fputs("\n],\"otherData\":{\"eventCostNs\":\"", file);
+    writeFixed(file, std::llround(result.eventCostNs * 10.0), 1);
+    std::fputs("\",\"overheadPercent\":\"", file);
+    writeFixed(file, std::llround(result.overheadPercent * 1000.0), 3);
+    std::fputs("\"}}\n", file);
+    return std::fclose(file) == 0;
+}
+
+} // namespace morse
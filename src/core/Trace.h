@@ -0,0 +1,98 @@
+#ifndef MORSE_TRACE_H
+#define MORSE_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace morse {
+
+struct TraceEvent {
+    const char *name;    // String literal
+    int64_t timestampNs; // CLOCK_MONOTONIC
+    int64_t value;       // Duration for 'X', counter value for 'C'
+    uint64_t id;         // Flow id for 's'/'f'
+    char phase;          // Chrome trace phase: X, i, C, s, f
+};
+
+struct TraceDumpStats {
+    int events = 0;
+    int threads = 0;
+    double eventCostNs = 0.0;     // Measured cost of recording one event
+    double overheadPercent = 0.0; // Recording time over the window, as % of one core
+};
+
+// Pipeline trace points. Each thread records into its own fixed ring,
+// written without locks or allocation; a dump copies the rings and writes
+// the last window as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Recording is off until enabled at run time, and the MORSE_TRACE_* macros
+// compile to nothing unless MORSE_TRACING is defined.
+class Tracer {
+public:
+    static constexpr int RING_CAPACITY = 16384; // Events kept per thread
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    // Also creates the thread's ring, so the first traced event of a
+    // real-time thread does not allocate; call it before the hot loop
+    static void setThreadName(const char *name);
+
+    static void complete(const char *name, int64_t startNs, int64_t endNs);
+    static void instant(const char *name);
+    static void counter(const char *name, int64_t value);
+    static void flow(const char *name, uint64_t id, bool begin);
+
+    // Writes events newer than windowNs; false if the file cannot be written
+    static bool writeChromeJson(const char *path, int64_t windowNs, TraceDumpStats *stats = nullptr);
+    // Times a batch of recordings into a private ring
+    static double measureEventCostNs();
+
+    static int64_t nowNs();
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name)
+        , m_startNs(Tracer::isEnabled() ? Tracer::nowNs() : -1)
+    {
+    }
+    ~TraceScope() {
+        if (m_startNs >= 0) Tracer::complete(m_name, m_startNs, Tracer::nowNs());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *m_name;
+    int64_t m_startNs;
+};
+
+} // namespace morse
+
+#ifdef MORSE_TRACING
+#define MORSE_TRACE_CONCAT_(a, b) a##b
+#define MORSE_TRACE_CONCAT(a, b) MORSE_TRACE_CONCAT_(a, b)
+#define MORSE_TRACE_SCOPE(name) ::morse::TraceScope MORSE_TRACE_CONCAT(morseTraceScope, __LINE__)(name)
+#define MORSE_TRACE_INSTANT(name) \
+    do { if (::morse::Tracer::isEnabled()) ::morse::Tracer::instant(name); } while (0)
+#define MORSE_TRACE_COUNTER(name, value) \
+    do { if (::morse::Tracer::isEnabled()) ::morse::Tracer::counter(name, value); } while (0)
+#define MORSE_TRACE_FLOW_BEGIN(name, id) \
+    do { if (::morse::Tracer::isEnabled()) ::morse::Tracer::flow(name, id, true); } while (0)
+#define MORSE_TRACE_FLOW_END(name, id) \
+    do { if (::morse::Tracer::isEnabled()) ::morse::Tracer::flow(name, id, false); } while (0)
+#define MORSE_TRACE_THREAD_NAME(name) ::morse::Tracer::setThreadName(name)
+#else
+#define MORSE_TRACE_SCOPE(name) ((void)0)
+#define MORSE_TRACE_INSTANT(name) ((void)0)
+#define MORSE_TRACE_COUNTER(name, value) ((void)0)
+#define MORSE_TRACE_FLOW_BEGIN(name, id) ((void)0)
+#define MORSE_TRACE_FLOW_END(name, id) ((void)0)
+#define MORSE_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // MORSE_TRACE_H
@@ -0,0 +1,158 @@
+#include "WavReader.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace morse {
+
+namespace {
+constexpr uint16_t FORMAT_PCM = 1;
+constexpr uint16_t FORMAT_FLOAT = 3;
+constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+uint32_t getLe(const unsigned char *in, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= uint32_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+bool fail(std::string *error, const char *message) {
+    if (error) *error = message;
+    return false;
+}
+
+float decodeSample(const unsigned char *in, uint16_t format, int bits) {
+    if (format == FORMAT_FLOAT) {
+        float value;
+        std::memcpy(&value, in, sizeof(value));
+        return value;
+    }
+    switch (bits) {
+    case 8:
+        return (float(in[0]) - 128.0f) / 128.0f;
+    case 16:
+        return float(int16_t(getLe(in, 2))) / 32768.0f;
+    case 24:
+        return float(int32_t(getLe(in, 3) << 8) >> 8) / 8388608.0f;
+    default:
+        return float(int32_t(getLe(in, 4))) / 2147483648.0f;
+    }
+}
+}
+
+WavReader::~WavReader() {
+    close();
+}
+
+void WavReader::close() {
+    if (m_map) munmap(m_map, m_mapSize);
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_data = nullptr;
+    m_frames = 0;
+}
+
+bool WavReader::open(const char *path, std::string *error) {
+    close();
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return fail(error, "cannot open file");
+    struct stat info;
+    bool sized = fstat(fd, &info) == 0 && info.st_size >= 12;
+    void *map = sized ? mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (!sized) return fail(error, "not a RIFF/WAVE file");
+    if (map == MAP_FAILED) return fail(error, "cannot map file");
+    m_map = map;
+    m_mapSize = size_t(info.st_size);
+    madvise(m_map, m_mapSize, MADV_SEQUENTIAL);
+
+    const unsigned char *bytes = static_cast<const unsigned char *>(m_map);
+    if (std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+        close();
+        return fail(error, "not a RIFF/WAVE file");
+    }
+
+    uint16_t format = 0;
+    int channels = 0;
+    int bits = 0;
+    int sampleRate = 0;
+    const unsigned char *data = nullptr;
+    size_t dataBytes = 0;
+
+    size_t offset = 12;
+    while (offset + 8 <= m_mapSize) {
+        const unsigned char *chunk = bytes + offset;
+        size_t size = getLe(chunk + 4, 4);
+        size_t available = m_mapSize - offset - 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && available >= 16) {
+            format = uint16_t(getLe(chunk + 8, 2));
+            channels = int(getLe(chunk + 10, 2));
+            sampleRate = int(getLe(chunk + 12, 4));
+            bits = int(getLe(chunk + 22, 2));
+            if (format == FORMAT_EXTENSIBLE && size >= 40 && available >= 40) {
+                format = uint16_t(getLe(chunk + 32, 2)); // Sub-format GUID starts with the tag
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            // Recorders that were cut off leave the size unpatched
+            dataBytes = size <= available ? size : available;
+            break;
+        }
+        offset += 8 + size + (size & 1);
+    }
+
+    const char *problem = nullptr;
+    bool supported = (format == FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32))
+                     || (format == FORMAT_FLOAT && bits == 32);
+    if (!data) {
+        problem = "no data chunk";
+    } else if (channels <= 0 || sampleRate <= 0) {
+        problem = "missing or invalid fmt chunk";
+    } else if (!supported) {
+        problem = "unsupported sample format";
+    }
+    if (problem) {
+        close();
+        return fail(error, problem);
+    }
+
+    m_data = data;
+    m_format = format;
+    m_channels = channels;
+    m_bits = bits;
+    m_sampleRate = sampleRate;
+    m_frames = dataBytes / (size_t(bits / 8) * size_t(channels));
+    return true;
+}
+
+size_t WavReader::read(size_t first, size_t count, float *out) const {
+    if (first >= m_frames) return 0;
+    count = std::min(count, m_frames - first);
+
+    const size_t sampleBytes = size_t(m_bits / 8);
+    const size_t frameBytes = sampleBytes * size_t(m_channels);
+    const float scale = 1.0f / float(m_channels);
+    const unsigned char *in = m_data + first * frameBytes;
+    for (size_t frame = 0; frame < count; ++frame, in += frameBytes) {
+        float sum = 0.0f;
+        for (int channel = 0; channel < m_channels; ++channel) {
+            sum += decodeSample(in + channel * sampleBytes, m_format, m_bits);
+        }
+        out[frame] = sum * scale;
+    }
+
+    // The pages stay in the page cache; dropping them from the mapping
+    // keeps the resident size at about one block per reading thread
+    const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = (uintptr_t(m_data + first * frameBytes) + page - 1) & ~(page - 1);
+    uintptr_t end = uintptr_t(in) & ~(page - 1);
+    if (end > begin) madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+    return count;
+}
+
+} // namespace morse
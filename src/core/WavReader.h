@@ -0,0 +1,45 @@
+#ifndef MORSE_WAVREADER_H
+#define MORSE_WAVREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace morse {
+
+// Maps a WAV file and converts ranges of it to mono float samples in
+// [-1, 1] on request, so a long recording is never held in memory whole,
+// neither as bytes nor as floats. Accepts 8, 16, 24 and 32-bit PCM and
+// 32-bit float; channels are mixed down. read() may be called from
+// several threads at once.
+class WavReader {
+public:
+    WavReader() = default;
+    ~WavReader();
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+
+    bool open(const char *path, std::string *error = nullptr);
+    void close();
+
+    int sampleRate() const { return m_sampleRate; }
+    size_t frames() const { return m_frames; }
+
+    // Converts frames [first, first + count) into out; returns how many
+    // there were before the end of the data
+    size_t read(size_t first, size_t count, float *out) const;
+
+private:
+    void *m_map = nullptr;
+    size_t m_mapSize = 0;
+    const unsigned char *m_data = nullptr;
+    size_t m_frames = 0;
+    int m_sampleRate = 0;
+    int m_channels = 0;
+    int m_bits = 0;
+    uint16_t m_format = 0;
+};
+
+} // namespace morse
+
+#endif // MORSE_WAVREADER_H
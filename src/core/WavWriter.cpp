@@ -0,0 +1,67 @@
+#include "WavWriter.h"
+
+namespace morse {
+
+namespace {
+constexpr long HEADER_BYTES = 44;
+
+void putLe(unsigned char *out, uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+void fillHeader(unsigned char *header, int sampleRate, uint32_t dataBytes) {
+    const unsigned char tags[] = "RIFF....WAVEfmt ";
+    for (int i = 0; i < 16; ++i) header[i] = tags[i];
+    putLe(header + 4, 36 + dataBytes, 4);
+    putLe(header + 16, 16, 4);              // fmt chunk size
+    putLe(header + 20, 1, 2);               // PCM
+    putLe(header + 22, 1, 2);               // Mono
+    putLe(header + 24, uint32_t(sampleRate), 4);
+    putLe(header + 28, uint32_t(sampleRate) * 2, 4);
+    putLe(header + 32, 2, 2);               // Block align
+    putLe(header + 34, 16, 2);              // Bits per sample
+    header[36] = 'd'; header[37] = 'a'; header[38] = 't'; header[39] = 'a';
+    putLe(header + 40, dataBytes, 4);
+}
+}
+
+bool WavWriter::open(const char *path, int sampleRate) {
+    close();
+    m_file = std::fopen(path, "wb");
+    if (!m_file) return false;
+    m_dataBytes = 0;
+
+    unsigned char header[HEADER_BYTES];
+    fillHeader(header, sampleRate, 0);
+    if (std::fwrite(header, 1, HEADER_BYTES, m_file) != HEADER_BYTES) {
+        std::fclose(m_file);
+        m_file = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool WavWriter::write(const int16_t *samples, int frames) {
+    if (!m_file) return false;
+    // WAV is little endian, as are the platforms this runs on
+    size_t written = std::fwrite(samples, sizeof(int16_t), size_t(frames), m_file);
+    m_dataBytes += uint32_t(written * sizeof(int16_t));
+    return written == size_t(frames);
+}
+
+bool WavWriter::close() {
+    if (!m_file) return true;
+    bool ok = true;
+    unsigned char sizes[4];
+    putLe(sizes, 36 + m_dataBytes, 4);
+    ok = std::fseek(m_file, 4, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, m_file) == 4;
+    putLe(sizes, m_dataBytes, 4);
+    ok = ok && std::fseek(m_file, 40, SEEK_SET) == 0 && std::fwrite(sizes, 1, 4, m_file) == 4;
+    ok = std::fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    return ok;
+}
+
+} // namespace morse
@@ -0,0 +1,29 @@
+#ifndef MORSE_WAVWRITER_H
+#define MORSE_WAVWRITER_H
+
+#include <cstdint>
+#include <cstdio>
+
+namespace morse {
+
+// 16-bit mono PCM WAV file. The header sizes are patched on close().
+class WavWriter {
+public:
+    WavWriter() = default;
+    ~WavWriter() { close(); }
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator=(const WavWriter&) = delete;
+
+    bool open(const char *path, int sampleRate);
+    bool write(const int16_t *samples, int frames);
+    bool close();
+    bool isOpen() const { return m_file != nullptr; }
+
+private:
+    std::FILE *m_file = nullptr;
+    uint32_t m_dataBytes = 0;
+};
+
+} // namespace morse
+
+#endif // MORSE_WAVWRITER_H
@@ -0,0 +1,110 @@
+#include "WorkStealingPool.h"
+
+namespace morse {
+
+namespace {
+// Identifies the pool and deque of the worker running the current task
+thread_local const WorkStealingPool *t_pool = nullptr;
+thread_local int t_workerIndex = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : m_queued(0)
+    , m_pending(0)
+    , m_nextWorker(0)
+    , m_steals(0)
+    , m_stopping(false)
+{
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads <= 0) threads = 1;
+    }
+    for (int i = 0; i < threads; ++i) {
+        m_workers.emplace_back(new Worker());
+    }
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back(&WorkStealingPool::run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+
+    int index = t_pool == this ? t_workerIndex
+                               : static_cast<int>(m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size());
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+    m_queued.fetch_add(1, std::memory_order_release);
+
+    // Taking the sleep lock orders this against a worker about to sleep
+    { std::lock_guard<std::mutex> lock(m_sleepMutex); }
+    m_wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(m_sleepMutex);
+    m_idle.wait(lock, [this]() { return m_pending.load(std::memory_order_acquire) == 0; });
+}
+
+bool WorkStealingPool::popLocal(int index, Task& task) {
+    Worker& worker = *m_workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int index, Task& task) {
+    const size_t count = m_workers.size();
+    for (size_t offset = 1; offset < count; ++offset) {
+        Worker& victim = *m_workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int index) {
+    t_pool = this;
+    t_workerIndex = index;
+
+    for (;;) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                m_idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() {
+            return m_stopping || m_queued.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stopping && m_queued.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+} // namespace morse
@@ -0,0 +1,62 @@
+#ifndef MORSE_WORKSTEALINGPOOL_H
+#define MORSE_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace morse {
+
+// Thread pool with one task deque per worker. A worker runs its own newest
+// task first (tasks spawned from a task stay cache-warm on that core) and,
+// when it runs dry, steals the oldest task of another worker, which tends
+// to be the largest piece of remaining work.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(int threads = 0); // 0 = one per hardware thread
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Safe from any thread, including from inside a running task
+    void submit(Task task);
+    // Blocks until every submitted task, and every task they spawned, is done
+    void wait();
+
+    int threadCount() const { return static_cast<int>(m_threads.size()); }
+    uint64_t steals() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int index);
+    bool popLocal(int index, Task& task);
+    bool steal(int index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::atomic<size_t> m_queued;   // Tasks sitting in deques
+    std::atomic<size_t> m_pending;  // Tasks submitted but not finished
+    std::atomic<unsigned> m_nextWorker;
+    std::atomic<uint64_t> m_steals;
+    bool m_stopping;
+};
+
+} // namespace morse
+
+#endif // MORSE_WORKSTEALINGPOOL_H
@@ -1,8 +1,18 @@
 #include <QApplication>
+#include <QTimer>
+#include "HeadlessModes.h"
 #include "MainWindow.h"
+#include "StartupProfiler.h"
+#include "core/Trace.h"
 
 int main(int argc, char *argv[]) {
+    int exitCode = 0;
+    if (HeadlessModes::run(argc, argv, &exitCode)) return exitCode;
+
+    StartupProfiler::start();
+    MORSE_TRACE_THREAD_NAME("main");
     QApplication app(argc, argv);
+    StartupProfiler::mark("QApplication");
 
     app.setApplicationName("Morse Key Decoder");
     app.setApplicationVersion("1.0.0");
@@ -10,6 +20,12 @@ int main(int argc, char *argv[]) {
 
     MainWindow window;
     window.show();
+    StartupProfiler::mark("show");
+
+    QTimer::singleShot(0, []() {
+        StartupProfiler::mark("first event loop pass");
+        StartupProfiler::report();
+    });
 
     return app.exec();
 }
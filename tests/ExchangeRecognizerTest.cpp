@@ -0,0 +1,63 @@
+#include "core/ExchangeRecognizer.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+int g_failures = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAIL: %s\n", what);
+        ++g_failures;
+    }
+}
+
+void collect(const morse::ExchangeEvent& event, void *context) {
+    if (event.kind == morse::ExchangeEvent::Kind::Exchange) {
+        static_cast<std::vector<morse::ExchangeRecord> *>(context)->push_back(event.exchange);
+    }
+}
+
+std::vector<morse::ExchangeRecord> recognize(morse::ExchangeRecognizer& recognizer, const char *text) {
+    std::vector<morse::ExchangeRecord> exchanges;
+    recognizer.setCallback(&collect, &exchanges);
+    recognizer.reset();
+    for (const char *c = text; *c; ++c) recognizer.addCharacter(*c);
+    recognizer.addWordSpace();
+    recognizer.setCallback(nullptr, nullptr);
+    return exchanges;
+}
+}
+
+int main() {
+    morse::ExchangeRecognizer recognizer;
+    recognizer.addDefaultPatterns();
+    recognizer.compile();
+
+    for (const char *call : {"K1ABC", "9A1AA", "3DA0XX", "DL/K1ABC", "K1ABC/P", "DL/K1ABC/P", "KH6/W1AW/M"}) {
+        check(recognizer.isCallsign(call), call);
+    }
+    for (const char *word : {"599", "TEST", "K1ABC//P", "/K1ABC"}) {
+        check(!recognizer.isCallsign(word), word);
+    }
+
+    // A numeric delimiter closes the exchange without becoming its serial
+    std::vector<morse::ExchangeRecord> exchanges = recognize(recognizer, "DL/K1ABC/P 579 001 73");
+    check(exchanges.size() == 1, "one exchange closed by 73");
+    if (exchanges.size() == 1) {
+        const morse::ExchangeRecord& exchange = exchanges[0];
+        check(std::strcmp(exchange.callsign, "DL/K1ABC/P") == 0, "callsign with prefix and suffix");
+        check(exchange.rst == 579, "rst 579");
+        check(exchange.serial == 1, "serial 001 kept");
+        check(exchange.delimiter >= 0 && recognizer.patternText(exchange.delimiter) == "73", "closed by 73");
+    }
+
+    exchanges = recognize(recognizer, "KH6/W1AW/M 5NN 123 TU");
+    check(exchanges.size() == 1 && std::strcmp(exchanges[0].callsign, "KH6/W1AW/M") == 0
+              && exchanges[0].rst == 599 && exchanges[0].serial == 123,
+          "cut-number exchange with prefixed portable call");
+
+    if (g_failures == 0) std::puts("PASS");
+    return g_failures == 0 ? 0 : 1;
+}